@@ -0,0 +1,153 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__DYNAMIC_MESSAGE_HPP_
+#define DYNMSG__DYNAMIC_MESSAGE_HPP_
+
+#include <cstdint>
+
+#include "rcutils/allocator.h"
+
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+/// A ROS message that owns its binary buffer.
+/**
+ * The buffer is allocated with the given allocator and initialized according to the message type
+ * when the message is created, and finalized and deallocated when it is destroyed. Messages can be
+ * moved, e.g. into queues or containers, without copying their content, but cannot be copied.
+ *
+ * Any rcutils allocator can be used, e.g. one that takes its memory from a pool. The allocator and
+ * its state must outlive the message.
+ *
+ * Use dynmsg::c::DynamicMessage and dynmsg::cpp::DynamicMessage rather than this template directly.
+ */
+template<typename RosMessageT, typename TypeInfoT>
+class BasicDynamicMessage
+{
+public:
+  /// Create an empty message, which does not own any buffer.
+  BasicDynamicMessage() noexcept;
+
+  /// Create and initialize a message of the given type.
+  /**
+   * \throws std::runtime_error if type_info is null
+   * \throws std::bad_alloc if the buffer cannot be allocated
+   */
+  explicit BasicDynamicMessage(
+    const TypeInfoT * type_info,
+    rcutils_allocator_t allocator = rcutils_get_default_allocator());
+
+  /// Load the introspection information of the given type and create a message of that type.
+  /**
+   * \throws std::runtime_error if the introspection information cannot be loaded
+   * \throws std::bad_alloc if the buffer cannot be allocated
+   */
+  explicit BasicDynamicMessage(
+    const InterfaceTypeName & interface_type,
+    rcutils_allocator_t allocator = rcutils_get_default_allocator());
+
+  BasicDynamicMessage(const BasicDynamicMessage &) = delete;
+  BasicDynamicMessage & operator=(const BasicDynamicMessage &) = delete;
+
+  BasicDynamicMessage(BasicDynamicMessage && other) noexcept;
+  BasicDynamicMessage & operator=(BasicDynamicMessage && other) noexcept;
+
+  ~BasicDynamicMessage();
+
+  /// Take ownership of an initialized message whose buffer was allocated with the given allocator.
+  /**
+   * This is the counterpart of release(), and can be used with messages initialized using
+   * ros_message_with_typeinfo_init().
+   */
+  static BasicDynamicMessage adopt(
+    RosMessageT message,
+    rcutils_allocator_t allocator = rcutils_get_default_allocator()) noexcept;
+
+  /// Get a non-owning view of the message, to pass to the other dynmsg functions.
+  const RosMessageT & get() const noexcept
+  {
+    return message_;
+  }
+
+  /// Get the introspection information of the message, or null if it is empty.
+  const TypeInfoT * type_info() const noexcept
+  {
+    return message_.type_info;
+  }
+
+  /// Get the binary buffer of the message, or null if it is empty.
+  uint8_t * data() const noexcept
+  {
+    return message_.data;
+  }
+
+  /// Get the allocator used for the buffer of the message.
+  const rcutils_allocator_t & allocator() const noexcept
+  {
+    return allocator_;
+  }
+
+  /// Check if the message owns a buffer.
+  explicit operator bool() const noexcept
+  {
+    return nullptr != message_.data;
+  }
+
+  /// Give up ownership of the buffer, leaving this message empty.
+  /**
+   * The caller becomes responsible for destroying the returned message using
+   * ros_message_destroy_with_allocator() with the allocator of this message.
+   */
+  RosMessageT release() noexcept;
+
+  /// Destroy the message, if any, leaving this message empty.
+  void reset() noexcept;
+
+private:
+  RosMessageT message_;
+  rcutils_allocator_t allocator_;
+};
+
+namespace c
+{
+
+/// A C ROS message that owns its binary buffer.
+/**
+ * \see dynmsg::BasicDynamicMessage
+ */
+using DynamicMessage = BasicDynamicMessage<RosMessage, TypeInfo>;
+
+}  // namespace c
+
+namespace cpp
+{
+
+/// A C++ ROS message that owns its binary buffer.
+/**
+ * \see dynmsg::BasicDynamicMessage
+ */
+using DynamicMessage = BasicDynamicMessage<RosMessage_Cpp, TypeInfo_Cpp>;
+
+}  // namespace cpp
+
+// The implementation is only instantiated for the C and C++ messages, in dynamic_message.cpp
+extern template class BasicDynamicMessage<RosMessage, TypeInfo>;
+extern template class BasicDynamicMessage<RosMessage_Cpp, TypeInfo_Cpp>;
+
+}  // namespace dynmsg
+
+#endif  // DYNMSG__DYNAMIC_MESSAGE_HPP_
@@ -0,0 +1,117 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__MEMBER_UTILS_HPP_
+#define DYNMSG__MEMBER_UTILS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+/// Check if a type is a primitive type, i.e. not a string, a wstring, or a nested message.
+/**
+ * Values of primitive types do not own any memory and can be copied with memcpy().
+ * The type IDs are the same for the C and C++ introspection type supports.
+ */
+bool is_primitive_type(uint8_t type_id);
+
+namespace c
+{
+
+/// Get the nested message introspection information of a member of type ROS_TYPE_MESSAGE.
+const TypeInfo * get_nested_type_info(const MemberInfo & member);
+
+/// Check if a member is a sequence (bounded or unbounded) rather than a fixed-size array.
+bool is_sequence(const MemberInfo & member);
+
+/// Get the size of a single element of a member, i.e. the size of its type in the C layout.
+size_t get_element_size(const MemberInfo & member);
+
+/// Get the number of elements of a member.
+/**
+ * This is the current size for sequences, the fixed size for arrays, and 1 for all other members.
+ */
+size_t get_element_count(const MemberInfo & member, const uint8_t * member_data);
+
+/// Get the number of elements a member has allocated space for.
+/**
+ * This is the allocated capacity for sequences, and the same as get_element_count() otherwise.
+ */
+size_t get_element_capacity(const MemberInfo & member, const uint8_t * member_data);
+
+/// Get a pointer to the first element of a member.
+/**
+ * For sequences, this is the sequence's data buffer, which may be null if the sequence is empty.
+ * For arrays and single values, this is the member data itself.
+ */
+const uint8_t * get_element_data(const MemberInfo & member, const uint8_t * member_data);
+
+/// Resize a sequence member and get a pointer to its first element.
+/**
+ * If the size changes, the sequence is reinitialized using the rosidl_runtime_c functions, which
+ * resets all of its elements. The returned pointer may be null if the new size is 0.
+ *
+ * \throws std::runtime_error if the sequence cannot be allocated
+ */
+uint8_t * resize_sequence(const MemberInfo & member, uint8_t * member_data, size_t size);
+
+}  // namespace c
+
+namespace cpp
+{
+
+/// C++ version of dynmsg::c::get_nested_type_info().
+const TypeInfo_Cpp * get_nested_type_info(const MemberInfo_Cpp & member);
+
+/// C++ version of dynmsg::c::is_sequence().
+bool is_sequence(const MemberInfo_Cpp & member);
+
+/// C++ version of dynmsg::c::get_element_size().
+size_t get_element_size(const MemberInfo_Cpp & member);
+
+/// C++ version of dynmsg::c::get_element_count().
+/**
+ * This also works for std::vector<bool> sequences.
+ */
+size_t get_element_count(const MemberInfo_Cpp & member, const uint8_t * member_data);
+
+/// C++ version of dynmsg::c::get_element_capacity().
+/**
+ * For std::vector<bool> sequences, this is the capacity in bits.
+ */
+size_t get_element_capacity(const MemberInfo_Cpp & member, const uint8_t * member_data);
+
+/// C++ version of dynmsg::c::get_element_data().
+/**
+ * Note that std::vector<bool> does not store its elements contiguously, so this returns nullptr
+ * for boolean sequences. Use the std::vector<bool> directly instead.
+ */
+const uint8_t * get_element_data(const MemberInfo_Cpp & member, const uint8_t * member_data);
+
+/// C++ version of dynmsg::c::resize_sequence().
+/**
+ * Unlike the C version, the existing elements are kept, as with std::vector::resize().
+ * Like get_element_data(), this returns nullptr for boolean sequences.
+ */
+uint8_t * resize_sequence(const MemberInfo_Cpp & member, uint8_t * member_data, size_t size);
+
+}  // namespace cpp
+
+}  // namespace dynmsg
+
+#endif  // DYNMSG__MEMBER_UTILS_HPP_
@@ -0,0 +1,135 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__MEMORY_TRACKING_HPP_
+#define DYNMSG__MEMORY_TRACKING_HPP_
+
+#include <atomic>
+#include <cstddef>
+
+#include "rcutils/macros.h"
+
+namespace dynmsg
+{
+
+/// Tracking of the memory used by each conversion between messages and YAML.
+/**
+ * Converting a large message can use much more memory than the message itself, mostly for the
+ * tree of YAML nodes. While tracking is enabled, each conversion to YAML or from YAML records the
+ * peak of the bytes it allocated and had not freed yet, which the calling thread can get after the
+ * conversion with get_last_conversion_memory(), e.g. to check it against a memory budget.
+ *
+ * dynmsg cannot observe the allocations of the process itself: the program has to report them,
+ * with their sizes, by calling record_allocation() and record_deallocation() from its allocation
+ * functions, e.g. from replacements of malloc() and free(), or of the global operator new and
+ * operator delete. Only the allocations made by a thread while it is converting a message count
+ * towards that conversion.
+ */
+namespace memory_tracking
+{
+
+/// Memory used by a conversion.
+struct ConversionMemory
+{
+  /// Largest number of bytes that were allocated by the conversion and not freed at the same time.
+  /**
+   * Memory allocated before the conversion and freed by it, e.g. the previous content of a message
+   * that is parsed into, does not lower the peak below zero.
+   */
+  size_t peak_bytes;
+  /// Number of bytes allocated by the conversion, whether they were freed or not.
+  size_t allocated_bytes;
+  /// Number of allocations made by the conversion.
+  size_t allocations;
+};
+
+/// Enable or disable tracking the memory used by the conversions.
+/**
+ * Tracking is disabled by default.
+ */
+void set_enabled(bool enabled);
+
+/// Check if the memory used by the conversions is tracked.
+bool is_enabled();
+
+/// Get the memory used by the last conversion made by the calling thread while tracking.
+/**
+ * Conversions of messages nested in the converted message are part of its conversion.
+ *
+ * \return the memory used by the conversion, or zeros if the thread did not convert any message
+ *   while tracking, since it last called reset_last_conversion_memory()
+ */
+ConversionMemory get_last_conversion_memory();
+
+/// Reset the memory used by the last conversion of the calling thread to zeros.
+void reset_last_conversion_memory();
+
+/// Record an allocation made by the calling thread.
+/**
+ * This is meant to be called by the allocation functions of the program. It does not allocate, and
+ * only updates counters of the calling thread, so it is safe to call from any allocation function.
+ *
+ * \param bytes the size of the allocated block
+ */
+void record_allocation(size_t bytes) noexcept;
+
+/// Record a deallocation made by the calling thread.
+/**
+ * \param bytes the size of the freed block, which should be the size recorded for its allocation
+ * \see record_allocation()
+ */
+void record_deallocation(size_t bytes) noexcept;
+
+namespace impl
+{
+
+extern std::atomic<bool> enabled;
+
+// Tracks the memory used by a conversion, from its construction to its destruction. Only the
+// outermost conversion of each thread is tracked, as nested messages are part of it.
+class ConversionScope
+{
+public:
+  ConversionScope()
+  : entered_(RCUTILS_UNLIKELY(enabled.load(std::memory_order_relaxed)))
+  {
+    if (entered_) {
+      enter();
+    }
+  }
+
+  ~ConversionScope()
+  {
+    if (entered_) {
+      exit();
+    }
+  }
+
+  ConversionScope(const ConversionScope &) = delete;
+  ConversionScope & operator=(const ConversionScope &) = delete;
+
+private:
+  static void enter();
+  static void exit();
+
+  const bool entered_;
+};
+
+}  // namespace impl
+
+}  // namespace memory_tracking
+
+}  // namespace dynmsg
+
+#endif  // DYNMSG__MEMORY_TRACKING_HPP_
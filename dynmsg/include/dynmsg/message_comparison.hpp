@@ -0,0 +1,106 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__MESSAGE_COMPARISON_HPP_
+#define DYNMSG__MESSAGE_COMPARISON_HPP_
+
+#include <yaml-cpp/yaml.h>
+
+#include <string>
+#include <vector>
+
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+/// Options for comparing two ROS messages.
+struct ComparisonOptions
+{
+  /// Maximum absolute difference for two float/double/long double values to be considered equal.
+  /**
+   * With the default tolerance of 0, floating point values are compared bitwise, which means that
+   * two NaN values with the same representation are equal, but 0.0 and -0.0 are not.
+   */
+  double float_tolerance = 0.0;
+};
+
+/// A field that differs between two ROS messages.
+struct FieldDifference
+{
+  /// Path of the field in the message, e.g. "header.stamp.sec" or "points[2].x".
+  std::string path;
+  /// YAML representation of the value in the first message; null if it does not exist there.
+  YAML::Node old_value;
+  /// YAML representation of the value in the second message; null if it does not exist there.
+  YAML::Node new_value;
+};
+
+namespace c
+{
+
+/// Check if two ROS messages of the same type have the same content.
+/**
+ * The messages are compared directly in their binary representation using the introspection
+ * information, without converting them to YAML. The comparison stops at the first mismatch, and
+ * runs of contiguous primitive fields are compared with a single memcmp().
+ *
+ * Messages with different introspection information are never equal.
+ */
+bool equals(
+  const RosMessage & a,
+  const RosMessage & b,
+  const ComparisonOptions & options = ComparisonOptions());
+
+/// Get the list of fields that differ between two ROS messages of the same type.
+/**
+ * Differing elements of arrays and of sequences of the same size are reported individually, e.g.
+ * "data[3]". Sequences of different sizes are reported as a whole. The values are given in the same
+ * YAML representation as dynmsg::c::message_to_yaml().
+ *
+ * \throws std::runtime_error if the messages do not have the same introspection information
+ */
+std::vector<FieldDifference> diff(
+  const RosMessage & a,
+  const RosMessage & b,
+  const ComparisonOptions & options = ComparisonOptions());
+
+}  // namespace c
+
+namespace cpp
+{
+
+/// C++ version of dynmsg::c::equals().
+/**
+ * \see dynmsg::c::equals()
+ */
+bool equals(
+  const RosMessage_Cpp & a,
+  const RosMessage_Cpp & b,
+  const ComparisonOptions & options = ComparisonOptions());
+
+/// C++ version of dynmsg::c::diff().
+/**
+ * \see dynmsg::c::diff()
+ */
+std::vector<FieldDifference> diff(
+  const RosMessage_Cpp & a,
+  const RosMessage_Cpp & b,
+  const ComparisonOptions & options = ComparisonOptions());
+
+}  // namespace cpp
+
+}  // namespace dynmsg
+
+#endif  // DYNMSG__MESSAGE_COMPARISON_HPP_
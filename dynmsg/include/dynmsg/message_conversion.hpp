@@ -0,0 +1,100 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__MESSAGE_CONVERSION_HPP_
+#define DYNMSG__MESSAGE_CONVERSION_HPP_
+
+#include <memory>
+
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+namespace impl
+{
+struct ConversionPlan;
+}  // namespace impl
+
+/// Converter between the C and C++ representations of messages of a single ROS type.
+/**
+ * The introspection information of both representations is matched once, when the converter is
+ * created. Converting a message then copies the values directly from one binary representation to
+ * the other, without going through YAML: runs of primitive members that have the same layout in
+ * C and C++ are copied as a single block, primitive sequences are copied in bulk, and wstrings are
+ * copied as UTF-16 without transcoding.
+ *
+ * A converter is immutable once created, so it can be shared between threads.
+ */
+class MessageConverter
+{
+public:
+  /// Create a converter for the given C and C++ introspection information.
+  /**
+   * \throws std::runtime_error if the C and C++ introspection information do not describe the
+   *   same message type
+   */
+  MessageConverter(const TypeInfo * type_info, const TypeInfo_Cpp * type_info_cpp);
+
+  /// Get the C introspection information of the converted type.
+  const TypeInfo * type_info() const;
+
+  /// Get the C++ introspection information of the converted type.
+  const TypeInfo_Cpp * type_info_cpp() const;
+
+  /// Copy the content of a C message into a C++ message.
+  /**
+   * Both messages must be initialized, e.g. using dynmsg::c::ros_message_with_typeinfo_init() and
+   * dynmsg::cpp::ros_message_with_typeinfo_init(). The previous content of the C++ message is
+   * replaced.
+   *
+   * \throws std::runtime_error if the messages are not of the type of this converter
+   */
+  void c_to_cpp(const RosMessage & from, RosMessage_Cpp & to) const;
+
+  /// Copy the content of a C++ message into a C message.
+  /**
+   * Both messages must be initialized. The previous content of the C message is replaced, and its
+   * sequences and strings are reallocated using the rosidl_runtime_c functions as needed.
+   *
+   * \throws std::runtime_error if the messages are not of the type of this converter, or if
+   *   allocating memory for the C message fails
+   */
+  void cpp_to_c(const RosMessage_Cpp & from, RosMessage & to) const;
+
+private:
+  std::shared_ptr<const impl::ConversionPlan> plan_;
+};
+
+/// Copy the content of a C message into a C++ message of the same type.
+/**
+ * This creates a temporary dynmsg::MessageConverter; create one and reuse it instead when
+ * converting several messages of the same type.
+ *
+ * \see dynmsg::MessageConverter::c_to_cpp()
+ */
+void c_to_cpp(const RosMessage & from, RosMessage_Cpp & to);
+
+/// Copy the content of a C++ message into a C message of the same type.
+/**
+ * This creates a temporary dynmsg::MessageConverter; create one and reuse it instead when
+ * converting several messages of the same type.
+ *
+ * \see dynmsg::MessageConverter::cpp_to_c()
+ */
+void cpp_to_c(const RosMessage_Cpp & from, RosMessage & to);
+
+}  // namespace dynmsg
+
+#endif  // DYNMSG__MESSAGE_CONVERSION_HPP_
@@ -0,0 +1,87 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__MESSAGE_GENERATION_HPP_
+#define DYNMSG__MESSAGE_GENERATION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+/// Options for generating the content of ROS messages.
+struct GenerationOptions
+{
+  /// Seed of the generated content.
+  /**
+   * The same seed always gives the same content for the same message type, on any platform.
+   */
+  uint64_t seed = 0;
+  /// Range of the lengths of sequences.
+  /**
+   * The length of each sequence is drawn from this range, which is limited by the bound of bounded
+   * sequences.
+   */
+  size_t min_sequence_length = 0;
+  size_t max_sequence_length = 8;
+  /// Range of the lengths of strings and wstrings, limited by the bound of bounded strings.
+  size_t min_string_length = 0;
+  size_t max_string_length = 16;
+};
+
+namespace c
+{
+
+/// Fill a ROS message with deterministic random content.
+/**
+ * Every field of the message and of its nested messages is given a pseudo-random value, and every
+ * sequence a pseudo-random length, within the bounds of the message type.
+ *
+ * The values are chosen so that messages survive conversions exactly: floating point values are
+ * multiples of 1/256 that are exactly representable as float, chars are ASCII, strings are made of
+ * printable ASCII characters, and wstrings of characters of the Basic Multilingual Plane that are
+ * not surrogates or control characters.
+ *
+ * The C and C++ versions draw the values in the same order, so a C message and a C++ message of
+ * the same type generated with the same options have the same content.
+ *
+ * \param message the message to fill, which must be initialized; its previous content is replaced
+ * \param options the seed and the lengths of the generated content
+ * \throws std::runtime_error if allocating memory for the message content fails
+ */
+void generate_message(
+  RosMessage & message,
+  const GenerationOptions & options = GenerationOptions());
+
+}  // namespace c
+
+namespace cpp
+{
+
+/// C++ version of dynmsg::c::generate_message().
+/**
+ * \see dynmsg::c::generate_message()
+ */
+void generate_message(
+  RosMessage_Cpp & message,
+  const GenerationOptions & options = GenerationOptions());
+
+}  // namespace cpp
+
+}  // namespace dynmsg
+
+#endif  // DYNMSG__MESSAGE_GENERATION_HPP_
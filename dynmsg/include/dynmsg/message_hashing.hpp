@@ -0,0 +1,93 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__MESSAGE_HASHING_HPP_
+#define DYNMSG__MESSAGE_HASHING_HPP_
+
+#include <cstdint>
+
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+/// A 128-bit hash value.
+struct Hash128
+{
+  uint64_t low;
+  uint64_t high;
+};
+
+inline bool operator==(const Hash128 & a, const Hash128 & b)
+{
+  return a.low == b.low && a.high == b.high;
+}
+
+inline bool operator!=(const Hash128 & a, const Hash128 & b)
+{
+  return !(a == b);
+}
+
+namespace c
+{
+
+/// Compute a 64-bit hash of the content of a ROS message.
+/**
+ * The message content is hashed using XXH64, directly from its binary representation and without
+ * converting it to YAML. Contiguous primitive fields and the payloads of strings and primitive
+ * sequences are each fed to the hash function in a single block.
+ *
+ * The hash only depends on the logical content of the message: a C message and a C++ message of
+ * the same type with the same content have the same hash, see dynmsg::cpp::hash_message(). The
+ * hash is also stable across processes and runs on machines with the same byte order, so it can be
+ * used as a cache key. Note that floating point values are hashed bitwise, and long double values
+ * are hashed as double values.
+ *
+ * \param message the message to hash
+ * \param seed the seed of the hash function
+ * \return the 64-bit hash of the message
+ */
+uint64_t hash_message(const RosMessage & message, uint64_t seed = 0u);
+
+/// Compute a 128-bit hash of the content of a ROS message.
+/**
+ * This is made of two 64-bit hashes with different seeds, computed in a single pass over the
+ * message, which makes collisions much less likely.
+ *
+ * \see dynmsg::c::hash_message()
+ */
+Hash128 hash_message_128(const RosMessage & message, uint64_t seed = 0u);
+
+}  // namespace c
+
+namespace cpp
+{
+
+/// C++ version of dynmsg::c::hash_message().
+/**
+ * \see dynmsg::c::hash_message()
+ */
+uint64_t hash_message(const RosMessage_Cpp & message, uint64_t seed = 0u);
+
+/// C++ version of dynmsg::c::hash_message_128().
+/**
+ * \see dynmsg::c::hash_message_128()
+ */
+Hash128 hash_message_128(const RosMessage_Cpp & message, uint64_t seed = 0u);
+
+}  // namespace cpp
+
+}  // namespace dynmsg
+
+#endif  // DYNMSG__MESSAGE_HASHING_HPP_
@@ -0,0 +1,117 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__MESSAGE_SIZE_HPP_
+#define DYNMSG__MESSAGE_SIZE_HPP_
+
+#include <cstddef>
+
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+/// Size of the encapsulation header at the start of a CDR-serialized message.
+constexpr size_t CDR_ENCAPSULATION_SIZE = 4u;
+
+/// Information about the serialized size of all messages of a given type.
+struct SerializedSizeInfo
+{
+  /// Whether all messages of the type have the same serialized size.
+  /**
+   * This is the case for types that do not contain strings or sequences, even nested ones.
+   * The serialized size is then max_size.
+   */
+  bool is_fixed;
+  /// Whether the serialized size of messages of the type is bounded.
+  /**
+   * This is the case for types that only contain bounded strings and bounded sequences.
+   */
+  bool is_bounded;
+  /// Maximum serialized size of messages of the type, including the encapsulation header.
+  /**
+   * This is 0 if the type is not bounded.
+   */
+  size_t max_size;
+};
+
+namespace c
+{
+
+/// Get the exact CDR-serialized size of a ROS message, without serializing it.
+/**
+ * This is the size of the serialized message as produced by the rmw implementations using CDR, like
+ * rmw_serialize(), including the encapsulation header, and can be used to allocate output buffers.
+ *
+ * This traverses the message, but not the elements of primitive arrays and sequences. For message
+ * types with a fixed size, see get_serialized_size_info(), which only needs to be called once.
+ *
+ * \param message the message
+ * \return the serialized size, in bytes
+ */
+size_t serialized_size(const RosMessage & message);
+
+/// Get the number of bytes of heap memory owned by a ROS message, including nested ones.
+/**
+ * This counts the allocated capacity of all strings and sequences in the message and in its nested
+ * messages. The storage of the message itself (see TypeInfo::size_of_) is not included.
+ *
+ * \param message the message
+ * \return the deep heap footprint of the message, in bytes
+ */
+size_t heap_bytes(const RosMessage & message);
+
+/// Get information about the serialized size of all messages of a given type.
+/**
+ * The result only depends on the type, so it can be computed once, e.g. to size output buffers
+ * up front for fixed-size and bounded types and skip calling serialized_size() for each message.
+ *
+ * \param type_info the introspection information of the message type
+ * \return the serialized size information of the type
+ */
+SerializedSizeInfo get_serialized_size_info(const TypeInfo * type_info);
+
+}  // namespace c
+
+namespace cpp
+{
+
+/// C++ version of dynmsg::c::serialized_size().
+/**
+ * \see dynmsg::c::serialized_size()
+ */
+size_t serialized_size(const RosMessage_Cpp & message);
+
+/// C++ version of dynmsg::c::heap_bytes().
+/**
+ * This assumes that std::string only allocates memory when its content does not fit in its short
+ * string buffer, as is the case with libstdc++ and libc++.
+ *
+ * \see dynmsg::c::heap_bytes()
+ */
+size_t heap_bytes(const RosMessage_Cpp & message);
+
+/// C++ version of dynmsg::c::get_serialized_size_info().
+/**
+ * This gives the same result as dynmsg::c::get_serialized_size_info() for the same type.
+ *
+ * \see dynmsg::c::get_serialized_size_info()
+ */
+SerializedSizeInfo get_serialized_size_info(const TypeInfo_Cpp * type_info);
+
+}  // namespace cpp
+
+}  // namespace dynmsg
+
+#endif  // DYNMSG__MESSAGE_SIZE_HPP_
@@ -0,0 +1,243 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__METRICS_HPP_
+#define DYNMSG__METRICS_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rcutils/macros.h"
+
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+/// Metrics of the conversions between messages and YAML, for monitoring.
+/**
+ * When enabled, each conversion of a message to YAML or from YAML is counted for its type, with the
+ * bytes it consumed and produced, its errors, and its latency. Conversions of messages nested in
+ * the converted message are part of its conversion, and are not counted separately.
+ *
+ * Recording is cheap enough to stay enabled in production: the counters are sharded by thread, so
+ * that threads converting messages of the same type do not contend, and each conversion reads the
+ * clock twice. When metrics are disabled, a conversion only checks a flag.
+ *
+ * Metrics are taken with get_snapshot() and can be exported with to_prometheus_text() or
+ * to_json(), e.g. to be published on an endpoint of the program.
+ */
+namespace metrics
+{
+
+/// A conversion API.
+enum class Operation
+{
+  /// dynmsg::c::message_to_yaml()
+  c_to_yaml,
+  /// dynmsg::cpp::message_to_yaml()
+  cpp_to_yaml,
+  /// dynmsg::c::yaml_and_typeinfo_to_rosmsg() and dynmsg::c::yaml_to_rosmsg()
+  c_from_yaml,
+  /// dynmsg::cpp::yaml_and_typeinfo_to_rosmsg() and dynmsg::cpp::yaml_to_rosmsg()
+  cpp_from_yaml,
+};
+
+/// Kinds of conversion errors.
+enum class ErrorKind
+{
+  /// The YAML could not be parsed, or a value did not have the type of its member.
+  yaml,
+  /// The conversion failed otherwise, e.g. a sequence was longer than the bound of its member.
+  conversion,
+  /// The message could not be initialized.
+  initialization,
+};
+
+/// Number of kinds of errors.
+constexpr size_t ERROR_KIND_COUNT = 3u;
+
+/// Get the name of an operation, e.g. "c.to_yaml".
+const char * get_operation_name(Operation operation);
+
+/// Get the name of a kind of error, e.g. "yaml".
+const char * get_error_kind_name(ErrorKind kind);
+
+/// Distribution of latencies.
+/**
+ * Latencies are counted in buckets whose widths grow with their bounds: each power of two is split
+ * in four buckets of equal width, so a bucket is at most 25% wider than its lower bound.
+ */
+struct LatencyHistogram
+{
+  /// The buckets that counted at least one latency, in increasing order, as pairs of the
+  /// largest latency of the bucket in nanoseconds, and the number of latencies counted in it.
+  std::vector<std::pair<uint64_t, uint64_t>> buckets;
+  /// Number of latencies counted.
+  uint64_t count;
+  /// Sum of the latencies counted, in nanoseconds.
+  uint64_t sum_ns;
+};
+
+/// Metrics of the conversions of one type through one API.
+struct SeriesSnapshot
+{
+  Operation operation;
+  /// The type, e.g. "std_msgs/msg/Header".
+  std::string type;
+  /// Number of messages converted successfully.
+  uint64_t messages;
+  /// Number of bytes converted: of YAML text parsed for conversions from YAML, and of the
+  /// CDR-serialized messages (see dynmsg::c::serialized_size()) for conversions to YAML.
+  uint64_t bytes_in;
+  /// Number of bytes produced: of the CDR-serialized messages for successful conversions from YAML,
+  /// and 0 for conversions to YAML, which produce YAML nodes rather than text.
+  uint64_t bytes_out;
+  /// Number of failed conversions, by kind of error; see ErrorKind.
+  std::array<uint64_t, ERROR_KIND_COUNT> errors;
+  /// Latencies of the conversions, successful or not.
+  LatencyHistogram latency;
+};
+
+/// Metrics of all the conversions so far.
+struct Snapshot
+{
+  /// Metrics of each type and API that was used, sorted by type then API.
+  std::vector<SeriesSnapshot> series;
+};
+
+/// Enable or disable recording the metrics of the conversions.
+/**
+ * Metrics are disabled by default. Metrics recorded so far are kept when disabling.
+ */
+void set_enabled(bool enabled);
+
+/// Check if the metrics of the conversions are recorded.
+bool is_enabled();
+
+/// Get the metrics recorded so far.
+/**
+ * This can be called at any time, from any thread. Conversions in progress are not included.
+ */
+Snapshot get_snapshot();
+
+/// Reset all the metrics to zero.
+void reset();
+
+/// Get metrics in the Prometheus text exposition format.
+/**
+ * The metrics are dynmsg_messages_total, dynmsg_bytes_in_total, dynmsg_bytes_out_total,
+ * dynmsg_errors_total, and the histogram dynmsg_conversion_latency_seconds, labelled with the
+ * operation and the type, and the kind of error for errors. The histogram has the same cumulative
+ * buckets in every export: one for each power of two from 2^8 nanoseconds to 2^37 nanoseconds
+ * (about 137 seconds), counting the latencies below it, and the +Inf bucket.
+ */
+std::string to_prometheus_text(const Snapshot & snapshot);
+
+/// Get metrics as a JSON document.
+/**
+ * The document is an object with a "series" array holding an object for each SeriesSnapshot, with
+ * the same members; "errors" is an object with a member for each kind of error, and the latency
+ * buckets are [largest latency in nanoseconds, count] arrays.
+ */
+std::string to_json(const Snapshot & snapshot);
+
+namespace impl
+{
+
+extern std::atomic<bool> enabled;
+
+class Series;
+
+// Records the metrics of a conversion, from its construction to its destruction. Conversions that
+// fail, including with an exception, must be marked as failed before the scope ends.
+class ConversionScope
+{
+public:
+  ConversionScope(
+    Operation operation,
+    const void * type_info,
+    const char * type_namespace,
+    const char * type_name,
+    size_t bytes_in = 0u)
+  : entered_(RCUTILS_UNLIKELY(enabled.load(std::memory_order_relaxed)))
+  {
+    if (entered_) {
+      start(operation, type_info, type_namespace, type_name, bytes_in);
+    }
+  }
+
+  ~ConversionScope()
+  {
+    if (entered_) {
+      finish();
+    }
+  }
+
+  // Count the serialized size of the converted message, in the bytes in of a conversion to YAML or
+  // the bytes out of a conversion from YAML. It is computed once the latency of the conversion is
+  // measured, so the message must outlive the scope.
+  void count_message(const RosMessage & message)
+  {
+    if (nullptr != series_) {
+      c_message_ = message;
+    }
+  }
+
+  void count_message(const RosMessage_Cpp & message)
+  {
+    if (nullptr != series_) {
+      cpp_message_ = message;
+    }
+  }
+
+  // Mark the conversion as failed
+  void failed(ErrorKind kind)
+  {
+    error_ = kind;
+    has_error_ = true;
+  }
+
+  ConversionScope(const ConversionScope &) = delete;
+  ConversionScope & operator=(const ConversionScope &) = delete;
+
+private:
+  void start(
+    Operation operation, const void * type_info, const char * type_namespace,
+    const char * type_name, size_t bytes_in);
+  void finish();
+
+  const bool entered_;
+  // The series of the conversion, or null for nested conversions
+  Series * series_ = nullptr;
+  int64_t start_ns_ = 0;
+  size_t bytes_in_ = 0u;
+  RosMessage c_message_{nullptr, nullptr};
+  RosMessage_Cpp cpp_message_{nullptr, nullptr};
+  bool has_error_ = false;
+  ErrorKind error_ = ErrorKind::conversion;
+};
+
+}  // namespace impl
+
+}  // namespace metrics
+
+}  // namespace dynmsg
+
+#endif  // DYNMSG__METRICS_HPP_
@@ -0,0 +1,191 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__PROFILING_HPP_
+#define DYNMSG__PROFILING_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "rcutils/macros.h"
+
+namespace dynmsg
+{
+
+/// Profiling of the conversions between messages and YAML, field by field.
+/**
+ * While the profiler is running, the conversions of messages to YAML and from YAML measure the
+ * time spent converting each member of the messages, and optionally the heap allocations made
+ * while converting it. The costs are attributed to the path of the member in the converted type,
+ * e.g. "header.stamp.sec", and accumulated over all the converted messages, from all threads, until
+ * the profiler is reset.
+ *
+ * The cost of each member includes the cost of its nested members ("total"), and is also given
+ * without them ("self"). The bookkeeping of the profiler is excluded from both as far as possible,
+ * but profiling still slows the conversions down; a sample period lets only some of the messages be
+ * profiled. When the profiler is not running, the conversions only check a flag for each member.
+ */
+namespace profiling
+{
+
+/// Number of heap allocations, and the number of bytes requested by them.
+struct Allocations
+{
+  uint64_t count;
+  uint64_t bytes;
+};
+
+/// Function giving the number of heap allocations made by the calling thread so far.
+/**
+ * dynmsg cannot count the allocations of the process itself; a program that counts them, e.g. by
+ * replacing the global operator new, can provide them to the profiler with such a function.
+ * The allocations of each conversion are the difference between two calls on the thread running
+ * it, so the counts must be kept per thread when several threads allocate at the same time.
+ */
+using AllocationCounter = Allocations (*)();
+
+/// Options of the profiler.
+struct ProfilingOptions
+{
+  /// Profile one out of this many conversions of each thread; 1 profiles every conversion.
+  uint32_t sample_period = 1;
+  /// Function giving the allocations of the calling thread, or null to not attribute allocations.
+  AllocationCounter count_allocations = nullptr;
+};
+
+/// Accumulated cost of converting one member, or a whole message, in one direction.
+struct FieldCost
+{
+  /// The conversion: "c.to_yaml", "c.from_yaml", "cpp.to_yaml", or "cpp.from_yaml".
+  std::string operation;
+  /// The type of the converted messages, e.g. "std_msgs/msg/Header", for both C and C++ messages.
+  std::string type;
+  /// Path of the member in the type, with names separated by dots, or empty for the message.
+  /**
+   * The members of the elements of arrays and sequences of messages are accumulated under the path
+   * of the array or sequence, e.g. "points.x".
+   */
+  std::string path;
+  /// Number of profiled messages of the type, for this conversion.
+  uint64_t messages;
+  /// Number of times the member was converted.
+  uint64_t count;
+  /// Time spent converting the member, including its nested members, in nanoseconds.
+  uint64_t total_ns;
+  /// Time spent converting the member, excluding its nested members, in nanoseconds.
+  uint64_t self_ns;
+  /// Allocations made while converting the member, including its nested members.
+  Allocations total_allocations;
+  /// Allocations made while converting the member, excluding its nested members.
+  Allocations self_allocations;
+};
+
+/// Start profiling the conversions, or change the options of the running profiler.
+/**
+ * Costs accumulated so far are kept.
+ */
+void start(const ProfilingOptions & options = ProfilingOptions());
+
+/// Stop profiling the conversions.
+/**
+ * Conversions that are in progress finish being profiled.
+ */
+void stop();
+
+/// Discard the accumulated costs.
+void reset();
+
+/// Get the accumulated costs, sorted by decreasing self time.
+std::vector<FieldCost> get_report();
+
+/// Write a report as a table, with the costs per profiled message.
+/**
+ * \param out the stream to write to
+ * \param report the costs, in the order to write them in
+ * \param max_rows the maximum number of rows to write, or 0 to write all the rows
+ */
+void write_report(std::ostream & out, const std::vector<FieldCost> & report, size_t max_rows = 0);
+
+namespace impl
+{
+
+extern std::atomic<bool> running;
+
+// Marks the conversion of a message. Only the outermost conversion of each thread is profiled, as
+// nested messages are profiled as members of it.
+class MessageScope
+{
+public:
+  MessageScope(const char * operation, const char * type_namespace, const char * type_name)
+  : entered_(RCUTILS_UNLIKELY(running.load(std::memory_order_relaxed)))
+  {
+    if (entered_) {
+      enter(operation, type_namespace, type_name);
+    }
+  }
+
+  ~MessageScope()
+  {
+    if (entered_) {
+      exit();
+    }
+  }
+
+  MessageScope(const MessageScope &) = delete;
+  MessageScope & operator=(const MessageScope &) = delete;
+
+private:
+  static void enter(const char * operation, const char * type_namespace, const char * type_name);
+  static void exit();
+
+  const bool entered_;
+};
+
+// Marks the conversion of a member of a message
+class MemberScope
+{
+public:
+  explicit MemberScope(const char * name)
+  : entered_(RCUTILS_UNLIKELY(running.load(std::memory_order_relaxed)) && enter(name))
+  {
+  }
+
+  ~MemberScope()
+  {
+    if (entered_) {
+      exit();
+    }
+  }
+
+  MemberScope(const MemberScope &) = delete;
+  MemberScope & operator=(const MemberScope &) = delete;
+
+private:
+  // Returns false if the thread is not profiling a message
+  static bool enter(const char * name);
+  static void exit();
+
+  const bool entered_;
+};
+
+}  // namespace impl
+
+}  // namespace profiling
+
+}  // namespace dynmsg
+
+#endif  // DYNMSG__PROFILING_HPP_
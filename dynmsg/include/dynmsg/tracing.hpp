@@ -0,0 +1,149 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG__TRACING_HPP_
+#define DYNMSG__TRACING_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+#include "rcutils/macros.h"
+
+namespace dynmsg
+{
+
+/// Tracing of what the conversions do, which can be enabled at runtime.
+/**
+ * Trace events are grouped in categories, which are enabled separately. When a category is
+ * disabled, recording one of its events costs a single relaxed atomic load and a branch, and the
+ * arguments of the event are not evaluated.
+ *
+ * Recorded events are stored in a ring buffer owned by the recording thread, without locking or
+ * allocating. Events are taken out of the rings by drain(), usually called periodically by the
+ * thread started with start_draining(). Events recorded while the ring of a thread is full are
+ * dropped and counted, see get_dropped_event_count().
+ *
+ * Tracing can be enabled without changing the program by listing the categories to enable in the
+ * DYNMSG_TRACE environment variable, e.g. DYNMSG_TRACE=parser,reader or DYNMSG_TRACE=all. The
+ * events are then written to stderr.
+ */
+namespace tracing
+{
+
+/// Conversions from YAML to messages.
+constexpr uint32_t CATEGORY_PARSER = 1u << 0;
+/// Conversions from messages to YAML.
+constexpr uint32_t CATEGORY_READER = 1u << 1;
+/// All categories.
+constexpr uint32_t CATEGORY_ALL = ~0u;
+
+/// A trace event.
+struct Event
+{
+  /// Time of the event, in nanoseconds of std::chrono::steady_clock.
+  int64_t timestamp;
+  /// Index of the thread that recorded the event, in the order the threads recorded their first.
+  uint32_t thread_index;
+  /// Category of the event.
+  uint32_t category;
+  /// What happened, e.g. "write_member"; a string literal.
+  const char * what;
+  /// Name of the message type or member concerned, which must live as long as the process, like
+  /// the names in the introspection information; may be null.
+  const char * name;
+  /// A value giving details about the event, e.g. a type ID or a sequence length.
+  int64_t value;
+};
+
+/// Function to which drained events are passed.
+using Sink = std::function<void (const Event &)>;
+
+namespace impl
+{
+extern std::atomic<uint32_t> enabled_categories;
+}  // namespace impl
+
+/// Check if any of the given categories is enabled.
+inline bool is_enabled(uint32_t categories)
+{
+  return 0u != (impl::enabled_categories.load(std::memory_order_relaxed) & categories);
+}
+
+/// Set the enabled categories, as a combination of the CATEGORY_* flags.
+void set_enabled_categories(uint32_t categories);
+
+/// Get the enabled categories.
+uint32_t get_enabled_categories();
+
+/// Get the categories named in a comma-separated list, e.g. "parser,reader".
+/**
+ * \throws std::runtime_error if a category name is unknown
+ */
+uint32_t parse_categories(const std::string & names);
+
+/// Record an event in the ring of the calling thread.
+/**
+ * Use DYNMSG_TRACE() instead, which only records the event if its category is enabled.
+ */
+void record(uint32_t category, const char * what, const char * name, int64_t value);
+
+/// Pass the events recorded so far by all threads to a sink, and remove them from the rings.
+/**
+ * Events of each thread are passed in the order they were recorded. Only one drain runs at a time;
+ * recording threads are never blocked by it.
+ *
+ * \return the number of events drained
+ */
+size_t drain(const Sink & sink);
+
+/// Start a thread that drains the recorded events periodically.
+/**
+ * The sink is called from the drain thread. If a drain thread is already running, it is stopped
+ * first.
+ */
+void start_draining(
+  Sink sink,
+  std::chrono::milliseconds period = std::chrono::milliseconds(10));
+
+/// Stop the drain thread, if any, after draining the events recorded so far.
+void stop_draining();
+
+/// Get the number of events dropped because the ring of their thread was full.
+uint64_t get_dropped_event_count();
+
+/// Write an event as a line of text.
+void write_event(std::ostream & out, const Event & event);
+
+}  // namespace tracing
+
+}  // namespace dynmsg
+
+/// Record a trace event if its category is enabled.
+/**
+ * The arguments are only evaluated if the category is enabled.
+ *
+ * \see dynmsg::tracing::Event
+ */
+#define DYNMSG_TRACE(category, what, name, value) \
+  do { \
+    if (RCUTILS_UNLIKELY(::dynmsg::tracing::is_enabled(category))) { \
+      ::dynmsg::tracing::record(category, what, name, static_cast<int64_t>(value)); \
+    } \
+  } while (0)
+
+#endif  // DYNMSG__TRACING_HPP_
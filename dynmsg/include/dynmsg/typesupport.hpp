@@ -20,7 +20,9 @@
 #include <string>
 
 #include "rcutils/allocator.h"
+#include "rosidl_runtime_c/service_type_support_struct.h"
 #include "rosidl_typesupport_introspection_c/message_introspection.h"
+#include "rosidl_typesupport_introspection_c/service_introspection.h"
 #include "rosidl_typesupport_introspection_cpp/message_introspection.hpp"
 
 #include "dynmsg/types.h"
@@ -34,6 +36,12 @@ using TypeInfo_C = rosidl_typesupport_introspection_c__MessageMembers;
 // Structure used to store the introspection information for a single field of a interface type
 using MemberInfo_C = rosidl_typesupport_introspection_c__MessageMember;
 
+// Structure used to store the type support for a single service type
+using ServiceTypeSupport = rosidl_service_type_support_t;
+// Structure used to store the introspection information for a single service type, which refers
+// to the introspection information of its request and response message types
+using ServiceTypeInfo_C = rosidl_typesupport_introspection_c__ServiceMembers;
+
 using TypeInfo_Cpp = rosidl_typesupport_introspection_cpp::MessageMembers;
 using MemberInfo_Cpp = rosidl_typesupport_introspection_cpp::MessageMember;
 
@@ -53,8 +61,10 @@ typedef struct RosMessage_Cpp
 using TypeInfo = TypeInfo_C;
 using MemberInfo = MemberInfo_C;
 using RosMessage = RosMessage_C;
+using ServiceTypeInfo = ServiceTypeInfo_C;
 
 typedef const rosidl_message_type_support_t * (* get_message_ts_func)();
+typedef const rosidl_service_type_support_t * (* get_service_ts_func)();
 
 // An interface type can be identified by its namespace (i.e. the package that stores it) and its
 // type name
@@ -64,6 +74,13 @@ using InterfaceTypeName = std::pair<std::string, std::string>;
 namespace dynmsg
 {
 
+/// Get the full name of a message type from the namespace and name of its introspection info.
+/**
+ * The namespace is "std_msgs__msg" in the C introspection information and "std_msgs::msg" in the
+ * C++ one, and both give the same name, e.g. "std_msgs/msg/Header".
+ */
+std::string get_type_name(const char * type_namespace, const char * type_name);
+
 namespace c
 {
 
@@ -81,6 +98,16 @@ namespace c
  */
 const TypeInfo * get_type_info(const InterfaceTypeName & interface_type);
 
+/// Search for and load the introspection library for a single service type.
+/**
+ * This works like get_type_info(), but loads a function named following the pattern
+ * "rosidl_typesupport_introspection_c__get_service_type_support_handle__[namespace]__srv__[type]".
+ * The returned structure provides the introspection information of the service's request and
+ * response message types, which can be used like that returned by get_type_info().
+ * Returns nullptr if the library or the function cannot be loaded.
+ */
+const ServiceTypeInfo * get_service_type_info(const InterfaceTypeName & interface_type);
+
 /// Initialise a RosMessage structure.
 /**
  * The introspection information for the specified interface type is loaded from its shared library
@@ -31,6 +31,30 @@ namespace dynmsg
  */
 size_t get_vector_size(const uint8_t * vector, size_t element_size);
 
+/// Get the number of elements a vector has allocated space for.
+/**
+ * This uses the same assumption about the std::vector implementation as get_vector_size(), and
+ * therefore does not work for std::vector<bool> either.
+ */
+size_t get_vector_capacity(const uint8_t * vector, size_t element_size);
+
+/// Get a pointer to the first element of a vector, or null if it has never allocated any.
+/**
+ * This uses the same assumption about the std::vector implementation as get_vector_size(), and
+ * therefore does not work for std::vector<bool> either.
+ */
+const uint8_t * get_vector_data(const uint8_t * vector);
+
+/// Check if the std::vector implementation matches the assumption of get_vector_size().
+/**
+ * The assumption is checked the first time this is called, against vectors of a few element types,
+ * and the result is cached, so that checking it before each call of the functions that rely on it
+ * is cheap. When it does not hold for the standard library in use, the introspection functions of
+ * the members (size_function and get_const_function) must be used instead, as the functions of
+ * member_utils.hpp do.
+ */
+bool is_vector_layout_supported();
+
 }  // namespace dynmsg
 
 #endif  // DYNMSG__VECTOR_UTILS_HPP_
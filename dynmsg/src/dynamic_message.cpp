@@ -0,0 +1,156 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+namespace impl
+{
+
+// Overloads to call the C or C++ version of the typesupport functions from the template
+
+const TypeInfo * load_type_info(const InterfaceTypeName & interface_type, const TypeInfo *)
+{
+  return c::get_type_info(interface_type);
+}
+
+const TypeInfo_Cpp * load_type_info(
+  const InterfaceTypeName & interface_type,
+  const TypeInfo_Cpp *)
+{
+  return cpp::get_type_info(interface_type);
+}
+
+dynmsg_ret_t message_init(
+  const TypeInfo * type_info,
+  RosMessage * message,
+  rcutils_allocator_t * allocator)
+{
+  return c::ros_message_with_typeinfo_init(type_info, message, allocator);
+}
+
+dynmsg_ret_t message_init(
+  const TypeInfo_Cpp * type_info,
+  RosMessage_Cpp * message,
+  rcutils_allocator_t * allocator)
+{
+  return cpp::ros_message_with_typeinfo_init(type_info, message, allocator);
+}
+
+void message_destroy(RosMessage * message, rcutils_allocator_t * allocator)
+{
+  c::ros_message_destroy_with_allocator(message, allocator);
+}
+
+void message_destroy(RosMessage_Cpp * message, rcutils_allocator_t * allocator)
+{
+  cpp::ros_message_destroy_with_allocator(message, allocator);
+}
+
+}  // namespace impl
+
+template<typename RosMessageT, typename TypeInfoT>
+BasicDynamicMessage<RosMessageT, TypeInfoT>::BasicDynamicMessage() noexcept
+: message_{nullptr, nullptr},
+  allocator_(rcutils_get_default_allocator())
+{}
+
+template<typename RosMessageT, typename TypeInfoT>
+BasicDynamicMessage<RosMessageT, TypeInfoT>::BasicDynamicMessage(
+  const TypeInfoT * type_info,
+  rcutils_allocator_t allocator)
+: message_{nullptr, nullptr},
+  allocator_(allocator)
+{
+  if (nullptr == type_info) {
+    throw std::runtime_error("cannot create a message without introspection information");
+  }
+  if (DYNMSG_RET_OK != impl::message_init(type_info, &message_, &allocator_)) {
+    throw std::bad_alloc();
+  }
+}
+
+template<typename RosMessageT, typename TypeInfoT>
+BasicDynamicMessage<RosMessageT, TypeInfoT>::BasicDynamicMessage(
+  const InterfaceTypeName & interface_type,
+  rcutils_allocator_t allocator)
+: BasicDynamicMessage(
+    impl::load_type_info(interface_type, static_cast<const TypeInfoT *>(nullptr)), allocator)
+{}
+
+template<typename RosMessageT, typename TypeInfoT>
+BasicDynamicMessage<RosMessageT, TypeInfoT>::BasicDynamicMessage(
+  BasicDynamicMessage && other) noexcept
+: message_(other.release()),
+  allocator_(other.allocator_)
+{}
+
+template<typename RosMessageT, typename TypeInfoT>
+BasicDynamicMessage<RosMessageT, TypeInfoT> &
+BasicDynamicMessage<RosMessageT, TypeInfoT>::operator=(BasicDynamicMessage && other) noexcept
+{
+  if (this != &other) {
+    reset();
+    message_ = other.release();
+    allocator_ = other.allocator_;
+  }
+  return *this;
+}
+
+template<typename RosMessageT, typename TypeInfoT>
+BasicDynamicMessage<RosMessageT, TypeInfoT>::~BasicDynamicMessage()
+{
+  reset();
+}
+
+template<typename RosMessageT, typename TypeInfoT>
+BasicDynamicMessage<RosMessageT, TypeInfoT> BasicDynamicMessage<RosMessageT, TypeInfoT>::adopt(
+  RosMessageT message,
+  rcutils_allocator_t allocator) noexcept
+{
+  BasicDynamicMessage dynamic_message;
+  dynamic_message.message_ = message;
+  dynamic_message.allocator_ = allocator;
+  return dynamic_message;
+}
+
+template<typename RosMessageT, typename TypeInfoT>
+RosMessageT BasicDynamicMessage<RosMessageT, TypeInfoT>::release() noexcept
+{
+  RosMessageT message = message_;
+  message_ = RosMessageT{nullptr, nullptr};
+  return message;
+}
+
+template<typename RosMessageT, typename TypeInfoT>
+void BasicDynamicMessage<RosMessageT, TypeInfoT>::reset() noexcept
+{
+  if (nullptr != message_.data) {
+    impl::message_destroy(&message_, &allocator_);
+    message_ = RosMessageT{nullptr, nullptr};
+  }
+}
+
+template class BasicDynamicMessage<RosMessage, TypeInfo>;
+template class BasicDynamicMessage<RosMessage_Cpp, TypeInfo_Cpp>;
+
+}  // namespace dynmsg
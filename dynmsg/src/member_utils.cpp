@@ -0,0 +1,421 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosidl_runtime_c/primitives_sequence.h"
+#include "rosidl_runtime_c/primitives_sequence_functions.h"
+#include "rosidl_runtime_c/string.h"
+#include "rosidl_runtime_c/string_functions.h"
+#include "rosidl_runtime_c/u16string.h"
+#include "rosidl_runtime_c/u16string_functions.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+#include "rcutils/macros.h"
+
+#include "dynmsg/member_utils.hpp"
+#include "dynmsg/typesupport.hpp"
+#include "dynmsg/vector_utils.hpp"
+
+namespace dynmsg
+{
+
+bool is_primitive_type(uint8_t type_id)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+      return false;
+    default:
+      return true;
+  }
+}
+
+namespace c
+{
+
+/// Memory layout of all rosidl_runtime_c__*__Sequence structures.
+struct GenericSequence
+{
+  uint8_t * data;
+  size_t size;
+  size_t capacity;
+};
+
+const TypeInfo * get_nested_type_info(const MemberInfo & member)
+{
+  return reinterpret_cast<const TypeInfo *>(member.members_->data);
+}
+
+bool is_sequence(const MemberInfo & member)
+{
+  // See dynmsg::c::impl::is_sequence() in msg_parser_c.cpp for the meaning of these flags
+  return (member.is_array_ && member.array_size_ == 0) || member.is_upper_bound_;
+}
+
+size_t get_element_size(const MemberInfo & member)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+      return sizeof(float);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+      return sizeof(double);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      return sizeof(long double);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_CHAR:
+      return sizeof(uint8_t);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WCHAR:
+      return sizeof(uint16_t);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+      return sizeof(bool);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT8:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT8:
+      return sizeof(uint8_t);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+      return sizeof(uint16_t);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+      return sizeof(uint32_t);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      return sizeof(uint64_t);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING:
+      return sizeof(rosidl_runtime_c__String);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING:
+      return sizeof(rosidl_runtime_c__U16String);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+      return get_nested_type_info(member)->size_of_;
+    default:
+      return 0;
+  }
+}
+
+size_t get_element_count(const MemberInfo & member, const uint8_t * member_data)
+{
+  if (!member.is_array_) {
+    return 1u;
+  }
+  if (is_sequence(member)) {
+    return reinterpret_cast<const GenericSequence *>(member_data)->size;
+  }
+  return member.array_size_;
+}
+
+size_t get_element_capacity(const MemberInfo & member, const uint8_t * member_data)
+{
+  if (is_sequence(member)) {
+    const auto sequence = reinterpret_cast<const GenericSequence *>(member_data);
+    return nullptr == sequence->data ? 0u : sequence->capacity;
+  }
+  return get_element_count(member, member_data);
+}
+
+const uint8_t * get_element_data(const MemberInfo & member, const uint8_t * member_data)
+{
+  if (is_sequence(member)) {
+    return reinterpret_cast<const GenericSequence *>(member_data)->data;
+  }
+  return member_data;
+}
+
+namespace
+{
+
+// Helper to reinitialize C sequences of primitive types and strings
+template<typename SequenceType>
+uint8_t * reinit_sequence(
+  uint8_t * member_data,
+  size_t size,
+  bool (* init)(SequenceType *, size_t),
+  void (* fini)(SequenceType *))
+{
+  auto sequence = reinterpret_cast<SequenceType *>(member_data);
+  fini(sequence);
+  if (!init(sequence, size)) {
+    throw std::runtime_error("error initializing rosidl sequence");
+  }
+  return reinterpret_cast<uint8_t *>(sequence->data);
+}
+
+}  // namespace
+
+uint8_t * resize_sequence(const MemberInfo & member, uint8_t * member_data, size_t size)
+{
+  if (get_element_count(member, member_data) == size) {
+    return const_cast<uint8_t *>(get_element_data(member, member_data));
+  }
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__float32__Sequence__init, rosidl_runtime_c__float32__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__double__Sequence__init, rosidl_runtime_c__double__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__long_double__Sequence__init,
+        rosidl_runtime_c__long_double__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_CHAR:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__char__Sequence__init, rosidl_runtime_c__char__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WCHAR:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__wchar__Sequence__init, rosidl_runtime_c__wchar__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__bool__Sequence__init, rosidl_runtime_c__bool__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_OCTET:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__octet__Sequence__init, rosidl_runtime_c__octet__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT8:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__uint8__Sequence__init, rosidl_runtime_c__uint8__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT8:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__int8__Sequence__init, rosidl_runtime_c__int8__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__uint16__Sequence__init, rosidl_runtime_c__uint16__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__int16__Sequence__init, rosidl_runtime_c__int16__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__uint32__Sequence__init, rosidl_runtime_c__uint32__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__int32__Sequence__init, rosidl_runtime_c__int32__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__uint64__Sequence__init, rosidl_runtime_c__uint64__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__int64__Sequence__init, rosidl_runtime_c__int64__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__String__Sequence__init, rosidl_runtime_c__String__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING:
+      return reinit_sequence(
+        member_data, size,
+        rosidl_runtime_c__U16String__Sequence__init, rosidl_runtime_c__U16String__Sequence__fini);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+      if (!member.resize_function(member_data, size)) {
+        throw std::runtime_error("error resizing rosidl sequence");
+      }
+      return const_cast<uint8_t *>(get_element_data(member, member_data));
+    default:
+      throw std::runtime_error("unknown type");
+  }
+}
+
+}  // namespace c
+
+namespace cpp
+{
+
+const TypeInfo_Cpp * get_nested_type_info(const MemberInfo_Cpp & member)
+{
+  return reinterpret_cast<const TypeInfo_Cpp *>(member.members_->data);
+}
+
+bool is_sequence(const MemberInfo_Cpp & member)
+{
+  // See dynmsg::cpp::impl::is_sequence() in msg_parser_cpp.cpp for the meaning of these flags
+  return (member.is_array_ && member.array_size_ == 0) || member.is_upper_bound_;
+}
+
+size_t get_element_size(const MemberInfo_Cpp & member)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_FLOAT:
+      return sizeof(float);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_DOUBLE:
+      return sizeof(double);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_LONG_DOUBLE:
+      return sizeof(long double);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_CHAR:
+      return sizeof(uint8_t);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_WCHAR:
+      return sizeof(uint16_t);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN:
+      return sizeof(bool);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8:
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT8:
+      return sizeof(uint8_t);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT16:
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT16:
+      return sizeof(uint16_t);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT32:
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT32:
+      return sizeof(uint32_t);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT64:
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT64:
+      return sizeof(uint64_t);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING:
+      return sizeof(std::string);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING:
+      return sizeof(std::u16string);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE:
+      return get_nested_type_info(member)->size_of_;
+    default:
+      return 0;
+  }
+}
+
+size_t get_element_count(const MemberInfo_Cpp & member, const uint8_t * member_data)
+{
+  if (!member.is_array_) {
+    return 1u;
+  }
+  if (!is_sequence(member)) {
+    return member.array_size_;
+  }
+  // std::vector<bool> is a special space-optimized specialization, see vector_utils.hpp
+  if (rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN == member.type_id_) {
+    return reinterpret_cast<const std::vector<bool> *>(member_data)->size();
+  }
+  if (RCUTILS_LIKELY(dynmsg::is_vector_layout_supported())) {
+    return dynmsg::get_vector_size(member_data, get_element_size(member));
+  }
+  return member.size_function(member_data);
+}
+
+size_t get_element_capacity(const MemberInfo_Cpp & member, const uint8_t * member_data)
+{
+  if (!is_sequence(member)) {
+    return get_element_count(member, member_data);
+  }
+  if (rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN == member.type_id_) {
+    return reinterpret_cast<const std::vector<bool> *>(member_data)->capacity();
+  }
+  if (RCUTILS_LIKELY(dynmsg::is_vector_layout_supported())) {
+    return dynmsg::get_vector_capacity(member_data, get_element_size(member));
+  }
+  // The introspection functions do not give the capacity, so only the size is known to be used
+  return member.size_function(member_data);
+}
+
+const uint8_t * get_element_data(const MemberInfo_Cpp & member, const uint8_t * member_data)
+{
+  if (!is_sequence(member)) {
+    return member_data;
+  }
+  if (rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN == member.type_id_) {
+    return nullptr;
+  }
+  if (RCUTILS_LIKELY(dynmsg::is_vector_layout_supported())) {
+    return dynmsg::get_vector_data(member_data);
+  }
+  if (0u == member.size_function(member_data)) {
+    return nullptr;
+  }
+  return reinterpret_cast<const uint8_t *>(member.get_const_function(member_data, 0u));
+}
+
+namespace
+{
+
+// Resize a C++ vector and get its data; not for std::vector<bool>
+template<typename T>
+uint8_t * resize_vector(uint8_t * member_data, size_t size)
+{
+  auto vector = reinterpret_cast<std::vector<T> *>(member_data);
+  vector->resize(size);
+  return reinterpret_cast<uint8_t *>(vector->data());
+}
+
+uint8_t * resize_primitive_vector(uint8_t type_id, uint8_t * member_data, size_t size)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_FLOAT:
+      return resize_vector<float>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_DOUBLE:
+      return resize_vector<double>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_LONG_DOUBLE:
+      return resize_vector<long double>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_CHAR:
+      return resize_vector<signed char>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_WCHAR:
+      return resize_vector<uint16_t>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8:
+      return resize_vector<uint8_t>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT8:
+      return resize_vector<int8_t>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT16:
+      return resize_vector<uint16_t>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT16:
+      return resize_vector<int16_t>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT32:
+      return resize_vector<uint32_t>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT32:
+      return resize_vector<int32_t>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT64:
+      return resize_vector<uint64_t>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_INT64:
+      return resize_vector<int64_t>(member_data, size);
+    default:
+      throw std::runtime_error("unknown type");
+  }
+}
+
+}  // namespace
+
+uint8_t * resize_sequence(const MemberInfo_Cpp & member, uint8_t * member_data, size_t size)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN:
+      // std::vector<bool> is different, see vector_utils.hpp
+      reinterpret_cast<std::vector<bool> *>(member_data)->resize(size);
+      return nullptr;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING:
+      return resize_vector<std::string>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING:
+      return resize_vector<std::u16string>(member_data, size);
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE:
+      member.resize_function(member_data, size);
+      if (0u == size) {
+        return nullptr;
+      }
+      return reinterpret_cast<uint8_t *>(member.get_function(member_data, 0u));
+    default:
+      return resize_primitive_vector(member.type_id_, member_data, size);
+  }
+}
+
+}  // namespace cpp
+
+}  // namespace dynmsg
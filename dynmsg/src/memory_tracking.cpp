@@ -0,0 +1,129 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+
+#include "dynmsg/memory_tracking.hpp"
+
+namespace dynmsg
+{
+
+namespace memory_tracking
+{
+
+namespace impl
+{
+
+std::atomic<bool> enabled(false);
+
+}  // namespace impl
+
+namespace
+{
+
+// Memory used by the conversion in progress on a thread.
+//
+// This is only made of integers, so that the thread_local variable holding it is initialized
+// statically, and can be used from allocation functions at any time in the life of the thread.
+struct ThreadMemory
+{
+  // Number of nested conversions in progress
+  uint32_t depth;
+  // Bytes allocated and not freed since the start of the conversion, which goes below zero when the
+  // conversion frees memory allocated before it
+  int64_t live_bytes;
+  int64_t peak_bytes;
+  uint64_t allocated_bytes;
+  uint64_t allocations;
+  ConversionMemory last;
+};
+
+thread_local ThreadMemory thread_memory = {0u, 0, 0, 0u, 0u, {0u, 0u, 0u}};
+
+}  // namespace
+
+namespace impl
+{
+
+void ConversionScope::enter()
+{
+  ThreadMemory & memory = thread_memory;
+  if (memory.depth++ > 0u) {
+    return;
+  }
+  memory.live_bytes = 0;
+  memory.peak_bytes = 0;
+  memory.allocated_bytes = 0u;
+  memory.allocations = 0u;
+}
+
+void ConversionScope::exit()
+{
+  ThreadMemory & memory = thread_memory;
+  if (--memory.depth > 0u) {
+    return;
+  }
+  memory.last = ConversionMemory{
+    static_cast<size_t>(memory.peak_bytes), static_cast<size_t>(memory.allocated_bytes),
+    static_cast<size_t>(memory.allocations)};
+}
+
+}  // namespace impl
+
+void set_enabled(bool enabled)
+{
+  impl::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool is_enabled()
+{
+  return impl::enabled.load(std::memory_order_relaxed);
+}
+
+ConversionMemory get_last_conversion_memory()
+{
+  return thread_memory.last;
+}
+
+void reset_last_conversion_memory()
+{
+  thread_memory.last = ConversionMemory{0u, 0u, 0u};
+}
+
+void record_allocation(size_t bytes) noexcept
+{
+  ThreadMemory & memory = thread_memory;
+  if (0u == memory.depth) {
+    return;
+  }
+  memory.live_bytes += static_cast<int64_t>(bytes);
+  if (memory.live_bytes > memory.peak_bytes) {
+    memory.peak_bytes = memory.live_bytes;
+  }
+  memory.allocated_bytes += bytes;
+  ++memory.allocations;
+}
+
+void record_deallocation(size_t bytes) noexcept
+{
+  ThreadMemory & memory = thread_memory;
+  if (0u == memory.depth) {
+    return;
+  }
+  memory.live_bytes -= static_cast<int64_t>(bytes);
+}
+
+}  // namespace memory_tracking
+
+}  // namespace dynmsg
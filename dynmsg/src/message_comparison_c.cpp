@@ -0,0 +1,312 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <yaml-cpp/yaml.h>
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "rosidl_runtime_c/string.h"
+#include "rosidl_runtime_c/u16string.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+
+#include "dynmsg/member_utils.hpp"
+#include "dynmsg/message_comparison.hpp"
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+namespace c
+{
+
+namespace impl
+{
+
+// Defined in message_reading_c.cpp
+YAML::Node member_to_yaml(const MemberInfo & member_info, uint8_t * member_data);
+void member_to_yaml_array_item(
+  const MemberInfo & member_info,
+  const uint8_t * member_data,
+  YAML::Node & array_node);
+
+// Check if values of the given type can be compared using memcmp()
+bool is_bitwise_comparable(uint8_t type_id, const ComparisonOptions & options)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+      return options.float_tolerance <= 0.0;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      // long double usually contains padding bytes, which can have any value
+      return false;
+    default:
+      return is_primitive_type(type_id);
+  }
+}
+
+// Compare two floating point values, with a tolerance
+template<typename T>
+bool float_equals(const uint8_t * a, const uint8_t * b, double tolerance)
+{
+  if (tolerance <= 0.0 && !std::is_same<T, long double>::value) {
+    // Compare bitwise, like the memcmp() over contiguous members
+    return 0 == memcmp(a, b, sizeof(T));
+  }
+  T value_a;
+  T value_b;
+  memcpy(&value_a, a, sizeof(T));
+  memcpy(&value_b, b, sizeof(T));
+  if (value_a == value_b) {
+    return true;
+  }
+  if (std::isnan(value_a) || std::isnan(value_b)) {
+    return std::isnan(value_a) && std::isnan(value_b);
+  }
+  return static_cast<double>(std::fabs(value_a - value_b)) <= tolerance;
+}
+
+// Compare two values of a primitive type
+bool primitive_equals(
+  uint8_t type_id,
+  size_t size,
+  const uint8_t * a,
+  const uint8_t * b,
+  const ComparisonOptions & options)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+      return float_equals<float>(a, b, options.float_tolerance);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+      return float_equals<double>(a, b, options.float_tolerance);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      return float_equals<long double>(a, b, options.float_tolerance);
+    default:
+      return 0 == memcmp(a, b, size);
+  }
+}
+
+// Convert a single element of a member to YAML
+YAML::Node element_to_yaml(const MemberInfo & member, const uint8_t * element_data)
+{
+  YAML::Node array;
+  member_to_yaml_array_item(member, element_data, array);
+  return array[0];
+}
+
+// Recursively compares two messages of the same type, optionally collecting the differences
+class Comparator
+{
+public:
+  // If differences is nullptr, the comparison stops at the first mismatch
+  Comparator(const ComparisonOptions & options, std::vector<FieldDifference> * differences)
+  : options_(options), differences_(differences)
+  {}
+
+  bool compare_message(
+    const TypeInfo * type_info,
+    const uint8_t * a,
+    const uint8_t * b,
+    std::string & path)
+  {
+    bool equal = true;
+    uint32_t ii = 0;
+    while (ii < type_info->member_count_) {
+      // Find the run of contiguous members (without padding in between) starting at this member
+      // that are stored inline and can be compared bitwise
+      const uint32_t run_begin = ii;
+      size_t run_size = 0u;
+      while (ii < type_info->member_count_) {
+        const MemberInfo & member = type_info->members_[ii];
+        if (is_sequence(member) || !is_bitwise_comparable(member.type_id_, options_) ||
+          type_info->members_[run_begin].offset_ + run_size != member.offset_)
+        {
+          break;
+        }
+        run_size += get_element_size(member) * get_element_count(member, nullptr);
+        ++ii;
+      }
+      if (ii > run_begin) {
+        const uint32_t offset = type_info->members_[run_begin].offset_;
+        if (0 == memcmp(a + offset, b + offset, run_size)) {
+          continue;
+        }
+        if (nullptr == differences_) {
+          return false;
+        }
+        // Find out which members of the run differ
+        for (uint32_t jj = run_begin; jj < ii; ++jj) {
+          const MemberInfo & member = type_info->members_[jj];
+          equal &= compare_member(member, a + member.offset_, b + member.offset_, path);
+        }
+        continue;
+      }
+
+      const MemberInfo & member = type_info->members_[ii];
+      if (!compare_member(member, a + member.offset_, b + member.offset_, path)) {
+        equal = false;
+        if (nullptr == differences_) {
+          return false;
+        }
+      }
+      ++ii;
+    }
+    return equal;
+  }
+
+private:
+  bool compare_member(
+    const MemberInfo & member,
+    const uint8_t * a,
+    const uint8_t * b,
+    std::string & path)
+  {
+    // Only keep track of the path if differences are collected
+    const size_t path_length = path.size();
+    if (nullptr != differences_) {
+      if (!path.empty()) {
+        path += '.';
+      }
+      path += member.name_;
+    }
+    const bool equal = member.is_array_ ?
+      compare_array(member, a, b, path) :
+      compare_element(member, a, b, path);
+    if (nullptr != differences_) {
+      path.resize(path_length);
+    }
+    return equal;
+  }
+
+  bool compare_array(
+    const MemberInfo & member,
+    const uint8_t * a,
+    const uint8_t * b,
+    std::string & path)
+  {
+    const size_t count = get_element_count(member, a);
+    if (count != get_element_count(member, b)) {
+      if (nullptr != differences_) {
+        differences_->push_back(
+          {path,
+            member_to_yaml(member, const_cast<uint8_t *>(a)),
+            member_to_yaml(member, const_cast<uint8_t *>(b))});
+      }
+      return false;
+    }
+    if (0u == count) {
+      return true;
+    }
+    const uint8_t * data_a = get_element_data(member, a);
+    const uint8_t * data_b = get_element_data(member, b);
+    const size_t element_size = get_element_size(member);
+    if (is_bitwise_comparable(member.type_id_, options_)) {
+      if (0 == memcmp(data_a, data_b, count * element_size)) {
+        return true;
+      }
+      if (nullptr == differences_) {
+        return false;
+      }
+    }
+    bool equal = true;
+    for (size_t ii = 0; ii < count; ++ii) {
+      const size_t path_length = path.size();
+      if (nullptr != differences_) {
+        path += '[' + std::to_string(ii) + ']';
+      }
+      const size_t offset = ii * element_size;
+      if (!compare_element(member, data_a + offset, data_b + offset, path)) {
+        equal = false;
+      }
+      if (nullptr != differences_) {
+        path.resize(path_length);
+      } else if (!equal) {
+        return false;
+      }
+    }
+    return equal;
+  }
+
+  bool compare_element(
+    const MemberInfo & member,
+    const uint8_t * a,
+    const uint8_t * b,
+    std::string & path)
+  {
+    bool equal = false;
+    switch (member.type_id_) {
+      case rosidl_typesupport_introspection_c__ROS_TYPE_STRING: {
+          const auto * string_a = reinterpret_cast<const rosidl_runtime_c__String *>(a);
+          const auto * string_b = reinterpret_cast<const rosidl_runtime_c__String *>(b);
+          equal = string_a->size == string_b->size &&
+            (0u == string_a->size || 0 == memcmp(string_a->data, string_b->data, string_a->size));
+          break;
+        }
+      case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING: {
+          const auto * string_a = reinterpret_cast<const rosidl_runtime_c__U16String *>(a);
+          const auto * string_b = reinterpret_cast<const rosidl_runtime_c__U16String *>(b);
+          equal = string_a->size == string_b->size &&
+            (0u == string_a->size ||
+            0 == memcmp(string_a->data, string_b->data, string_a->size * sizeof(uint16_t)));
+          break;
+        }
+      case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+        // Differences in nested messages are reported for each of their members
+        return compare_message(get_nested_type_info(member), a, b, path);
+      default:
+        equal = primitive_equals(member.type_id_, get_element_size(member), a, b, options_);
+        break;
+    }
+    if (!equal && nullptr != differences_) {
+      differences_->push_back({path, element_to_yaml(member, a), element_to_yaml(member, b)});
+    }
+    return equal;
+  }
+
+  const ComparisonOptions & options_;
+  std::vector<FieldDifference> * differences_;
+};
+
+}  // namespace impl
+
+bool equals(const RosMessage & a, const RosMessage & b, const ComparisonOptions & options)
+{
+  if (a.type_info != b.type_info) {
+    return false;
+  }
+  impl::Comparator comparator(options, nullptr);
+  std::string path;
+  return comparator.compare_message(a.type_info, a.data, b.data, path);
+}
+
+std::vector<FieldDifference> diff(
+  const RosMessage & a,
+  const RosMessage & b,
+  const ComparisonOptions & options)
+{
+  if (a.type_info != b.type_info) {
+    throw std::runtime_error("cannot compare messages of different types");
+  }
+  std::vector<FieldDifference> differences;
+  impl::Comparator comparator(options, &differences);
+  std::string path;
+  comparator.compare_message(a.type_info, a.data, b.data, path);
+  return differences;
+}
+
+}  // namespace c
+}  // namespace dynmsg
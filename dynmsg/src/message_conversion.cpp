@@ -0,0 +1,374 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosidl_runtime_c/string.h"
+#include "rosidl_runtime_c/string_functions.h"
+#include "rosidl_runtime_c/u16string.h"
+#include "rosidl_runtime_c/u16string_functions.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+
+#include "dynmsg/member_utils.hpp"
+#include "dynmsg/message_conversion.hpp"
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+namespace impl
+{
+
+// A step of the conversion of a message
+struct ConversionStep
+{
+  // Index of the (first) member converted by this step
+  uint32_t member_index;
+  // If not 0, members starting at member_index are copied as a single block of this many bytes
+  size_t block_size;
+};
+
+// Precomputed mapping between the C and C++ layouts of a message type
+struct ConversionPlan
+{
+  const TypeInfo * type_info;
+  const TypeInfo_Cpp * type_info_cpp;
+  std::vector<ConversionStep> steps;
+  // Plans for the members that are nested messages, indexed like the members
+  std::vector<std::shared_ptr<const ConversionPlan>> nested_plans;
+};
+
+using PlanCache = std::map<const TypeInfo *, std::shared_ptr<const ConversionPlan>>;
+
+// Check if a member is a single primitive value or a fixed-size array of primitive values
+bool is_inline_primitive(const MemberInfo & member)
+{
+  return is_primitive_type(member.type_id_) && !c::is_sequence(member);
+}
+
+// Size of a member stored inline in the message
+size_t inline_size(const MemberInfo & member)
+{
+  return c::get_element_size(member) * c::get_element_count(member, nullptr);
+}
+
+void check_members_match(const MemberInfo & member, const MemberInfo_Cpp & member_cpp)
+{
+  if (0 != strcmp(member.name_, member_cpp.name_) || member.type_id_ != member_cpp.type_id_ ||
+    member.is_array_ != member_cpp.is_array_ || member.array_size_ != member_cpp.array_size_ ||
+    member.is_upper_bound_ != member_cpp.is_upper_bound_ ||
+    (is_primitive_type(member.type_id_) &&
+    c::get_element_size(member) != cpp::get_element_size(member_cpp)))
+  {
+    throw std::runtime_error(
+            std::string("C and C++ introspection information differ for member ") + member.name_);
+  }
+}
+
+std::shared_ptr<const ConversionPlan> make_plan(
+  const TypeInfo * type_info,
+  const TypeInfo_Cpp * type_info_cpp,
+  PlanCache & cache)
+{
+  const auto cached = cache.find(type_info);
+  if (cache.end() != cached) {
+    return cached->second;
+  }
+  // The namespaces are not compared, as they are formatted differently in C and C++
+  if (0 != strcmp(type_info->message_name_, type_info_cpp->message_name_) ||
+    type_info->member_count_ != type_info_cpp->member_count_)
+  {
+    throw std::runtime_error(
+            std::string("C and C++ introspection information differ for type ") +
+            type_info->message_name_);
+  }
+
+  auto plan = std::make_shared<ConversionPlan>();
+  plan->type_info = type_info;
+  plan->type_info_cpp = type_info_cpp;
+  plan->nested_plans.resize(type_info->member_count_);
+  uint32_t ii = 0;
+  while (ii < type_info->member_count_) {
+    const MemberInfo & member = type_info->members_[ii];
+    const MemberInfo_Cpp & member_cpp = type_info_cpp->members_[ii];
+    check_members_match(member, member_cpp);
+    if (rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE == member.type_id_) {
+      plan->nested_plans[ii] = make_plan(
+        c::get_nested_type_info(member), cpp::get_nested_type_info(member_cpp), cache);
+    }
+    if (!is_inline_primitive(member)) {
+      plan->steps.push_back({ii, 0u});
+      ++ii;
+      continue;
+    }
+
+    // Extend the block while the next members are at the same relative offset in both layouts;
+    // padding bytes in between are copied along, which is harmless
+    const uint32_t block_begin = ii;
+    size_t block_size = inline_size(member);
+    ++ii;
+    while (ii < type_info->member_count_) {
+      const MemberInfo & next = type_info->members_[ii];
+      const MemberInfo_Cpp & next_cpp = type_info_cpp->members_[ii];
+      check_members_match(next, next_cpp);
+      if (!is_inline_primitive(next) ||
+        next.offset_ - type_info->members_[block_begin].offset_ !=
+        next_cpp.offset_ - type_info_cpp->members_[block_begin].offset_)
+      {
+        break;
+      }
+      block_size = next.offset_ - type_info->members_[block_begin].offset_ + inline_size(next);
+      ++ii;
+    }
+    plan->steps.push_back({block_begin, block_size});
+  }
+  cache[type_info] = plan;
+  return plan;
+}
+
+void check_types(
+  const ConversionPlan & plan,
+  const TypeInfo * type_info,
+  const TypeInfo_Cpp * type_info_cpp)
+{
+  if (plan.type_info != type_info || plan.type_info_cpp != type_info_cpp) {
+    throw std::runtime_error("message type does not match the converter type");
+  }
+}
+
+void convert_message_c_to_cpp(const ConversionPlan & plan, const uint8_t * from, uint8_t * to);
+void convert_message_cpp_to_c(const ConversionPlan & plan, const uint8_t * from, uint8_t * to);
+
+void convert_element_c_to_cpp(
+  const MemberInfo & member,
+  const ConversionPlan * nested_plan,
+  const uint8_t * from,
+  uint8_t * to)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING: {
+        const auto string = reinterpret_cast<const rosidl_runtime_c__String *>(from);
+        reinterpret_cast<std::string *>(to)->assign(string->data, string->size);
+        break;
+      }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING: {
+        const auto string = reinterpret_cast<const rosidl_runtime_c__U16String *>(from);
+        reinterpret_cast<std::u16string *>(to)->assign(
+          reinterpret_cast<const char16_t *>(string->data), string->size);
+        break;
+      }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+      convert_message_c_to_cpp(*nested_plan, from, to);
+      break;
+    default:
+      memcpy(to, from, c::get_element_size(member));
+      break;
+  }
+}
+
+void convert_element_cpp_to_c(
+  const MemberInfo & member,
+  const ConversionPlan * nested_plan,
+  const uint8_t * from,
+  uint8_t * to)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING: {
+        const auto string = reinterpret_cast<const std::string *>(from);
+        if (!rosidl_runtime_c__String__assignn(
+            reinterpret_cast<rosidl_runtime_c__String *>(to), string->data(), string->size()))
+        {
+          throw std::runtime_error("error assigning rosidl string");
+        }
+        break;
+      }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING: {
+        const auto string = reinterpret_cast<const std::u16string *>(from);
+        if (!rosidl_runtime_c__U16String__assignn(
+            reinterpret_cast<rosidl_runtime_c__U16String *>(to),
+            reinterpret_cast<const uint16_t *>(string->data()), string->size()))
+        {
+          throw std::runtime_error("error assigning rosidl string");
+        }
+        break;
+      }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+      convert_message_cpp_to_c(*nested_plan, from, to);
+      break;
+    default:
+      memcpy(to, from, c::get_element_size(member));
+      break;
+  }
+}
+
+void convert_member_c_to_cpp(
+  const MemberInfo & member,
+  const MemberInfo_Cpp & member_cpp,
+  const ConversionPlan * nested_plan,
+  const uint8_t * from,
+  uint8_t * to)
+{
+  if (!member.is_array_) {
+    convert_element_c_to_cpp(member, nested_plan, from, to);
+    return;
+  }
+  const size_t count = c::get_element_count(member, from);
+  const uint8_t * from_data = c::get_element_data(member, from);
+  uint8_t * to_data = to;
+  if (c::is_sequence(member)) {
+    switch (member_cpp.type_id_) {
+      case rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN: {
+          // std::vector<bool> is different, see vector_utils.hpp
+          const auto bools = reinterpret_cast<const bool *>(from_data);
+          reinterpret_cast<std::vector<bool> *>(to)->assign(bools, bools + count);
+          return;
+        }
+      default:
+        to_data = cpp::resize_sequence(member_cpp, to, count);
+        break;
+    }
+    if (0u == count) {
+      return;
+    }
+  }
+  if (is_primitive_type(member.type_id_)) {
+    memcpy(to_data, from_data, count * c::get_element_size(member));
+    return;
+  }
+  const size_t element_size = c::get_element_size(member);
+  const size_t element_size_cpp = cpp::get_element_size(member_cpp);
+  for (size_t ii = 0; ii < count; ++ii) {
+    convert_element_c_to_cpp(
+      member, nested_plan, from_data + ii * element_size, to_data + ii * element_size_cpp);
+  }
+}
+
+void convert_member_cpp_to_c(
+  const MemberInfo & member,
+  const MemberInfo_Cpp & member_cpp,
+  const ConversionPlan * nested_plan,
+  const uint8_t * from,
+  uint8_t * to)
+{
+  if (!member.is_array_) {
+    convert_element_cpp_to_c(member, nested_plan, from, to);
+    return;
+  }
+  const size_t count = cpp::get_element_count(member_cpp, from);
+  uint8_t * to_data = to;
+  if (c::is_sequence(member)) {
+    to_data = c::resize_sequence(member, to, count);
+    if (0u == count) {
+      return;
+    }
+    if (rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN == member_cpp.type_id_) {
+      // std::vector<bool> is different, see vector_utils.hpp
+      const auto & bools = *reinterpret_cast<const std::vector<bool> *>(from);
+      auto to_bools = reinterpret_cast<bool *>(to_data);
+      for (size_t ii = 0; ii < count; ++ii) {
+        to_bools[ii] = bools[ii];
+      }
+      return;
+    }
+  }
+  const uint8_t * from_data = cpp::get_element_data(member_cpp, from);
+  if (is_primitive_type(member.type_id_)) {
+    memcpy(to_data, from_data, count * c::get_element_size(member));
+    return;
+  }
+  const size_t element_size = c::get_element_size(member);
+  const size_t element_size_cpp = cpp::get_element_size(member_cpp);
+  for (size_t ii = 0; ii < count; ++ii) {
+    convert_element_cpp_to_c(
+      member, nested_plan, from_data + ii * element_size_cpp, to_data + ii * element_size);
+  }
+}
+
+void convert_message_c_to_cpp(const ConversionPlan & plan, const uint8_t * from, uint8_t * to)
+{
+  for (const ConversionStep & step : plan.steps) {
+    const MemberInfo & member = plan.type_info->members_[step.member_index];
+    const MemberInfo_Cpp & member_cpp = plan.type_info_cpp->members_[step.member_index];
+    if (0u != step.block_size) {
+      memcpy(to + member_cpp.offset_, from + member.offset_, step.block_size);
+      continue;
+    }
+    convert_member_c_to_cpp(
+      member, member_cpp, plan.nested_plans[step.member_index].get(),
+      from + member.offset_, to + member_cpp.offset_);
+  }
+}
+
+void convert_message_cpp_to_c(const ConversionPlan & plan, const uint8_t * from, uint8_t * to)
+{
+  for (const ConversionStep & step : plan.steps) {
+    const MemberInfo & member = plan.type_info->members_[step.member_index];
+    const MemberInfo_Cpp & member_cpp = plan.type_info_cpp->members_[step.member_index];
+    if (0u != step.block_size) {
+      memcpy(to + member.offset_, from + member_cpp.offset_, step.block_size);
+      continue;
+    }
+    convert_member_cpp_to_c(
+      member, member_cpp, plan.nested_plans[step.member_index].get(),
+      from + member_cpp.offset_, to + member.offset_);
+  }
+}
+
+}  // namespace impl
+
+MessageConverter::MessageConverter(const TypeInfo * type_info, const TypeInfo_Cpp * type_info_cpp)
+{
+  impl::PlanCache cache;
+  plan_ = impl::make_plan(type_info, type_info_cpp, cache);
+}
+
+const TypeInfo * MessageConverter::type_info() const
+{
+  return plan_->type_info;
+}
+
+const TypeInfo_Cpp * MessageConverter::type_info_cpp() const
+{
+  return plan_->type_info_cpp;
+}
+
+void MessageConverter::c_to_cpp(const RosMessage & from, RosMessage_Cpp & to) const
+{
+  impl::check_types(*plan_, from.type_info, to.type_info);
+  impl::convert_message_c_to_cpp(*plan_, from.data, to.data);
+}
+
+void MessageConverter::cpp_to_c(const RosMessage_Cpp & from, RosMessage & to) const
+{
+  impl::check_types(*plan_, to.type_info, from.type_info);
+  impl::convert_message_cpp_to_c(*plan_, from.data, to.data);
+}
+
+void c_to_cpp(const RosMessage & from, RosMessage_Cpp & to)
+{
+  MessageConverter(from.type_info, to.type_info).c_to_cpp(from, to);
+}
+
+void cpp_to_c(const RosMessage_Cpp & from, RosMessage & to)
+{
+  MessageConverter(to.type_info, from.type_info).cpp_to_c(from, to);
+}
+
+}  // namespace dynmsg
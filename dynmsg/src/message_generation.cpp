@@ -0,0 +1,323 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rosidl_runtime_c/string.h"
+#include "rosidl_runtime_c/string_functions.h"
+#include "rosidl_runtime_c/u16string.h"
+#include "rosidl_runtime_c/u16string_functions.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+
+#include "dynmsg/member_utils.hpp"
+#include "dynmsg/message_generation.hpp"
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+namespace
+{
+
+// SplitMix64, a small pseudo-random number generator whose output only depends on its seed, unlike
+// the distributions of the standard library, which differ between implementations
+class Random
+{
+public:
+  explicit Random(uint64_t seed)
+  : state_(seed)
+  {
+  }
+
+  uint64_t next()
+  {
+    uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  // Draw a number between min and max, inclusive.
+  // The modulo makes small numbers slightly more likely, which does not matter here.
+  uint64_t uniform(uint64_t min, uint64_t max)
+  {
+    const uint64_t range = max - min;
+    if (std::numeric_limits<uint64_t>::max() == range) {
+      return next();
+    }
+    return min + next() % (range + 1u);
+  }
+
+private:
+  uint64_t state_;
+};
+
+// Draw the length of a sequence or string, with a bound of 0 meaning unbounded
+size_t draw_length(Random & random, size_t min, size_t max, size_t bound)
+{
+  if (0u != bound) {
+    max = std::min(max, bound);
+  }
+  return random.uniform(std::min(min, max), max);
+}
+
+// Draw a multiple of 1/256 whose magnitude is below 2^15, which a float represents exactly
+double draw_floating_point(Random & random)
+{
+  const int64_t numerator = static_cast<int64_t>(random.uniform(0u, (1u << 24) - 1u)) - (1 << 23);
+  return static_cast<double>(numerator) / 256.0;
+}
+
+// Draw a character of the Basic Multilingual Plane that is neither a control character nor a
+// surrogate, so that strings of them can be converted to UTF-8
+uint16_t draw_wide_character(Random & random)
+{
+  constexpr uint16_t ascii_count = 0x7f - 0x20;
+  const uint16_t index = static_cast<uint16_t>(random.uniform(0u, ascii_count + 0xd800 - 0xa0 - 1));
+  return static_cast<uint16_t>(index < ascii_count ? 0x20 + index : 0xa0 + (index - ascii_count));
+}
+
+std::string draw_string(Random & random, size_t length)
+{
+  std::string string(length, ' ');
+  for (char & character : string) {
+    character = static_cast<char>(random.uniform(0x20, 0x7e));
+  }
+  return string;
+}
+
+std::u16string draw_wstring(Random & random, size_t length)
+{
+  std::u16string string(length, u' ');
+  for (char16_t & character : string) {
+    character = draw_wide_character(random);
+  }
+  return string;
+}
+
+template<typename T>
+void write_value(uint8_t * data, T value)
+{
+  memcpy(data, &value, sizeof(T));
+}
+
+// Write a random value of a primitive type, which has the same type ID and size in C and C++
+void generate_primitive(uint8_t type_id, uint8_t * data, Random & random)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+      write_value(data, static_cast<float>(draw_floating_point(random)));
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+      write_value(data, draw_floating_point(random));
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      write_value(data, static_cast<long double>(draw_floating_point(random)));
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_CHAR:
+      write_value(data, static_cast<uint8_t>(random.uniform(0u, 0x7f)));
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WCHAR:
+      write_value(data, draw_wide_character(random));
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+      write_value(data, 0u != (random.next() & 1u));
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT8:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT8:
+      write_value(data, static_cast<uint8_t>(random.next()));
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+      write_value(data, static_cast<uint16_t>(random.next()));
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+      write_value(data, static_cast<uint32_t>(random.next()));
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      write_value(data, random.next());
+      break;
+    default:
+      throw std::runtime_error("unknown type");
+  }
+}
+
+template<typename MemberInfoT>
+size_t draw_string_length(
+  const MemberInfoT & member, Random & random, const GenerationOptions & options)
+{
+  return draw_length(
+    random, options.min_string_length, options.max_string_length, member.string_upper_bound_);
+}
+
+template<typename MemberInfoT>
+size_t draw_sequence_length(
+  const MemberInfoT & member, Random & random, const GenerationOptions & options)
+{
+  return draw_length(
+    random, options.min_sequence_length, options.max_sequence_length,
+    member.is_upper_bound_ ? member.array_size_ : 0u);
+}
+
+void generate_message_c(
+  const TypeInfo * type_info, uint8_t * data, Random & random, const GenerationOptions & options);
+
+void generate_element_c(
+  const MemberInfo & member, uint8_t * data, Random & random, const GenerationOptions & options)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING: {
+        const std::string string = draw_string(random, draw_string_length(member, random, options));
+        if (!rosidl_runtime_c__String__assignn(
+            reinterpret_cast<rosidl_runtime_c__String *>(data), string.data(), string.size()))
+        {
+          throw std::runtime_error("error assigning rosidl string");
+        }
+        break;
+      }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING: {
+        const std::u16string string =
+          draw_wstring(random, draw_string_length(member, random, options));
+        if (!rosidl_runtime_c__U16String__assignn(
+            reinterpret_cast<rosidl_runtime_c__U16String *>(data),
+            reinterpret_cast<const uint16_t *>(string.data()), string.size()))
+        {
+          throw std::runtime_error("error assigning rosidl string");
+        }
+        break;
+      }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+      generate_message_c(c::get_nested_type_info(member), data, random, options);
+      break;
+    default:
+      generate_primitive(member.type_id_, data, random);
+      break;
+  }
+}
+
+void generate_message_c(
+  const TypeInfo * type_info, uint8_t * data, Random & random, const GenerationOptions & options)
+{
+  for (uint32_t ii = 0; ii < type_info->member_count_; ++ii) {
+    const MemberInfo & member = type_info->members_[ii];
+    uint8_t * member_data = data + member.offset_;
+    if (!member.is_array_) {
+      generate_element_c(member, member_data, random, options);
+      continue;
+    }
+    size_t count = member.array_size_;
+    uint8_t * elements = member_data;
+    if (c::is_sequence(member)) {
+      count = draw_sequence_length(member, random, options);
+      elements = c::resize_sequence(member, member_data, count);
+    }
+    const size_t element_size = c::get_element_size(member);
+    for (size_t jj = 0; jj < count; ++jj) {
+      generate_element_c(member, elements + jj * element_size, random, options);
+    }
+  }
+}
+
+void generate_message_cpp(
+  const TypeInfo_Cpp * type_info, uint8_t * data, Random & random,
+  const GenerationOptions & options);
+
+void generate_element_cpp(
+  const MemberInfo_Cpp & member, uint8_t * data, Random & random,
+  const GenerationOptions & options)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING:
+      *reinterpret_cast<std::string *>(data) =
+        draw_string(random, draw_string_length(member, random, options));
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING:
+      *reinterpret_cast<std::u16string *>(data) =
+        draw_wstring(random, draw_string_length(member, random, options));
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE:
+      generate_message_cpp(cpp::get_nested_type_info(member), data, random, options);
+      break;
+    default:
+      generate_primitive(member.type_id_, data, random);
+      break;
+  }
+}
+
+void generate_message_cpp(
+  const TypeInfo_Cpp * type_info, uint8_t * data, Random & random,
+  const GenerationOptions & options)
+{
+  for (uint32_t ii = 0; ii < type_info->member_count_; ++ii) {
+    const MemberInfo_Cpp & member = type_info->members_[ii];
+    uint8_t * member_data = data + member.offset_;
+    if (!member.is_array_) {
+      generate_element_cpp(member, member_data, random, options);
+      continue;
+    }
+    size_t count = member.array_size_;
+    uint8_t * elements = member_data;
+    if (cpp::is_sequence(member)) {
+      count = draw_sequence_length(member, random, options);
+      elements = cpp::resize_sequence(member, member_data, count);
+      if (rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN == member.type_id_) {
+        // std::vector<bool> is different, see vector_utils.hpp
+        auto & bools = *reinterpret_cast<std::vector<bool> *>(member_data);
+        for (size_t jj = 0; jj < count; ++jj) {
+          bools[jj] = 0u != (random.next() & 1u);
+        }
+        continue;
+      }
+    }
+    const size_t element_size = cpp::get_element_size(member);
+    for (size_t jj = 0; jj < count; ++jj) {
+      generate_element_cpp(member, elements + jj * element_size, random, options);
+    }
+  }
+}
+
+}  // namespace
+
+namespace c
+{
+
+void generate_message(RosMessage & message, const GenerationOptions & options)
+{
+  Random random(options.seed);
+  generate_message_c(message.type_info, message.data, random, options);
+}
+
+}  // namespace c
+
+namespace cpp
+{
+
+void generate_message(RosMessage_Cpp & message, const GenerationOptions & options)
+{
+  Random random(options.seed);
+  generate_message_cpp(message.type_info, message.data, random, options);
+}
+
+}  // namespace cpp
+
+}  // namespace dynmsg
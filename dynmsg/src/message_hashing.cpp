@@ -0,0 +1,466 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "rosidl_runtime_c/string.h"
+#include "rosidl_runtime_c/u16string.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+
+#include "dynmsg/member_utils.hpp"
+#include "dynmsg/message_hashing.hpp"
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+namespace impl
+{
+
+// Streaming implementation of the XXH64 hash function
+// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+class Xxh64
+{
+public:
+  explicit Xxh64(uint64_t seed)
+  : seed_(seed),
+    v1_(seed + PRIME_1 + PRIME_2),
+    v2_(seed + PRIME_2),
+    v3_(seed),
+    v4_(seed - PRIME_1),
+    total_length_(0u),
+    buffer_size_(0u)
+  {}
+
+  void update(const uint8_t * data, size_t length)
+  {
+    total_length_ += length;
+    // Complete the stripe in the buffer first
+    if (buffer_size_ > 0u) {
+      const size_t to_copy = std::min(length, STRIPE_SIZE - buffer_size_);
+      memcpy(buffer_ + buffer_size_, data, to_copy);
+      buffer_size_ += to_copy;
+      data += to_copy;
+      length -= to_copy;
+      if (buffer_size_ < STRIPE_SIZE) {
+        return;
+      }
+      consume_stripe(buffer_);
+      buffer_size_ = 0u;
+    }
+    while (length >= STRIPE_SIZE) {
+      consume_stripe(data);
+      data += STRIPE_SIZE;
+      length -= STRIPE_SIZE;
+    }
+    if (length > 0u) {
+      memcpy(buffer_, data, length);
+      buffer_size_ = length;
+    }
+  }
+
+  uint64_t digest() const
+  {
+    uint64_t hash;
+    if (total_length_ >= STRIPE_SIZE) {
+      hash = rotl(v1_, 1) + rotl(v2_, 7) + rotl(v3_, 12) + rotl(v4_, 18);
+      hash = merge_round(hash, v1_);
+      hash = merge_round(hash, v2_);
+      hash = merge_round(hash, v3_);
+      hash = merge_round(hash, v4_);
+    } else {
+      hash = seed_ + PRIME_5;
+    }
+    hash += total_length_;
+
+    const uint8_t * data = buffer_;
+    size_t length = buffer_size_;
+    while (length >= 8u) {
+      hash ^= round(0u, read_64(data));
+      hash = rotl(hash, 27) * PRIME_1 + PRIME_4;
+      data += 8u;
+      length -= 8u;
+    }
+    if (length >= 4u) {
+      hash ^= static_cast<uint64_t>(read_32(data)) * PRIME_1;
+      hash = rotl(hash, 23) * PRIME_2 + PRIME_3;
+      data += 4u;
+      length -= 4u;
+    }
+    while (length > 0u) {
+      hash ^= static_cast<uint64_t>(*data) * PRIME_5;
+      hash = rotl(hash, 11) * PRIME_1;
+      ++data;
+      --length;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+  }
+
+private:
+  static constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+  static constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+  static constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+  static constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ull;
+  static constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ull;
+  static constexpr size_t STRIPE_SIZE = 32u;
+
+  static uint64_t rotl(uint64_t value, int bits)
+  {
+    return (value << bits) | (value >> (64 - bits));
+  }
+
+  static uint64_t read_64(const uint8_t * data)
+  {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  static uint32_t read_32(const uint8_t * data)
+  {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  static uint64_t round(uint64_t accumulator, uint64_t input)
+  {
+    accumulator += input * PRIME_2;
+    accumulator = rotl(accumulator, 31);
+    return accumulator * PRIME_1;
+  }
+
+  static uint64_t merge_round(uint64_t accumulator, uint64_t value)
+  {
+    accumulator ^= round(0u, value);
+    return accumulator * PRIME_1 + PRIME_4;
+  }
+
+  void consume_stripe(const uint8_t * stripe)
+  {
+    v1_ = round(v1_, read_64(stripe));
+    v2_ = round(v2_, read_64(stripe + 8u));
+    v3_ = round(v3_, read_64(stripe + 16u));
+    v4_ = round(v4_, read_64(stripe + 24u));
+  }
+
+  uint64_t seed_;
+  uint64_t v1_;
+  uint64_t v2_;
+  uint64_t v3_;
+  uint64_t v4_;
+  uint64_t total_length_;
+  uint8_t buffer_[STRIPE_SIZE];
+  size_t buffer_size_;
+};
+
+// Seed offset for the second half of 128-bit hashes
+constexpr uint64_t HASH_128_SEED_OFFSET = 0x9E3779B97F4A7C15ull;
+
+// Receives the canonical byte stream of a message and feeds it to one or two hash states
+template<size_t NumHashes>
+class HashSink
+{
+public:
+  explicit HashSink(uint64_t seed)
+  : hashes_{Xxh64(seed), Xxh64(seed + HASH_128_SEED_OFFSET)}
+  {}
+
+  void update(const void * data, size_t length)
+  {
+    if (0u == length) {
+      return;
+    }
+    for (size_t ii = 0; ii < NumHashes; ++ii) {
+      hashes_[ii].update(static_cast<const uint8_t *>(data), length);
+    }
+  }
+
+  // Sizes of strings and sequences are always hashed as 64-bit values
+  void update_size(size_t size)
+  {
+    const uint64_t size_64 = size;
+    update(&size_64, sizeof(size_64));
+  }
+
+  // long double values are not portable and usually contain padding bytes
+  void update_long_double(const uint8_t * data)
+  {
+    long double value;
+    memcpy(&value, data, sizeof(value));
+    const double value_double = static_cast<double>(value);
+    update(&value_double, sizeof(value_double));
+  }
+
+  uint64_t digest(size_t index) const
+  {
+    return hashes_[index].digest();
+  }
+
+private:
+  Xxh64 hashes_[2];
+};
+
+// Check if a member is stored inline and its bytes can be hashed directly
+template<typename MemberInfoT>
+bool is_inline_primitive(const MemberInfoT & member, bool member_is_sequence)
+{
+  return !member_is_sequence && is_primitive_type(member.type_id_) &&
+         rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE != member.type_id_;
+}
+
+}  // namespace impl
+
+namespace c
+{
+
+namespace impl
+{
+
+template<typename Sink>
+void hash_message_impl(const TypeInfo * type_info, const uint8_t * data, Sink & sink);
+
+template<typename Sink>
+void hash_element(const MemberInfo & member, const uint8_t * element, Sink & sink)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING: {
+        const auto * string = reinterpret_cast<const rosidl_runtime_c__String *>(element);
+        sink.update_size(string->size);
+        sink.update(string->data, string->size);
+        break;
+      }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING: {
+        const auto * string = reinterpret_cast<const rosidl_runtime_c__U16String *>(element);
+        sink.update_size(string->size);
+        sink.update(string->data, string->size * sizeof(uint16_t));
+        break;
+      }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+      hash_message_impl(get_nested_type_info(member), element, sink);
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      sink.update_long_double(element);
+      break;
+    default:
+      sink.update(element, get_element_size(member));
+      break;
+  }
+}
+
+template<typename Sink>
+void hash_member(const MemberInfo & member, const uint8_t * member_data, Sink & sink)
+{
+  if (!member.is_array_) {
+    hash_element(member, member_data, sink);
+    return;
+  }
+  const size_t count = get_element_count(member, member_data);
+  if (is_sequence(member)) {
+    sink.update_size(count);
+  }
+  const uint8_t * elements = get_element_data(member, member_data);
+  const size_t element_size = get_element_size(member);
+  if (dynmsg::impl::is_inline_primitive(member, false)) {
+    sink.update(elements, count * element_size);
+    return;
+  }
+  for (size_t ii = 0; ii < count; ++ii) {
+    hash_element(member, elements + ii * element_size, sink);
+  }
+}
+
+template<typename Sink>
+void hash_message_impl(const TypeInfo * type_info, const uint8_t * data, Sink & sink)
+{
+  uint32_t ii = 0;
+  while (ii < type_info->member_count_) {
+    // Hash runs of contiguous inline primitive members as a single block
+    const uint32_t run_begin = ii;
+    size_t run_size = 0u;
+    while (ii < type_info->member_count_) {
+      const MemberInfo & member = type_info->members_[ii];
+      if (!dynmsg::impl::is_inline_primitive(member, is_sequence(member)) ||
+        type_info->members_[run_begin].offset_ + run_size != member.offset_)
+      {
+        break;
+      }
+      run_size += get_element_size(member) * get_element_count(member, nullptr);
+      ++ii;
+    }
+    if (ii > run_begin) {
+      sink.update(data + type_info->members_[run_begin].offset_, run_size);
+      continue;
+    }
+    const MemberInfo & member = type_info->members_[ii];
+    hash_member(member, data + member.offset_, sink);
+    ++ii;
+  }
+}
+
+}  // namespace impl
+
+uint64_t hash_message(const RosMessage & message, uint64_t seed)
+{
+  dynmsg::impl::HashSink<1> sink(seed);
+  impl::hash_message_impl(message.type_info, message.data, sink);
+  return sink.digest(0);
+}
+
+Hash128 hash_message_128(const RosMessage & message, uint64_t seed)
+{
+  dynmsg::impl::HashSink<2> sink(seed);
+  impl::hash_message_impl(message.type_info, message.data, sink);
+  return Hash128{sink.digest(0), sink.digest(1)};
+}
+
+}  // namespace c
+
+namespace cpp
+{
+
+namespace impl
+{
+
+template<typename Sink>
+void hash_message_impl(const TypeInfo_Cpp * type_info, const uint8_t * data, Sink & sink);
+
+template<typename Sink>
+void hash_element(const MemberInfo_Cpp & member, const uint8_t * element, Sink & sink)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING: {
+        const auto * string = reinterpret_cast<const std::string *>(element);
+        sink.update_size(string->size());
+        sink.update(string->data(), string->size());
+        break;
+      }
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING: {
+        const auto * string = reinterpret_cast<const std::u16string *>(element);
+        sink.update_size(string->size());
+        sink.update(string->data(), string->size() * sizeof(char16_t));
+        break;
+      }
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE:
+      hash_message_impl(get_nested_type_info(member), element, sink);
+      break;
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_LONG_DOUBLE:
+      sink.update_long_double(element);
+      break;
+    default:
+      sink.update(element, get_element_size(member));
+      break;
+  }
+}
+
+// std::vector<bool> is different, see vector_utils.hpp
+// The booleans are hashed as bytes, like in the C representation
+template<typename Sink>
+void hash_bool_sequence(const std::vector<bool> & sequence, Sink & sink)
+{
+  uint8_t buffer[256];
+  size_t buffer_size = 0u;
+  for (const bool value : sequence) {
+    buffer[buffer_size++] = value ? 1u : 0u;
+    if (sizeof(buffer) == buffer_size) {
+      sink.update(buffer, buffer_size);
+      buffer_size = 0u;
+    }
+  }
+  sink.update(buffer, buffer_size);
+}
+
+template<typename Sink>
+void hash_member(const MemberInfo_Cpp & member, const uint8_t * member_data, Sink & sink)
+{
+  if (!member.is_array_) {
+    hash_element(member, member_data, sink);
+    return;
+  }
+  const size_t count = get_element_count(member, member_data);
+  if (is_sequence(member)) {
+    sink.update_size(count);
+    if (rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN == member.type_id_) {
+      hash_bool_sequence(*reinterpret_cast<const std::vector<bool> *>(member_data), sink);
+      return;
+    }
+  }
+  const uint8_t * elements = get_element_data(member, member_data);
+  const size_t element_size = get_element_size(member);
+  if (dynmsg::impl::is_inline_primitive(member, false)) {
+    sink.update(elements, count * element_size);
+    return;
+  }
+  for (size_t ii = 0; ii < count; ++ii) {
+    hash_element(member, elements + ii * element_size, sink);
+  }
+}
+
+template<typename Sink>
+void hash_message_impl(const TypeInfo_Cpp * type_info, const uint8_t * data, Sink & sink)
+{
+  uint32_t ii = 0;
+  while (ii < type_info->member_count_) {
+    // Hash runs of contiguous inline primitive members as a single block
+    const uint32_t run_begin = ii;
+    size_t run_size = 0u;
+    while (ii < type_info->member_count_) {
+      const MemberInfo_Cpp & member = type_info->members_[ii];
+      if (!dynmsg::impl::is_inline_primitive(member, is_sequence(member)) ||
+        type_info->members_[run_begin].offset_ + run_size != member.offset_)
+      {
+        break;
+      }
+      run_size += get_element_size(member) * get_element_count(member, nullptr);
+      ++ii;
+    }
+    if (ii > run_begin) {
+      sink.update(data + type_info->members_[run_begin].offset_, run_size);
+      continue;
+    }
+    const MemberInfo_Cpp & member = type_info->members_[ii];
+    hash_member(member, data + member.offset_, sink);
+    ++ii;
+  }
+}
+
+}  // namespace impl
+
+uint64_t hash_message(const RosMessage_Cpp & message, uint64_t seed)
+{
+  dynmsg::impl::HashSink<1> sink(seed);
+  impl::hash_message_impl(message.type_info, message.data, sink);
+  return sink.digest(0);
+}
+
+Hash128 hash_message_128(const RosMessage_Cpp & message, uint64_t seed)
+{
+  dynmsg::impl::HashSink<2> sink(seed);
+  impl::hash_message_impl(message.type_info, message.data, sink);
+  return Hash128{sink.digest(0), sink.digest(1)};
+}
+
+}  // namespace cpp
+
+}  // namespace dynmsg
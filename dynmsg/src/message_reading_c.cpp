@@ -25,8 +25,12 @@
 #include "rosidl_typesupport_introspection_c/field_types.h"
 
 #include "dynmsg/config.hpp"
+#include "dynmsg/memory_tracking.hpp"
 #include "dynmsg/message_reading.hpp"
+#include "dynmsg/metrics.hpp"
+#include "dynmsg/profiling.hpp"
 #include "dynmsg/string_utils.hpp"
+#include "dynmsg/tracing.hpp"
 #include "dynmsg/typesupport.hpp"
 
 namespace dynmsg
@@ -502,6 +506,8 @@ dynamic_array_to_yaml(
       element_size = nested_member.type_info->size_of_;
       size_t element_count;
       element_count = static_cast<size_t>(member_data[sizeof(void *)]);
+      DYNMSG_TRACE(
+        tracing::CATEGORY_READER, "dynamic_array_to_yaml", member_info.name_, element_count);
       for (size_t ii = 0; ii < element_count; ++ii) {
         nested_member.data = element_data + ii * element_size;
         // Recursively read the nested type into the array element in the YAML representation
@@ -537,6 +543,8 @@ YAML::Node member_to_yaml(
   const MemberInfo & member_info,
   uint8_t * member_data)
 {
+  DYNMSG_TRACE(
+    tracing::CATEGORY_READER, "member_to_yaml", member_info.name_, member_info.type_id_);
   YAML::Node member;
 #ifndef DYNMSG_VALUE_ONLY
   member["type"] = member_type_to_string(member_info);
@@ -583,17 +591,33 @@ YAML::Node member_to_yaml(
 YAML::Node
 message_to_yaml(const RosMessage & message)
 {
+  memory_tracking::impl::ConversionScope track_memory;
+  metrics::impl::ConversionScope measure_conversion(
+    metrics::Operation::c_to_yaml, message.type_info, message.type_info->message_namespace_,
+    message.type_info->message_name_);
+  measure_conversion.count_message(message);
+  profiling::impl::MessageScope profile_message(
+    "c.to_yaml", message.type_info->message_namespace_, message.type_info->message_name_);
   YAML::Node yaml_msg;
+  DYNMSG_TRACE(
+    tracing::CATEGORY_READER, "message_to_yaml", message.type_info->message_name_,
+    message.type_info->member_count_);
   // Iterate over the members of the message, converting the binary data for each into a node in
   // the YAML representation
-  for (uint32_t ii = 0; ii < message.type_info->member_count_; ++ii) {
-    // Get the introspection information for this particular member
-    const MemberInfo & member_info = message.type_info->members_[ii];
-    // Get a pointer to the member's data in the binary buffer
-    uint8_t * member_data = &message.data[member_info.offset_];
-    // Recursively (because some members may be non-primitive types themeslves) convert the member
-    // to YAML
-    yaml_msg[member_info.name_] = dynmsg::c::impl::member_to_yaml(member_info, member_data);
+  try {
+    for (uint32_t ii = 0; ii < message.type_info->member_count_; ++ii) {
+      // Get the introspection information for this particular member
+      const MemberInfo & member_info = message.type_info->members_[ii];
+      profiling::impl::MemberScope profile_member(member_info.name_);
+      // Get a pointer to the member's data in the binary buffer
+      uint8_t * member_data = &message.data[member_info.offset_];
+      // Recursively (because some members may be non-primitive types themeslves) convert the member
+      // to YAML
+      yaml_msg[member_info.name_] = dynmsg::c::impl::member_to_yaml(member_info, member_data);
+    }
+  } catch (...) {
+    measure_conversion.failed(metrics::ErrorKind::conversion);
+    throw;
   }
   return yaml_msg;
 }
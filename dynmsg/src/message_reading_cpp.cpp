@@ -13,7 +13,6 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -22,8 +21,13 @@
 #include "rosidl_typesupport_introspection_cpp/field_types.hpp"
 
 #include "dynmsg/config.hpp"
+#include "dynmsg/member_utils.hpp"
+#include "dynmsg/memory_tracking.hpp"
 #include "dynmsg/message_reading.hpp"
+#include "dynmsg/metrics.hpp"
+#include "dynmsg/profiling.hpp"
 #include "dynmsg/string_utils.hpp"
+#include "dynmsg/tracing.hpp"
 #include "dynmsg/typesupport.hpp"
 #include "dynmsg/vector_utils.hpp"
 
@@ -133,7 +137,6 @@ member_type_to_string(const MemberInfo_Cpp & member_info)
 size_t
 size_of_member_type(uint8_t type_id)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: size_of_member_type: " << (int)type_id << std::endl);
   switch (type_id) {
     case rosidl_typesupport_introspection_cpp::ROS_TYPE_FLOAT:
       return sizeof(float);
@@ -184,8 +187,6 @@ void member_to_yaml_array_item(
   const uint8_t * member_data,
   YAML::Node & array_node)
 {
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: member_to_yaml_array_item: " << (int)member_info.type_id_ << std::endl);
   switch (member_info.type_id_) {
     case rosidl_typesupport_introspection_cpp::ROS_TYPE_FLOAT:
       array_node.push_back(*reinterpret_cast<const float *>(member_data));
@@ -276,9 +277,6 @@ void basic_value_to_yaml(
   const uint8_t * member_data,
   YAML::Node & member)
 {
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: basic_value_to_yaml: " <<
-      member_info.name_ << ":" << (int)member_info.type_id_ << std::endl);
   // return;
   switch (member_info.type_id_) {
     case rosidl_typesupport_introspection_cpp::ROS_TYPE_FLOAT:
@@ -343,10 +341,6 @@ void basic_value_to_yaml(
       member["value"] = *reinterpret_cast<const int64_t *>(member_data);
       break;
     case rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING:
-      DYNMSG_DEBUG(std::cout << "DEBUG: basic_value_to_yaml() string: " << std::flush);
-      DYNMSG_DEBUG(
-        std::cout << (member_data == nullptr ? "NULL" : "not null") << std::flush <<
-          ", size=" << reinterpret_cast<const std::string *>(member_data)->size() << std::endl);
       member["value"] = *reinterpret_cast<const std::string *>(member_data);
       break;
     case rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING:
@@ -376,8 +370,6 @@ dynamic_array_to_yaml_impl(
   const std::vector<T> * v,
   YAML::Node & array_node)
 {
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: dynamic_array_to_yaml_impl: " << (int)member_info.type_id_ << std::endl);
   std::vector<T> * vn = const_cast<std::vector<T> *>(v);
   for (size_t ii = 0; ii < vn->size(); ++ii) {
     member_to_yaml_array_item(
@@ -394,13 +386,10 @@ dynamic_array_to_yaml_impl_bool(
   const std::vector<bool> * v,
   YAML::Node & array_node)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: dynamic_array_to_yaml_impl_bool" << std::endl);
   static_cast<void>(member_info);
   for (size_t ii = 0; ii < v->size(); ++ii) {
-    DYNMSG_DEBUG(std::cout << (v->operator[](ii) ? "true" : "false") << ", ");
     array_node.push_back(v->operator[](ii));
   }
-  DYNMSG_DEBUG(std::cout << std::endl);
 }
 
 // Convert a dynamically-sized sequence to YAML
@@ -410,8 +399,6 @@ dynamic_array_to_yaml(
   const uint8_t * member_data,
   YAML::Node & array_node)
 {
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: dynamic_array_to_yaml: " << (int)member_info.type_id_ << std::endl);
   switch (member_info.type_id_) {
     case rosidl_typesupport_introspection_cpp::ROS_TYPE_FLOAT:
       dynamic_array_to_yaml_impl(
@@ -520,16 +507,16 @@ dynamic_array_to_yaml(
       // compile-time, but we know it's a vector and we know the size of the contained type.
       RosMessage_Cpp nested_member;
       nested_member.type_info = reinterpret_cast<const TypeInfo_Cpp *>(member_info.members_->data);
-      uint8_t * element_data;
-      memcpy(&element_data, member_data, sizeof(void *));
+      const uint8_t * element_data;
+      element_data = dynmsg::cpp::get_element_data(member_info, member_data);
       size_t element_size;
       element_size = nested_member.type_info->size_of_;
       size_t element_count;
-      element_count = dynmsg::get_vector_size(member_data, element_size);
-      DYNMSG_DEBUG(std::cout << "\telement_size=" << element_size << std::endl);
-      DYNMSG_DEBUG(std::cout << "\telement_count=" << element_count << std::endl);
+      element_count = dynmsg::cpp::get_element_count(member_info, member_data);
+      DYNMSG_TRACE(
+        tracing::CATEGORY_READER, "dynamic_array_to_yaml", member_info.name_, element_count);
       for (size_t ii = 0; ii < element_count; ++ii) {
-        nested_member.data = element_data + ii * element_size;
+        nested_member.data = const_cast<uint8_t *>(element_data + ii * element_size);
         // Recursively read the nested type into the array element in the YAML representation
         array_node.push_back(message_to_yaml(nested_member));
       }
@@ -546,15 +533,12 @@ void fixed_array_to_yaml(
   uint8_t * member_data,
   YAML::Node & array_node)
 {
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: fixed_array_to_yaml: " << (int)member_info.type_id_ << std::endl);
   size_t element_size(0);
   if (member_info.type_id_ == rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE) {
     element_size = reinterpret_cast<const TypeInfo_Cpp *>(member_info.members_->data)->size_of_;
   } else {
     element_size = size_of_member_type(member_info.type_id_);
   }
-  DYNMSG_DEBUG(std::cout << element_size << ", " << member_info.array_size_ << std::endl);
   for (size_t ii = 0; ii < member_info.array_size_; ++ii) {
     member_to_yaml_array_item(member_info, &member_data[ii * element_size], array_node);
   }
@@ -565,7 +549,8 @@ YAML::Node member_to_yaml(
   const MemberInfo_Cpp & member_info,
   uint8_t * member_data)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: member_to_yaml: " << (int)member_info.type_id_ << std::endl);
+  DYNMSG_TRACE(
+    tracing::CATEGORY_READER, "member_to_yaml", member_info.name_, member_info.type_id_);
   YAML::Node member;
 #ifndef DYNMSG_VALUE_ONLY
   member["type"] = member_type_to_string(member_info);
@@ -612,27 +597,35 @@ YAML::Node member_to_yaml(
 YAML::Node
 message_to_yaml(const RosMessage_Cpp & message)
 {
+  memory_tracking::impl::ConversionScope track_memory;
+  metrics::impl::ConversionScope measure_conversion(
+    metrics::Operation::cpp_to_yaml, message.type_info, message.type_info->message_namespace_,
+    message.type_info->message_name_);
+  measure_conversion.count_message(message);
+  profiling::impl::MessageScope profile_message(
+    "cpp.to_yaml", message.type_info->message_namespace_, message.type_info->message_name_);
   YAML::Node yaml_msg;
 
-  DYNMSG_DEBUG(std::cout << "DEBUG: message_to_yaml" << std::endl);
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: message.type_info message_namespace_: " <<
-      message.type_info->message_namespace_ << std::endl);
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: message.type_info message_name_: " <<
-      message.type_info->message_name_ << std::endl);
+  DYNMSG_TRACE(
+    tracing::CATEGORY_READER, "message_to_yaml", message.type_info->message_name_,
+    message.type_info->member_count_);
 
   // Iterate over the members of the message, converting the binary data for each into a node in
   // the YAML representation
-  for (uint32_t ii = 0; ii < message.type_info->member_count_; ++ii) {
-    // Get the introspection information for this particular member
-    const MemberInfo_Cpp & member_info = message.type_info->members_[ii];
-    DYNMSG_DEBUG(std::cout << "DEBUG: member_info name: " << member_info.name_ << std::endl);
-    // Get a pointer to the member's data in the binary buffer
-    uint8_t * member_data = &message.data[member_info.offset_];
-    // Recursively (because some members may be non-primitive types themeslves) convert the member
-    // to YAML
-    yaml_msg[member_info.name_] = impl::member_to_yaml(member_info, member_data);
+  try {
+    for (uint32_t ii = 0; ii < message.type_info->member_count_; ++ii) {
+      // Get the introspection information for this particular member
+      const MemberInfo_Cpp & member_info = message.type_info->members_[ii];
+      profiling::impl::MemberScope profile_member(member_info.name_);
+      // Get a pointer to the member's data in the binary buffer
+      uint8_t * member_data = &message.data[member_info.offset_];
+      // Recursively (because some members may be non-primitive types themeslves) convert the member
+      // to YAML
+      yaml_msg[member_info.name_] = impl::member_to_yaml(member_info, member_data);
+    }
+  } catch (...) {
+    measure_conversion.failed(metrics::ErrorKind::conversion);
+    throw;
   }
   return yaml_msg;
 }
@@ -0,0 +1,505 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <climits>
+#include <string>
+#include <vector>
+
+#include "rosidl_runtime_c/string.h"
+#include "rosidl_runtime_c/u16string.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+
+#include "dynmsg/member_utils.hpp"
+#include "dynmsg/message_size.hpp"
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+namespace impl
+{
+
+// CDR representation of the types, as implemented by Fast-CDR
+// The type IDs are the same for the C and C++ introspection type supports
+size_t cdr_primitive_size(uint8_t type_id)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+      return 4u;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+      return 8u;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      return 16u;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WCHAR:
+      // Serialized as a wchar_t
+      return 4u;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+      return 2u;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+      return 4u;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+      return 8u;
+    default:
+      // char, bool, octet, uint8, int8
+      return 1u;
+  }
+}
+
+size_t cdr_alignment(size_t size)
+{
+  return size > 8u ? 8u : size;
+}
+
+// Size of the length prefix of strings and sequences
+constexpr size_t CDR_LENGTH_SIZE = 4u;
+// Size of a serialized wstring character
+constexpr size_t CDR_WCHAR_SIZE = 4u;
+
+// Keeps track of the size of a CDR stream, i.e. the current offset, with alignment
+class CdrSizeCounter
+{
+public:
+  void add(size_t alignment, size_t size)
+  {
+    size_ += (alignment - size_ % alignment) % alignment + size;
+  }
+
+  void add_string(size_t length)
+  {
+    // Null-terminated
+    add(CDR_LENGTH_SIZE, CDR_LENGTH_SIZE + length + 1u);
+  }
+
+  void add_wstring(size_t length)
+  {
+    add(CDR_LENGTH_SIZE, CDR_LENGTH_SIZE);
+    if (0u != length) {
+      add(CDR_WCHAR_SIZE, length * CDR_WCHAR_SIZE);
+    }
+  }
+
+  void add_primitives(uint8_t type_id, size_t count)
+  {
+    if (0u != count) {
+      const size_t size = cdr_primitive_size(type_id);
+      add(cdr_alignment(size), count * size);
+    }
+  }
+
+  size_t size() const
+  {
+    return size_;
+  }
+
+private:
+  size_t size_ = 0u;
+};
+
+// Keeps track of an upper bound of the size of a CDR stream
+// Once the exact offset is unknown, the worst-case padding is assumed for each alignment
+class CdrMaxSizeCounter
+{
+public:
+  void add(size_t alignment, size_t size)
+  {
+    if (exact_) {
+      size_ += (alignment - size_ % alignment) % alignment;
+    } else {
+      size_ += alignment - 1u;
+    }
+    size_ += size;
+  }
+
+  void add_primitives(uint8_t type_id, size_t count)
+  {
+    if (0u != count) {
+      const size_t size = cdr_primitive_size(type_id);
+      add(cdr_alignment(size), count * size);
+    }
+  }
+
+  // The actual size may be smaller than the maximum size counted so far
+  void set_inexact()
+  {
+    exact_ = false;
+  }
+
+  size_t size() const
+  {
+    return size_;
+  }
+
+private:
+  size_t size_ = 0u;
+  bool exact_ = true;
+};
+
+inline const TypeInfo * nested_type_info(const MemberInfo & member)
+{
+  return c::get_nested_type_info(member);
+}
+
+inline const TypeInfo_Cpp * nested_type_info(const MemberInfo_Cpp & member)
+{
+  return cpp::get_nested_type_info(member);
+}
+
+inline bool member_is_sequence(const MemberInfo & member)
+{
+  return c::is_sequence(member);
+}
+
+inline bool member_is_sequence(const MemberInfo_Cpp & member)
+{
+  return cpp::is_sequence(member);
+}
+
+// Compute the maximum size of a message type, using only its introspection information
+// This is the same for the C and C++ introspection information
+template<typename TypeInfoT>
+void add_type_max_size(
+  const TypeInfoT * type_info,
+  CdrMaxSizeCounter & counter,
+  SerializedSizeInfo & info)
+{
+  for (uint32_t ii = 0; ii < type_info->member_count_; ++ii) {
+    const auto & member = type_info->members_[ii];
+    size_t count = 1u;
+    if (member.is_array_) {
+      // Unbounded sequences have an array size of 0
+      count = member.array_size_;
+      if (member_is_sequence(member)) {
+        info.is_fixed = false;
+        if (!member.is_upper_bound_) {
+          info.is_bounded = false;
+          return;
+        }
+        counter.add(CDR_LENGTH_SIZE, CDR_LENGTH_SIZE);
+      }
+    }
+    switch (member.type_id_) {
+      case rosidl_typesupport_introspection_c__ROS_TYPE_STRING:
+      case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING: {
+          info.is_fixed = false;
+          if (0u == member.string_upper_bound_) {
+            info.is_bounded = false;
+            return;
+          }
+          const bool is_wstring =
+            rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING == member.type_id_;
+          for (size_t jj = 0; jj < count; ++jj) {
+            counter.add(CDR_LENGTH_SIZE, CDR_LENGTH_SIZE);
+            if (is_wstring) {
+              counter.add(CDR_WCHAR_SIZE, member.string_upper_bound_ * CDR_WCHAR_SIZE);
+            } else {
+              counter.add(1u, member.string_upper_bound_ + 1u);
+            }
+            counter.set_inexact();
+          }
+          break;
+        }
+      case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+        for (size_t jj = 0; jj < count; ++jj) {
+          add_type_max_size(nested_type_info(member), counter, info);
+          if (!info.is_bounded) {
+            return;
+          }
+        }
+        break;
+      default:
+        counter.add_primitives(member.type_id_, count);
+        break;
+    }
+    if (!info.is_fixed) {
+      // Bounded strings and sequences may be shorter than their bound
+      counter.set_inexact();
+    }
+  }
+}
+
+template<typename TypeInfoT>
+SerializedSizeInfo get_serialized_size_info(const TypeInfoT * type_info)
+{
+  SerializedSizeInfo info{true, true, 0u};
+  CdrMaxSizeCounter counter;
+  add_type_max_size(type_info, counter, info);
+  if (info.is_bounded) {
+    info.max_size = CDR_ENCAPSULATION_SIZE + counter.size();
+  }
+  return info;
+}
+
+}  // namespace impl
+
+namespace c
+{
+
+namespace impl
+{
+
+void add_message_size(
+  const TypeInfo * type_info,
+  const uint8_t * data,
+  dynmsg::impl::CdrSizeCounter & counter);
+
+void add_member_size(
+  const MemberInfo & member,
+  const uint8_t * member_data,
+  dynmsg::impl::CdrSizeCounter & counter)
+{
+  const size_t count = get_element_count(member, member_data);
+  if (is_sequence(member)) {
+    counter.add(dynmsg::impl::CDR_LENGTH_SIZE, dynmsg::impl::CDR_LENGTH_SIZE);
+  }
+  if (is_primitive_type(member.type_id_)) {
+    counter.add_primitives(member.type_id_, count);
+    return;
+  }
+  const uint8_t * elements = get_element_data(member, member_data);
+  const size_t element_size = get_element_size(member);
+  for (size_t ii = 0; ii < count; ++ii) {
+    const uint8_t * element = elements + ii * element_size;
+    switch (member.type_id_) {
+      case rosidl_typesupport_introspection_c__ROS_TYPE_STRING:
+        counter.add_string(reinterpret_cast<const rosidl_runtime_c__String *>(element)->size);
+        break;
+      case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING:
+        counter.add_wstring(reinterpret_cast<const rosidl_runtime_c__U16String *>(element)->size);
+        break;
+      default:
+        add_message_size(get_nested_type_info(member), element, counter);
+        break;
+    }
+  }
+}
+
+void add_message_size(
+  const TypeInfo * type_info,
+  const uint8_t * data,
+  dynmsg::impl::CdrSizeCounter & counter)
+{
+  for (uint32_t ii = 0; ii < type_info->member_count_; ++ii) {
+    const MemberInfo & member = type_info->members_[ii];
+    add_member_size(member, data + member.offset_, counter);
+  }
+}
+
+size_t message_heap_bytes(const TypeInfo * type_info, const uint8_t * data);
+
+size_t element_heap_bytes(const MemberInfo & member, const uint8_t * element)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING: {
+        const auto string = reinterpret_cast<const rosidl_runtime_c__String *>(element);
+        return nullptr == string->data ? 0u : string->capacity;
+      }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING: {
+        const auto string = reinterpret_cast<const rosidl_runtime_c__U16String *>(element);
+        return nullptr == string->data ? 0u : string->capacity * sizeof(uint16_t);
+      }
+    case rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE:
+      return message_heap_bytes(get_nested_type_info(member), element);
+    default:
+      return 0u;
+  }
+}
+
+size_t member_heap_bytes(const MemberInfo & member, const uint8_t * member_data)
+{
+  size_t bytes = 0u;
+  if (is_sequence(member)) {
+    bytes += get_element_capacity(member, member_data) * get_element_size(member);
+  }
+  if (is_primitive_type(member.type_id_)) {
+    return bytes;
+  }
+  const size_t count = get_element_count(member, member_data);
+  const uint8_t * elements = get_element_data(member, member_data);
+  const size_t element_size = get_element_size(member);
+  for (size_t ii = 0; ii < count; ++ii) {
+    bytes += element_heap_bytes(member, elements + ii * element_size);
+  }
+  return bytes;
+}
+
+size_t message_heap_bytes(const TypeInfo * type_info, const uint8_t * data)
+{
+  size_t bytes = 0u;
+  for (uint32_t ii = 0; ii < type_info->member_count_; ++ii) {
+    const MemberInfo & member = type_info->members_[ii];
+    bytes += member_heap_bytes(member, data + member.offset_);
+  }
+  return bytes;
+}
+
+}  // namespace impl
+
+size_t serialized_size(const RosMessage & message)
+{
+  dynmsg::impl::CdrSizeCounter counter;
+  impl::add_message_size(message.type_info, message.data, counter);
+  return CDR_ENCAPSULATION_SIZE + counter.size();
+}
+
+size_t heap_bytes(const RosMessage & message)
+{
+  return impl::message_heap_bytes(message.type_info, message.data);
+}
+
+SerializedSizeInfo get_serialized_size_info(const TypeInfo * type_info)
+{
+  return dynmsg::impl::get_serialized_size_info(type_info);
+}
+
+}  // namespace c
+
+namespace cpp
+{
+
+namespace impl
+{
+
+void add_message_size(
+  const TypeInfo_Cpp * type_info,
+  const uint8_t * data,
+  dynmsg::impl::CdrSizeCounter & counter);
+
+void add_member_size(
+  const MemberInfo_Cpp & member,
+  const uint8_t * member_data,
+  dynmsg::impl::CdrSizeCounter & counter)
+{
+  const size_t count = get_element_count(member, member_data);
+  if (is_sequence(member)) {
+    counter.add(dynmsg::impl::CDR_LENGTH_SIZE, dynmsg::impl::CDR_LENGTH_SIZE);
+  }
+  if (is_primitive_type(member.type_id_)) {
+    counter.add_primitives(member.type_id_, count);
+    return;
+  }
+  const uint8_t * elements = get_element_data(member, member_data);
+  const size_t element_size = get_element_size(member);
+  for (size_t ii = 0; ii < count; ++ii) {
+    const uint8_t * element = elements + ii * element_size;
+    switch (member.type_id_) {
+      case rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING:
+        counter.add_string(reinterpret_cast<const std::string *>(element)->size());
+        break;
+      case rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING:
+        counter.add_wstring(reinterpret_cast<const std::u16string *>(element)->size());
+        break;
+      default:
+        add_message_size(get_nested_type_info(member), element, counter);
+        break;
+    }
+  }
+}
+
+void add_message_size(
+  const TypeInfo_Cpp * type_info,
+  const uint8_t * data,
+  dynmsg::impl::CdrSizeCounter & counter)
+{
+  for (uint32_t ii = 0; ii < type_info->member_count_; ++ii) {
+    const MemberInfo_Cpp & member = type_info->members_[ii];
+    add_member_size(member, data + member.offset_, counter);
+  }
+}
+
+// Get the heap memory of a string, which is 0 if it is stored in the short string buffer
+template<typename StringT>
+size_t string_heap_bytes(const StringT & string)
+{
+  const auto data = reinterpret_cast<const uint8_t *>(string.data());
+  const auto object = reinterpret_cast<const uint8_t *>(&string);
+  if (data >= object && data < object + sizeof(StringT)) {
+    return 0u;
+  }
+  return (string.capacity() + 1u) * sizeof(typename StringT::value_type);
+}
+
+size_t message_heap_bytes(const TypeInfo_Cpp * type_info, const uint8_t * data);
+
+size_t element_heap_bytes(const MemberInfo_Cpp & member, const uint8_t * element)
+{
+  switch (member.type_id_) {
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING:
+      return string_heap_bytes(*reinterpret_cast<const std::string *>(element));
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING:
+      return string_heap_bytes(*reinterpret_cast<const std::u16string *>(element));
+    case rosidl_typesupport_introspection_cpp::ROS_TYPE_MESSAGE:
+      return message_heap_bytes(get_nested_type_info(member), element);
+    default:
+      return 0u;
+  }
+}
+
+size_t member_heap_bytes(const MemberInfo_Cpp & member, const uint8_t * member_data)
+{
+  size_t bytes = 0u;
+  if (is_sequence(member)) {
+    if (rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN == member.type_id_) {
+      // std::vector<bool> stores one bit per element
+      return get_element_capacity(member, member_data) / CHAR_BIT;
+    }
+    bytes += get_element_capacity(member, member_data) * get_element_size(member);
+  }
+  if (is_primitive_type(member.type_id_)) {
+    return bytes;
+  }
+  const size_t count = get_element_count(member, member_data);
+  const uint8_t * elements = get_element_data(member, member_data);
+  const size_t element_size = get_element_size(member);
+  for (size_t ii = 0; ii < count; ++ii) {
+    bytes += element_heap_bytes(member, elements + ii * element_size);
+  }
+  return bytes;
+}
+
+size_t message_heap_bytes(const TypeInfo_Cpp * type_info, const uint8_t * data)
+{
+  size_t bytes = 0u;
+  for (uint32_t ii = 0; ii < type_info->member_count_; ++ii) {
+    const MemberInfo_Cpp & member = type_info->members_[ii];
+    bytes += member_heap_bytes(member, data + member.offset_);
+  }
+  return bytes;
+}
+
+}  // namespace impl
+
+size_t serialized_size(const RosMessage_Cpp & message)
+{
+  dynmsg::impl::CdrSizeCounter counter;
+  impl::add_message_size(message.type_info, message.data, counter);
+  return CDR_ENCAPSULATION_SIZE + counter.size();
+}
+
+size_t heap_bytes(const RosMessage_Cpp & message)
+{
+  return impl::message_heap_bytes(message.type_info, message.data);
+}
+
+SerializedSizeInfo get_serialized_size_info(const TypeInfo_Cpp * type_info)
+{
+  return dynmsg::impl::get_serialized_size_info(type_info);
+}
+
+}  // namespace cpp
+
+}  // namespace dynmsg
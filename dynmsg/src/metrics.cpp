@@ -0,0 +1,487 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "dynmsg/message_size.hpp"
+#include "dynmsg/metrics.hpp"
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+namespace metrics
+{
+
+namespace impl
+{
+
+std::atomic<bool> enabled(false);
+
+}  // namespace impl
+
+namespace
+{
+
+// Number of shards of the counters of each series
+constexpr size_t SHARD_COUNT = 8u;
+// Latencies are counted in SUB_BUCKET_COUNT buckets for each power of two from 2^2 to
+// 2^MAX_EXPONENT nanoseconds, i.e. up to about two minutes, with one bucket for each of the
+// latencies below that
+constexpr uint64_t SUB_BUCKET_BITS = 2u;
+constexpr uint64_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+constexpr uint64_t MAX_EXPONENT = 36u;
+constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2u) * SUB_BUCKET_COUNT;
+// The Prometheus histogram has the same buckets in every export, bounded by each power of two from
+// 2^MIN_EXPORTED_EXPONENT to 2^(MAX_EXPONENT + 1) nanoseconds, which are also bucket bounds above
+constexpr uint64_t MIN_EXPORTED_EXPONENT = 8u;
+
+// Get the index of the bucket counting a latency
+size_t get_bucket_index(uint64_t value_ns)
+{
+  if (value_ns < SUB_BUCKET_COUNT) {
+    return static_cast<size_t>(value_ns);
+  }
+  uint64_t exponent = 63u - static_cast<uint64_t>(__builtin_clzll(value_ns));
+  if (exponent > MAX_EXPONENT) {
+    return BUCKET_COUNT - 1u;
+  }
+  const uint64_t sub_bucket = (value_ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1u);
+  return static_cast<size_t>((exponent - SUB_BUCKET_BITS + 1u) * SUB_BUCKET_COUNT + sub_bucket);
+}
+
+// Get the largest latency counted by a bucket
+uint64_t get_bucket_upper_bound(size_t index)
+{
+  if (index < SUB_BUCKET_COUNT) {
+    return index;
+  }
+  if (BUCKET_COUNT - 1u == index) {
+    return UINT64_MAX;
+  }
+  const uint64_t exponent = index / SUB_BUCKET_COUNT + SUB_BUCKET_BITS - 1u;
+  const uint64_t sub_bucket = index % SUB_BUCKET_COUNT;
+  return ((SUB_BUCKET_COUNT + sub_bucket + 1u) << (exponent - SUB_BUCKET_BITS)) - 1u;
+}
+
+// Counters updated by the threads using a shard
+struct Shard
+{
+  std::atomic<uint64_t> messages{0u};
+  std::atomic<uint64_t> bytes_in{0u};
+  std::atomic<uint64_t> bytes_out{0u};
+  std::array<std::atomic<uint64_t>, ERROR_KIND_COUNT> errors{};
+  std::atomic<uint64_t> latency_count{0u};
+  std::atomic<uint64_t> latency_sum_ns{0u};
+  std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+  // Keeps the counters of the next shard off the cache line of the last counters of this one
+  char padding[64];
+};
+
+void add(std::atomic<uint64_t> & counter, uint64_t value)
+{
+  counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t load(const std::atomic<uint64_t> & counter)
+{
+  return counter.load(std::memory_order_relaxed);
+}
+
+// Get the index of the shard used by the calling thread
+size_t get_shard_index()
+{
+  static std::atomic<size_t> next_index(0u);
+  thread_local const size_t index =
+    next_index.fetch_add(1u, std::memory_order_relaxed) % SHARD_COUNT;
+  return index;
+}
+
+int64_t now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+namespace impl
+{
+
+// The metrics of the conversions of a type through an API
+class Series
+{
+public:
+  Series(Operation operation, std::string type)
+  : operation(operation),
+    type(std::move(type))
+  {
+  }
+
+  const Operation operation;
+  const std::string type;
+  std::array<Shard, SHARD_COUNT> shards;
+};
+
+}  // namespace impl
+
+namespace
+{
+
+// All the series, which are never destroyed, so that threads can keep pointers to them
+struct Registry
+{
+  std::mutex mutex;
+  std::map<std::pair<int, const void *>, std::unique_ptr<impl::Series>> series;
+};
+
+Registry & get_registry()
+{
+  static Registry registry;
+  return registry;
+}
+
+impl::Series * get_series(
+  Operation operation, const void * type_info, const char * type_namespace, const char * type_name)
+{
+  // Each thread caches the series it uses, so that it only locks the registry once for each
+  using Key = std::pair<int, const void *>;
+  struct KeyHash
+  {
+    size_t operator()(const Key & key) const
+    {
+      return std::hash<const void *>()(key.second) ^ static_cast<size_t>(key.first);
+    }
+  };
+  thread_local std::unordered_map<Key, impl::Series *, KeyHash> cache;
+  const Key key(static_cast<int>(operation), type_info);
+  const auto cached = cache.find(key);
+  if (cached != cache.end()) {
+    return cached->second;
+  }
+
+  Registry & registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::unique_ptr<impl::Series> & series = registry.series[key];
+  if (!series) {
+    series.reset(new impl::Series(operation, get_type_name(type_namespace, type_name)));
+  }
+  cache.emplace(key, series.get());
+  return series.get();
+}
+
+// Number of conversions in progress on the calling thread
+uint32_t & get_depth()
+{
+  thread_local uint32_t depth = 0u;
+  return depth;
+}
+
+}  // namespace
+
+namespace impl
+{
+
+void ConversionScope::start(
+  Operation operation, const void * type_info, const char * type_namespace,
+  const char * type_name, size_t bytes_in)
+{
+  // Nested conversions are part of the outermost one
+  if (0u != get_depth()++) {
+    return;
+  }
+  series_ = get_series(operation, type_info, type_namespace, type_name);
+  bytes_in_ = bytes_in;
+  start_ns_ = now_ns();
+}
+
+void ConversionScope::finish()
+{
+  --get_depth();
+  if (nullptr == series_) {
+    return;
+  }
+  const uint64_t latency_ns = static_cast<uint64_t>(std::max<int64_t>(0, now_ns() - start_ns_));
+  Shard & shard = series_->shards[get_shard_index()];
+  if (has_error_) {
+    add(shard.errors[static_cast<size_t>(error_)], 1u);
+  } else {
+    add(shard.messages, 1u);
+  }
+  add(shard.latency_count, 1u);
+  add(shard.latency_sum_ns, latency_ns);
+  add(shard.buckets[get_bucket_index(latency_ns)], 1u);
+
+  // The converted message is sized after the latency is measured, so as not to count in it
+  size_t message_bytes = 0u;
+  if (nullptr != c_message_.data) {
+    message_bytes = c::serialized_size(c_message_);
+  } else if (nullptr != cpp_message_.data) {
+    message_bytes = cpp::serialized_size(cpp_message_);
+  }
+  if (Operation::c_to_yaml == series_->operation || Operation::cpp_to_yaml == series_->operation) {
+    add(shard.bytes_in, message_bytes);
+  } else {
+    add(shard.bytes_in, bytes_in_);
+    add(shard.bytes_out, message_bytes);
+  }
+}
+
+}  // namespace impl
+
+const char * get_operation_name(Operation operation)
+{
+  switch (operation) {
+    case Operation::c_to_yaml:
+      return "c.to_yaml";
+    case Operation::cpp_to_yaml:
+      return "cpp.to_yaml";
+    case Operation::c_from_yaml:
+      return "c.from_yaml";
+    case Operation::cpp_from_yaml:
+      return "cpp.from_yaml";
+  }
+  return "unknown";
+}
+
+const char * get_error_kind_name(ErrorKind kind)
+{
+  switch (kind) {
+    case ErrorKind::yaml:
+      return "yaml";
+    case ErrorKind::conversion:
+      return "conversion";
+    case ErrorKind::initialization:
+      return "initialization";
+  }
+  return "unknown";
+}
+
+void set_enabled(bool enabled)
+{
+  impl::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool is_enabled()
+{
+  return impl::enabled.load(std::memory_order_relaxed);
+}
+
+Snapshot get_snapshot()
+{
+  Snapshot snapshot;
+  Registry & registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const auto & entry : registry.series) {
+    const impl::Series & series = *entry.second;
+    SeriesSnapshot series_snapshot;
+    series_snapshot.operation = series.operation;
+    series_snapshot.type = series.type;
+    series_snapshot.messages = 0u;
+    series_snapshot.bytes_in = 0u;
+    series_snapshot.bytes_out = 0u;
+    series_snapshot.errors.fill(0u);
+    series_snapshot.latency.count = 0u;
+    series_snapshot.latency.sum_ns = 0u;
+    std::array<uint64_t, BUCKET_COUNT> buckets{};
+    for (const Shard & shard : series.shards) {
+      series_snapshot.messages += load(shard.messages);
+      series_snapshot.bytes_in += load(shard.bytes_in);
+      series_snapshot.bytes_out += load(shard.bytes_out);
+      for (size_t ii = 0; ii < ERROR_KIND_COUNT; ++ii) {
+        series_snapshot.errors[ii] += load(shard.errors[ii]);
+      }
+      series_snapshot.latency.count += load(shard.latency_count);
+      series_snapshot.latency.sum_ns += load(shard.latency_sum_ns);
+      for (size_t ii = 0; ii < BUCKET_COUNT; ++ii) {
+        buckets[ii] += load(shard.buckets[ii]);
+      }
+    }
+    for (size_t ii = 0; ii < BUCKET_COUNT; ++ii) {
+      if (0u != buckets[ii]) {
+        series_snapshot.latency.buckets.emplace_back(get_bucket_upper_bound(ii), buckets[ii]);
+      }
+    }
+    snapshot.series.push_back(std::move(series_snapshot));
+  }
+  std::sort(
+    snapshot.series.begin(), snapshot.series.end(),
+    [](const SeriesSnapshot & lhs, const SeriesSnapshot & rhs) {
+      return std::tie(lhs.type, lhs.operation) < std::tie(rhs.type, rhs.operation);
+    });
+  return snapshot;
+}
+
+void reset()
+{
+  Registry & registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const auto & entry : registry.series) {
+    for (Shard & shard : entry.second->shards) {
+      shard.messages.store(0u, std::memory_order_relaxed);
+      shard.bytes_in.store(0u, std::memory_order_relaxed);
+      shard.bytes_out.store(0u, std::memory_order_relaxed);
+      for (auto & errors : shard.errors) {
+        errors.store(0u, std::memory_order_relaxed);
+      }
+      shard.latency_count.store(0u, std::memory_order_relaxed);
+      shard.latency_sum_ns.store(0u, std::memory_order_relaxed);
+      for (auto & bucket : shard.buckets) {
+        bucket.store(0u, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+namespace
+{
+
+// Write a value in seconds from nanoseconds, without losing precision
+void write_seconds(std::ostream & out, uint64_t value_ns)
+{
+  out << value_ns / 1000000000u << '.' << std::setw(9) << std::setfill('0') <<
+    value_ns % 1000000000u << std::setfill(' ');
+}
+
+void write_labels(std::ostream & out, const SeriesSnapshot & series)
+{
+  // Type names only contain letters, digits, underscores, and slashes, which need no escaping
+  out << "operation=\"" << get_operation_name(series.operation) << "\",type=\"" << series.type <<
+    '"';
+}
+
+// Write a string as a JSON string
+void write_json_string(std::ostream & out, const std::string & value)
+{
+  out << '"';
+  for (const char character : value) {
+    if ('"' == character || '\\' == character) {
+      out << '\\';
+    }
+    out << character;
+  }
+  out << '"';
+}
+
+}  // namespace
+
+std::string to_prometheus_text(const Snapshot & snapshot)
+{
+  std::ostringstream out;
+  out << "# HELP dynmsg_messages_total Messages converted successfully.\n" <<
+    "# TYPE dynmsg_messages_total counter\n";
+  for (const auto & series : snapshot.series) {
+    out << "dynmsg_messages_total{";
+    write_labels(out, series);
+    out << "} " << series.messages << '\n';
+  }
+  out << "# HELP dynmsg_bytes_in_total Bytes of YAML text parsed, or of serialized messages " <<
+    "converted to YAML.\n" <<
+    "# TYPE dynmsg_bytes_in_total counter\n";
+  for (const auto & series : snapshot.series) {
+    out << "dynmsg_bytes_in_total{";
+    write_labels(out, series);
+    out << "} " << series.bytes_in << '\n';
+  }
+  out << "# HELP dynmsg_bytes_out_total Bytes of serialized messages converted from YAML.\n" <<
+    "# TYPE dynmsg_bytes_out_total counter\n";
+  for (const auto & series : snapshot.series) {
+    out << "dynmsg_bytes_out_total{";
+    write_labels(out, series);
+    out << "} " << series.bytes_out << '\n';
+  }
+  out << "# HELP dynmsg_errors_total Failed conversions.\n" <<
+    "# TYPE dynmsg_errors_total counter\n";
+  for (const auto & series : snapshot.series) {
+    for (size_t ii = 0; ii < ERROR_KIND_COUNT; ++ii) {
+      out << "dynmsg_errors_total{";
+      write_labels(out, series);
+      out << ",kind=\"" << get_error_kind_name(static_cast<ErrorKind>(ii)) << "\"} " <<
+        series.errors[ii] << '\n';
+    }
+  }
+  out << "# HELP dynmsg_conversion_latency_seconds Latency of the conversions.\n" <<
+    "# TYPE dynmsg_conversion_latency_seconds histogram\n";
+  for (const auto & series : snapshot.series) {
+    uint64_t cumulative_count = 0u;
+    auto bucket = series.latency.buckets.begin();
+    for (uint64_t exponent = MIN_EXPORTED_EXPONENT; exponent <= MAX_EXPONENT + 1u; ++exponent) {
+      const uint64_t bound_ns = (uint64_t(1u) << exponent) - 1u;
+      for (; bucket != series.latency.buckets.end() && bucket->first <= bound_ns; ++bucket) {
+        cumulative_count += bucket->second;
+      }
+      out << "dynmsg_conversion_latency_seconds_bucket{";
+      write_labels(out, series);
+      out << ",le=\"";
+      write_seconds(out, bound_ns);
+      out << "\"} " << cumulative_count << '\n';
+    }
+    out << "dynmsg_conversion_latency_seconds_bucket{";
+    write_labels(out, series);
+    out << ",le=\"+Inf\"} " << series.latency.count << '\n';
+    out << "dynmsg_conversion_latency_seconds_sum{";
+    write_labels(out, series);
+    out << "} ";
+    write_seconds(out, series.latency.sum_ns);
+    out << '\n';
+    out << "dynmsg_conversion_latency_seconds_count{";
+    write_labels(out, series);
+    out << "} " << series.latency.count << '\n';
+  }
+  return out.str();
+}
+
+std::string to_json(const Snapshot & snapshot)
+{
+  std::ostringstream out;
+  out << "{\"series\":[";
+  for (size_t ii = 0; ii < snapshot.series.size(); ++ii) {
+    const SeriesSnapshot & series = snapshot.series[ii];
+    if (0u != ii) {
+      out << ',';
+    }
+    out << "{\"operation\":\"" << get_operation_name(series.operation) << "\",\"type\":";
+    write_json_string(out, series.type);
+    out << ",\"messages\":" << series.messages << ",\"bytes_in\":" << series.bytes_in <<
+      ",\"bytes_out\":" << series.bytes_out << ",\"errors\":{";
+    for (size_t kind = 0; kind < ERROR_KIND_COUNT; ++kind) {
+      out << (0u == kind ? "" : ",") << '"' <<
+        get_error_kind_name(static_cast<ErrorKind>(kind)) << "\":" << series.errors[kind];
+    }
+    out << "},\"latency\":{\"count\":" << series.latency.count << ",\"sum_ns\":" <<
+      series.latency.sum_ns << ",\"buckets\":[";
+    for (size_t jj = 0; jj < series.latency.buckets.size(); ++jj) {
+      out << (0u == jj ? "" : ",") << '[' << series.latency.buckets[jj].first << ',' <<
+        series.latency.buckets[jj].second << ']';
+    }
+    out << "]}}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+}  // namespace metrics
+
+}  // namespace dynmsg
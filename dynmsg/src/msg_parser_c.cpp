@@ -26,8 +26,12 @@
 #include "rcutils/allocator.h"
 
 #include "dynmsg/config.hpp"
+#include "dynmsg/memory_tracking.hpp"
+#include "dynmsg/metrics.hpp"
 #include "dynmsg/msg_parser.hpp"
+#include "dynmsg/profiling.hpp"
 #include "dynmsg/string_utils.hpp"
+#include "dynmsg/tracing.hpp"
 
 namespace dynmsg
 {
@@ -294,6 +298,7 @@ void write_member_sequence(const YAML::Node & yaml, uint8_t * buffer, const Memb
 {
   using SequenceType = typename TypeMapping<RosTypeId>::SequenceType;
 
+  DYNMSG_TRACE(tracing::CATEGORY_PARSER, "write_member_sequence", member.name_, yaml.size());
   if (member.is_upper_bound_ && yaml.size() > member.array_size_) {
     throw std::runtime_error("yaml sequence is more than capacity");
   }
@@ -337,6 +342,7 @@ bool is_sequence(const MemberInfo & member)
 template<int RosTypeId>
 void write_member(const YAML::Node & yaml, uint8_t * buffer, const MemberInfo & member)
 {
+  DYNMSG_TRACE(tracing::CATEGORY_PARSER, "write_member", member.name_, member.type_id_);
   using CppType = typename TypeMapping<RosTypeId>::CppType;
   // Arrays and sequences have different struct representation. An array is represented by a
   // classic C array (pointer with data size == sizeof(type) * array_size).
@@ -369,6 +375,7 @@ void write_member_sequence_nested(
   uint8_t * buffer,
   const MemberInfo & member)
 {
+  DYNMSG_TRACE(tracing::CATEGORY_PARSER, "write_member_sequence", member.name_, yaml.size());
   if (member.is_upper_bound_ && yaml.size() > member.array_size_) {
     throw std::runtime_error("yaml sequence is more than capacity");
   }
@@ -413,12 +420,17 @@ void yaml_to_rosmsg_impl(
   const TypeInfo * typeinfo,
   uint8_t * buffer)
 {
+  DYNMSG_TRACE(
+    tracing::CATEGORY_PARSER, "yaml_to_rosmsg", typeinfo->message_name_, typeinfo->member_count_);
+  profiling::impl::MessageScope profile_message(
+    "c.from_yaml", typeinfo->message_namespace_, typeinfo->message_name_);
   for (uint32_t i = 0; i < typeinfo->member_count_; i++) {
     const auto & member = typeinfo->members_[i];
 
     if (!root[member.name_]) {
       continue;
     }
+    profiling::impl::MemberScope profile_member(member.name_);
 
     switch (member.type_id_) {
       case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
@@ -493,17 +505,32 @@ RosMessage yaml_and_typeinfo_to_rosmsg(
   if (!allocator) {
     allocator = &default_allocator;
   }
-  // Parse the YAML representation to an in-memory representation
-  YAML::Node root = YAML::Load(yaml_str);
-  RosMessage ros_msg;
-  // Load the introspection information and allocate space for the ROS message's binary
-  // representation
-  if (DYNMSG_RET_OK != dynmsg::c::ros_message_with_typeinfo_init(type_info, &ros_msg, allocator)) {
-    return {nullptr, nullptr};
+  memory_tracking::impl::ConversionScope track_memory;
+  metrics::impl::ConversionScope measure_conversion(
+    metrics::Operation::c_from_yaml, type_info, type_info->message_namespace_,
+    type_info->message_name_, yaml_str.size());
+  try {
+    // Parse the YAML representation to an in-memory representation
+    YAML::Node root = YAML::Load(yaml_str);
+    RosMessage ros_msg;
+    // Load the introspection information and allocate space for the ROS message's binary
+    // representation
+    if (DYNMSG_RET_OK != dynmsg::c::ros_message_with_typeinfo_init(type_info, &ros_msg, allocator))
+    {
+      measure_conversion.failed(metrics::ErrorKind::initialization);
+      return {nullptr, nullptr};
+    }
+    // Convert the YAML representation to a binary representation
+    impl::yaml_to_rosmsg_impl(root, ros_msg.type_info, ros_msg.data);
+    measure_conversion.count_message(ros_msg);
+    return ros_msg;
+  } catch (const YAML::Exception &) {
+    measure_conversion.failed(metrics::ErrorKind::yaml);
+    throw;
+  } catch (...) {
+    measure_conversion.failed(metrics::ErrorKind::conversion);
+    throw;
   }
-  // Convert the YAML representation to a binary representation
-  impl::yaml_to_rosmsg_impl(root, ros_msg.type_info, ros_msg.data);
-  return ros_msg;
 }
 
 RosMessage yaml_to_rosmsg(
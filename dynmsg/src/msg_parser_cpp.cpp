@@ -15,7 +15,6 @@
 
 #include <yaml-cpp/yaml.h>
 
-#include <iostream>
 #include <string>
 #include <vector>
 
@@ -30,8 +29,12 @@
 #include "rcutils/allocator.h"
 
 #include "dynmsg/config.hpp"
+#include "dynmsg/memory_tracking.hpp"
+#include "dynmsg/metrics.hpp"
 #include "dynmsg/msg_parser.hpp"
+#include "dynmsg/profiling.hpp"
 #include "dynmsg/string_utils.hpp"
+#include "dynmsg/tracing.hpp"
 
 namespace dynmsg
 {
@@ -176,7 +179,6 @@ void write_member_item(
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_member_item<T>(): " << std::endl);
   using CppType = typename TypeMappingCpp<RosTypeId>::CppType;
   *reinterpret_cast<CppType *>(buffer) = yaml.as<CppType>();
 }
@@ -188,7 +190,6 @@ void write_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_CHAR>(
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_member_item<char>(): " << std::endl);
   using CppType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_CHAR>::CppType;
   std::string s = yaml.as<std::string>();
@@ -199,7 +200,6 @@ void write_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET>(
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_member_item<octet>(): " << std::endl);
   using CppType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET>::CppType;
   std::string s = yaml.as<std::string>();
@@ -210,7 +210,6 @@ void write_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8>(
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_member_item<uint8>(): " << std::endl);
   using CppType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8>::CppType;
   std::string s = yaml.as<std::string>();
@@ -221,7 +220,6 @@ void write_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_INT8>(
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_member_item<int8>(): " << std::endl);
   using CppType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_INT8>::CppType;
   std::string s = yaml.as<std::string>();
@@ -235,8 +233,6 @@ void write_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING>(
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: write_member_item<string>(): " << yaml.as<std::string>() << std::endl);
   using CppType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING>::CppType;
   *reinterpret_cast<CppType *>(buffer) = yaml.as<std::string>();
@@ -248,8 +244,6 @@ void write_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING>(
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: write_member_item<wstring>(): " << yaml.as<std::string>() << std::endl);
   using CppType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING>::CppType;
   *reinterpret_cast<CppType *>(buffer) = string_to_u16string(yaml.as<std::string>());
@@ -261,7 +255,6 @@ void write_sequence_member_item(
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_sequence_member_item<T>(): " << std::endl);
   using CppType = typename TypeMappingCpp<RosTypeId>::CppType;
   using SequenceType = typename TypeMappingCpp<RosTypeId>::SequenceType;
   auto seq = reinterpret_cast<SequenceType *>(buffer);
@@ -275,7 +268,6 @@ void write_sequence_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_C
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_sequence_member_item<char>(): " << std::endl);
   using SequenceType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_CHAR>::SequenceType;
   std::string s = yaml.as<std::string>();
@@ -287,7 +279,6 @@ void write_sequence_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_O
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_sequence_member_item<octet>(): " << std::endl);
   using SequenceType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_OCTET>::SequenceType;
   std::string s = yaml.as<std::string>();
@@ -299,7 +290,6 @@ void write_sequence_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_U
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_sequence_member_item<uint8>(): " << std::endl);
   using SequenceType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_UINT8>::SequenceType;
   std::string s = yaml.as<std::string>();
@@ -311,7 +301,6 @@ void write_sequence_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_I
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_sequence_member_item<int8>(): " << std::endl);
   using SequenceType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_INT8>::SequenceType;
   std::string s = yaml.as<std::string>();
@@ -326,9 +315,6 @@ void write_sequence_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_S
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: write_sequence_member_item<string>(): " <<
-      yaml.as<std::string>() << std::endl);
   using SequenceType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_STRING>::SequenceType;
   auto seq = reinterpret_cast<SequenceType *>(buffer);
@@ -341,9 +327,6 @@ void write_sequence_member_item<rosidl_typesupport_introspection_cpp::ROS_TYPE_W
   const YAML::Node & yaml,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: write_sequence_member_item<wstring>(): " <<
-      yaml.as<std::string>() << std::endl);
   using SequenceType =
     typename TypeMappingCpp<rosidl_typesupport_introspection_cpp::ROS_TYPE_WSTRING>::SequenceType;
   auto seq = reinterpret_cast<SequenceType *>(buffer);
@@ -357,8 +340,7 @@ void write_member_sequence(
   uint8_t * buffer,
   const MemberInfo_Cpp & member)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_member_sequence: " << std::flush);
-  DYNMSG_DEBUG(std::cout << yaml.size() << ":" << yaml << std::endl);
+  DYNMSG_TRACE(tracing::CATEGORY_PARSER, "write_member_sequence", member.name_, yaml.size());
   if (member.is_upper_bound_ && yaml.size() > member.array_size_) {
     throw std::runtime_error("yaml sequence is more than capacity");
   }
@@ -377,8 +359,7 @@ void write_member_sequence<rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOL>(
   uint8_t * buffer,
   const MemberInfo_Cpp & member)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_member_sequence<bool>: " << std::flush);
-  DYNMSG_DEBUG(std::cout << yaml.size() << ":" << yaml << std::endl);
+  DYNMSG_TRACE(tracing::CATEGORY_PARSER, "write_member_sequence", member.name_, yaml.size());
   if (member.is_upper_bound_ && yaml.size() > member.array_size_) {
     throw std::runtime_error("yaml sequence is more than capacity");
   }
@@ -421,7 +402,7 @@ bool is_sequence(const MemberInfo_Cpp & member)
 template<int RosTypeId>
 void write_member(const YAML::Node & yaml, uint8_t * buffer, const MemberInfo_Cpp & member)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: write_member" << std::endl);
+  DYNMSG_TRACE(tracing::CATEGORY_PARSER, "write_member", member.name_, member.type_id_);
   using CppType = typename TypeMappingCpp<RosTypeId>::CppType;
   // Arrays and sequences have different struct representation. An array is represented by a
   // classic C array (pointer with data size == sizeof(type) * array_size).
@@ -454,6 +435,7 @@ void write_member_sequence_nested(
   uint8_t * buffer,
   const MemberInfo_Cpp & member)
 {
+  DYNMSG_TRACE(tracing::CATEGORY_PARSER, "write_member_sequence", member.name_, yaml.size());
   if (member.is_upper_bound_ && yaml.size() > member.array_size_) {
     throw std::runtime_error("yaml sequence is more than capacity");
   }
@@ -502,18 +484,17 @@ void yaml_to_rosmsg_impl(
   const TypeInfo_Cpp * typeinfo,
   uint8_t * buffer)
 {
-  DYNMSG_DEBUG(std::cout << "DEBUG: yaml_to_rosmsg_impl" << std::endl);
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: type_info message_namespace_: " <<
-      typeinfo->message_namespace_ << std::endl);
-  DYNMSG_DEBUG(
-    std::cout << "DEBUG: type_info message_name_: " << typeinfo->message_name_ << std::endl);
+  DYNMSG_TRACE(
+    tracing::CATEGORY_PARSER, "yaml_to_rosmsg", typeinfo->message_name_, typeinfo->member_count_);
+  profiling::impl::MessageScope profile_message(
+    "cpp.from_yaml", typeinfo->message_namespace_, typeinfo->message_name_);
   for (uint32_t i = 0; i < typeinfo->member_count_; i++) {
     const auto & member = typeinfo->members_[i];
 
     if (!root[member.name_]) {
       continue;
     }
+    profiling::impl::MemberScope profile_member(member.name_);
 
     switch (member.type_id_) {
       case rosidl_typesupport_introspection_cpp::ROS_TYPE_FLOAT:
@@ -584,11 +565,24 @@ void yaml_and_typeinfo_to_rosmsg(
   const std::string & yaml_str,
   void * ros_message)
 {
-  // Parse the YAML representation to an in-memory representation
-  YAML::Node root = YAML::Load(yaml_str);
-  // Convert the YAML representation to a binary representation
-  uint8_t * buffer = reinterpret_cast<uint8_t *>(ros_message);
-  impl::yaml_to_rosmsg_impl(root, type_info, buffer);
+  memory_tracking::impl::ConversionScope track_memory;
+  metrics::impl::ConversionScope measure_conversion(
+    metrics::Operation::cpp_from_yaml, type_info, type_info->message_namespace_,
+    type_info->message_name_, yaml_str.size());
+  try {
+    // Parse the YAML representation to an in-memory representation
+    YAML::Node root = YAML::Load(yaml_str);
+    // Convert the YAML representation to a binary representation
+    uint8_t * buffer = reinterpret_cast<uint8_t *>(ros_message);
+    impl::yaml_to_rosmsg_impl(root, type_info, buffer);
+    measure_conversion.count_message(RosMessage_Cpp{type_info, buffer});
+  } catch (const YAML::Exception &) {
+    measure_conversion.failed(metrics::ErrorKind::yaml);
+    throw;
+  } catch (...) {
+    measure_conversion.failed(metrics::ErrorKind::conversion);
+    throw;
+  }
 }
 
 RosMessage_Cpp yaml_and_typeinfo_to_rosmsg(
@@ -600,12 +594,18 @@ RosMessage_Cpp yaml_and_typeinfo_to_rosmsg(
   if (!allocator) {
     allocator = &default_allocator;
   }
+  // The message is part of the memory used by the conversion, as with the C version
+  memory_tracking::impl::ConversionScope track_memory;
   RosMessage_Cpp ros_msg;
   // Load the introspection information and allocate space for the ROS message's binary
   // representation
   if (DYNMSG_RET_OK !=
     dynmsg::cpp::ros_message_with_typeinfo_init(type_info, &ros_msg, allocator))
   {
+    metrics::impl::ConversionScope measure_conversion(
+      metrics::Operation::cpp_from_yaml, type_info, type_info->message_namespace_,
+      type_info->message_name_, yaml_str.size());
+    measure_conversion.failed(metrics::ErrorKind::initialization);
     return {nullptr, nullptr};
   }
   yaml_and_typeinfo_to_rosmsg(type_info, yaml_str, reinterpret_cast<void *>(ros_msg.data));
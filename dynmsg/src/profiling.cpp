@@ -0,0 +1,346 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "dynmsg/profiling.hpp"
+#include "dynmsg/typesupport.hpp"
+
+namespace dynmsg
+{
+
+namespace profiling
+{
+
+namespace impl
+{
+
+std::atomic<bool> running(false);
+
+}  // namespace impl
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<uint32_t> sample_period(1u);
+std::atomic<AllocationCounter> allocation_counter(nullptr);
+
+Allocations & operator+=(Allocations & lhs, const Allocations & rhs)
+{
+  lhs.count += rhs.count;
+  lhs.bytes += rhs.bytes;
+  return lhs;
+}
+
+// Subtract counts, without wrapping around if the allocation counter went backwards
+uint64_t difference(uint64_t lhs, uint64_t rhs)
+{
+  return lhs > rhs ? lhs - rhs : 0u;
+}
+
+Allocations operator-(const Allocations & lhs, const Allocations & rhs)
+{
+  return Allocations{difference(lhs.count, rhs.count), difference(lhs.bytes, rhs.bytes)};
+}
+
+// Accumulated cost of a member
+struct Cost
+{
+  uint64_t count = 0u;
+  uint64_t total_ns = 0u;
+  uint64_t self_ns = 0u;
+  Allocations total_allocations{0u, 0u};
+  Allocations self_allocations{0u, 0u};
+
+  Cost & operator+=(const Cost & other)
+  {
+    count += other.count;
+    total_ns += other.total_ns;
+    self_ns += other.self_ns;
+    total_allocations += other.total_allocations;
+    self_allocations += other.self_allocations;
+    return *this;
+  }
+};
+
+// A point in time, with the allocations made up to it
+struct Measurement
+{
+  Clock::time_point time;
+  Allocations allocations;
+};
+
+// A member, or the message, being converted
+struct Frame
+{
+  // Length of the path of the parent
+  size_t parent_path_length;
+  Measurement start;
+  // Overhead of the profiler up to the start
+  uint64_t overhead_ns;
+  Allocations overhead_allocations;
+  // Cost of the nested members
+  uint64_t child_ns;
+  Allocations child_allocations;
+};
+
+// Profile of the conversion in progress on a thread
+struct ThreadProfile
+{
+  // Number of nested message conversions in progress, whether they are profiled or not
+  uint32_t depth = 0u;
+  // Number of outermost conversions so far, for sampling
+  uint64_t conversions = 0u;
+  bool profiling = false;
+  const char * operation = nullptr;
+  std::string type;
+  AllocationCounter count_allocations = nullptr;
+  // Path of the member being converted
+  std::string path;
+  std::vector<Frame> frames;
+  // Costs of the conversion in progress, by path
+  std::unordered_map<std::string, Cost> costs;
+  // Time and allocations of the bookkeeping of the profiler, which are excluded from the costs
+  uint64_t overhead_ns = 0u;
+  Allocations overhead_allocations{0u, 0u};
+};
+
+ThreadProfile & get_thread_profile()
+{
+  thread_local ThreadProfile profile;
+  return profile;
+}
+
+// Costs accumulated from all threads, by conversion, type, and path
+using CostKey = std::tuple<std::string, std::string, std::string>;
+std::mutex costs_mutex;
+std::map<CostKey, Cost> costs;
+
+Measurement measure(const ThreadProfile & profile)
+{
+  Measurement measurement;
+  measurement.allocations =
+    nullptr == profile.count_allocations ? Allocations{0u, 0u} : profile.count_allocations();
+  measurement.time = Clock::now();
+  return measurement;
+}
+
+uint64_t nanoseconds_between(const Clock::time_point & start, const Clock::time_point & end)
+{
+  return static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+// Account for the bookkeeping done since the start, and return the end of it
+Measurement add_overhead(ThreadProfile & profile, const Measurement & start)
+{
+  const Measurement end = measure(profile);
+  profile.overhead_ns += nanoseconds_between(start.time, end.time);
+  profile.overhead_allocations += end.allocations - start.allocations;
+  return end;
+}
+
+void push_frame(ThreadProfile & profile, const char * name)
+{
+  const Measurement bookkeeping_start = measure(profile);
+  const size_t parent_path_length = profile.path.size();
+  if ('\0' != name[0]) {
+    if (!profile.path.empty()) {
+      profile.path += '.';
+    }
+    profile.path += name;
+  }
+  profile.frames.emplace_back();
+  Frame & frame = profile.frames.back();
+  frame.parent_path_length = parent_path_length;
+  frame.child_ns = 0u;
+  frame.child_allocations = Allocations{0u, 0u};
+  frame.start = add_overhead(profile, bookkeeping_start);
+  frame.overhead_ns = profile.overhead_ns;
+  frame.overhead_allocations = profile.overhead_allocations;
+}
+
+void pop_frame(ThreadProfile & profile)
+{
+  const Measurement end = measure(profile);
+  const Frame & frame = profile.frames.back();
+  const uint64_t total_ns = difference(
+    nanoseconds_between(frame.start.time, end.time), profile.overhead_ns - frame.overhead_ns);
+  const Allocations total_allocations =
+    (end.allocations - frame.start.allocations) -
+    (profile.overhead_allocations - frame.overhead_allocations);
+
+  Cost & cost = profile.costs[profile.path];
+  ++cost.count;
+  cost.total_ns += total_ns;
+  cost.self_ns += difference(total_ns, frame.child_ns);
+  cost.total_allocations += total_allocations;
+  cost.self_allocations += total_allocations - frame.child_allocations;
+
+  profile.path.resize(frame.parent_path_length);
+  profile.frames.pop_back();
+  if (!profile.frames.empty()) {
+    profile.frames.back().child_ns += total_ns;
+    profile.frames.back().child_allocations += total_allocations;
+  }
+  add_overhead(profile, end);
+}
+
+}  // namespace
+
+namespace impl
+{
+
+void MessageScope::enter(
+  const char * operation, const char * type_namespace, const char * type_name)
+{
+  ThreadProfile & profile = get_thread_profile();
+  if (profile.depth++ > 0u) {
+    return;
+  }
+  const uint32_t period = std::max(1u, sample_period.load(std::memory_order_relaxed));
+  profile.profiling = 0u == profile.conversions++ % period;
+  if (!profile.profiling) {
+    return;
+  }
+  profile.operation = operation;
+  profile.type = get_type_name(type_namespace, type_name);
+  profile.count_allocations = allocation_counter.load(std::memory_order_relaxed);
+  profile.overhead_ns = 0u;
+  profile.overhead_allocations = Allocations{0u, 0u};
+  push_frame(profile, "");
+}
+
+void MessageScope::exit()
+{
+  ThreadProfile & profile = get_thread_profile();
+  if (--profile.depth > 0u || !profile.profiling) {
+    return;
+  }
+  pop_frame(profile);
+  profile.profiling = false;
+
+  std::lock_guard<std::mutex> lock(costs_mutex);
+  for (const auto & cost : profile.costs) {
+    costs[CostKey(profile.operation, profile.type, cost.first)] += cost.second;
+  }
+  profile.costs.clear();
+}
+
+bool MemberScope::enter(const char * name)
+{
+  ThreadProfile & profile = get_thread_profile();
+  if (!profile.profiling) {
+    return false;
+  }
+  push_frame(profile, name);
+  return true;
+}
+
+void MemberScope::exit()
+{
+  pop_frame(get_thread_profile());
+}
+
+}  // namespace impl
+
+void start(const ProfilingOptions & options)
+{
+  sample_period.store(options.sample_period, std::memory_order_relaxed);
+  allocation_counter.store(options.count_allocations, std::memory_order_relaxed);
+  impl::running.store(true, std::memory_order_relaxed);
+}
+
+void stop()
+{
+  impl::running.store(false, std::memory_order_relaxed);
+}
+
+void reset()
+{
+  std::lock_guard<std::mutex> lock(costs_mutex);
+  costs.clear();
+}
+
+std::vector<FieldCost> get_report()
+{
+  std::vector<FieldCost> report;
+  {
+    std::lock_guard<std::mutex> lock(costs_mutex);
+    for (const auto & entry : costs) {
+      const std::string & operation = std::get<0>(entry.first);
+      const std::string & type = std::get<1>(entry.first);
+      // The message itself has an empty path
+      const auto message = costs.find(CostKey(operation, type, std::string()));
+      const Cost & cost = entry.second;
+      report.push_back(
+        FieldCost{
+          operation, type, std::get<2>(entry.first),
+          message == costs.end() ? 0u : message->second.count, cost.count, cost.total_ns,
+          cost.self_ns, cost.total_allocations, cost.self_allocations});
+    }
+  }
+  std::stable_sort(
+    report.begin(), report.end(), [](const FieldCost & lhs, const FieldCost & rhs) {
+      return lhs.self_ns > rhs.self_ns;
+    });
+  return report;
+}
+
+void write_report(std::ostream & out, const std::vector<FieldCost> & report, size_t max_rows)
+{
+  const size_t rows = 0u == max_rows ? report.size() : std::min(max_rows, report.size());
+  const std::string message_path = "(message)";
+  size_t type_width = 4u;
+  size_t path_width = message_path.size();
+  for (size_t ii = 0; ii < rows; ++ii) {
+    type_width = std::max(type_width, report[ii].type.size());
+    path_width = std::max(path_width, report[ii].path.size());
+  }
+
+  std::ostringstream table;
+  table << std::left << std::setw(15) << "conversion" << std::setw(type_width + 2u) << "type" <<
+    std::setw(path_width + 2u) << "member" << std::right << std::setw(10) << "count/msg" <<
+    std::setw(14) << "self ns/msg" << std::setw(14) << "total ns/msg" << std::setw(16) <<
+    "self allocs/msg" << std::setw(17) << "total allocs/msg" << '\n';
+  table << std::fixed << std::setprecision(1);
+  for (size_t ii = 0; ii < rows; ++ii) {
+    const FieldCost & cost = report[ii];
+    const double messages = static_cast<double>(std::max<uint64_t>(1u, cost.messages));
+    table << std::left << std::setw(15) << cost.operation << std::setw(type_width + 2u) <<
+      cost.type << std::setw(path_width + 2u) <<
+      (cost.path.empty() ? message_path : cost.path) << std::right << std::setw(10) <<
+      static_cast<double>(cost.count) / messages << std::setw(14) <<
+      static_cast<double>(cost.self_ns) / messages << std::setw(14) <<
+      static_cast<double>(cost.total_ns) / messages << std::setw(16) <<
+      static_cast<double>(cost.self_allocations.count) / messages << std::setw(17) <<
+      static_cast<double>(cost.total_allocations.count) / messages << '\n';
+  }
+  out << table.str();
+}
+
+}  // namespace profiling
+
+}  // namespace dynmsg
@@ -0,0 +1,347 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rcutils/logging_macros.h"
+
+#include "dynmsg/tracing.hpp"
+
+namespace dynmsg
+{
+
+namespace tracing
+{
+
+namespace impl
+{
+
+std::atomic<uint32_t> enabled_categories(0u);
+
+}  // namespace impl
+
+namespace
+{
+
+// A ring of events with a single producer, the thread that owns it, and a single consumer, the
+// thread draining it
+class EventRing
+{
+public:
+  // A power of two, so that the indices can wrap around
+  static constexpr uint64_t CAPACITY = 4096u;
+
+  explicit EventRing(uint32_t thread_index)
+  : thread_index(thread_index),
+    retired(false),
+    head_(0u),
+    tail_(0u)
+  {
+  }
+
+  // Called by the owning thread only. Returns false if the ring is full.
+  bool push(const Event & event)
+  {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == CAPACITY) {
+      return false;
+    }
+    events_[head % CAPACITY] = event;
+    head_.store(head + 1u, std::memory_order_release);
+    return true;
+  }
+
+  // Called by the draining thread only
+  size_t pop_all(const Sink & sink)
+  {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const size_t count = head - tail;
+    for (; tail != head; ++tail) {
+      sink(events_[tail % CAPACITY]);
+    }
+    tail_.store(tail, std::memory_order_release);
+    return count;
+  }
+
+  bool empty() const
+  {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed);
+  }
+
+  const uint32_t thread_index;
+  // Set when the owning thread exits, so that the ring can be removed once drained
+  std::atomic<bool> retired;
+
+private:
+  std::atomic<uint64_t> head_;
+  std::atomic<uint64_t> tail_;
+  std::array<Event, CAPACITY> events_;
+};
+
+// The drain thread, if started
+class Drainer
+{
+public:
+  ~Drainer()
+  {
+    stop();
+  }
+
+  void start(Sink sink, std::chrono::milliseconds period);
+  void stop();
+
+private:
+  void run(const Sink & sink, std::chrono::milliseconds period);
+
+  std::mutex mutex_;
+  std::condition_variable stop_requested_;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+struct State
+{
+  // Guards the list of rings, and makes drains exclusive
+  std::mutex mutex;
+  std::vector<std::shared_ptr<EventRing>> rings;
+  uint32_t next_thread_index = 0u;
+  std::atomic<uint64_t> dropped_events{0u};
+  // Declared last so that the drain thread is stopped before the rings are destroyed
+  Drainer drainer;
+};
+
+State & get_state()
+{
+  static State state;
+  return state;
+}
+
+// Owns the ring of a thread, and retires it when the thread exits
+struct ThreadRing
+{
+  ~ThreadRing()
+  {
+    if (ring) {
+      ring->retired.store(true, std::memory_order_release);
+    }
+  }
+
+  std::shared_ptr<EventRing> ring;
+};
+
+EventRing & get_thread_ring()
+{
+  thread_local ThreadRing thread_ring;
+  if (!thread_ring.ring) {
+    State & state = get_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    thread_ring.ring = std::make_shared<EventRing>(state.next_thread_index++);
+    state.rings.push_back(thread_ring.ring);
+  }
+  return *thread_ring.ring;
+}
+
+void Drainer::start(Sink sink, std::chrono::milliseconds period)
+{
+  stop();
+  std::lock_guard<std::mutex> lock(mutex_);
+  stopping_ = false;
+  thread_ = std::thread(
+    [this, sink, period]() {
+      run(sink, period);
+    });
+}
+
+void Drainer::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!thread_.joinable()) {
+      return;
+    }
+    stopping_ = true;
+  }
+  stop_requested_.notify_all();
+  thread_.join();
+}
+
+void Drainer::run(const Sink & sink, std::chrono::milliseconds period)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  bool stopping = false;
+  while (!stopping) {
+    stop_requested_.wait_for(lock, period, [this]() {return stopping_;});
+    // Drain once more after the stop is requested, to not lose the last events
+    stopping = stopping_;
+    lock.unlock();
+    drain(sink);
+    lock.lock();
+  }
+}
+
+// Write events to stderr, for tracing enabled through the environment
+void write_to_stderr(const Event & event)
+{
+  std::ostringstream line;
+  write_event(line, event);
+  std::cerr << line.str() << '\n';
+}
+
+// Enable tracing according to the DYNMSG_TRACE environment variable, when the program starts
+struct EnvironmentConfiguration
+{
+  EnvironmentConfiguration()
+  : started_draining(false)
+  {
+    const char * names = std::getenv("DYNMSG_TRACE");
+    if (nullptr == names || '\0' == names[0]) {
+      return;
+    }
+    try {
+      set_enabled_categories(parse_categories(names));
+    } catch (const std::runtime_error & e) {
+      RCUTILS_LOG_ERROR_NAMED("dynmsg", "Invalid DYNMSG_TRACE: %s", e.what());
+      return;
+    }
+    start_draining(write_to_stderr);
+    started_draining = true;
+  }
+
+  // The state is only known to outlive this object if it was created by the constructor, so it is
+  // not used otherwise; the drain thread is then stopped when the state is destroyed
+  ~EnvironmentConfiguration()
+  {
+    if (started_draining) {
+      stop_draining();
+    }
+  }
+
+  bool started_draining;
+};
+
+const EnvironmentConfiguration environment_configuration;
+
+const char * category_name(uint32_t category)
+{
+  switch (category) {
+    case CATEGORY_PARSER:
+      return "parser";
+    case CATEGORY_READER:
+      return "reader";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace
+
+void set_enabled_categories(uint32_t categories)
+{
+  impl::enabled_categories.store(categories, std::memory_order_relaxed);
+}
+
+uint32_t get_enabled_categories()
+{
+  return impl::enabled_categories.load(std::memory_order_relaxed);
+}
+
+uint32_t parse_categories(const std::string & names)
+{
+  uint32_t categories = 0u;
+  std::istringstream stream(names);
+  std::string name;
+  while (std::getline(stream, name, ',')) {
+    if ("parser" == name) {
+      categories |= CATEGORY_PARSER;
+    } else if ("reader" == name) {
+      categories |= CATEGORY_READER;
+    } else if ("all" == name) {
+      categories |= CATEGORY_ALL;
+    } else {
+      throw std::runtime_error("unknown trace category '" + name + "'");
+    }
+  }
+  return categories;
+}
+
+void record(uint32_t category, const char * what, const char * name, int64_t value)
+{
+  EventRing & ring = get_thread_ring();
+  const Event event{
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count(),
+    ring.thread_index, category, what, name, value};
+  if (!ring.push(event)) {
+    get_state().dropped_events.fetch_add(1u, std::memory_order_relaxed);
+  }
+}
+
+size_t drain(const Sink & sink)
+{
+  State & state = get_state();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  size_t count = 0u;
+  for (const auto & ring : state.rings) {
+    count += ring->pop_all(sink);
+  }
+  // A retired ring does not get new events, so it can be removed once empty
+  state.rings.erase(
+    std::remove_if(
+      state.rings.begin(), state.rings.end(),
+      [](const std::shared_ptr<EventRing> & ring) {
+        return ring->retired.load(std::memory_order_acquire) && ring->empty();
+      }),
+    state.rings.end());
+  return count;
+}
+
+void start_draining(Sink sink, std::chrono::milliseconds period)
+{
+  get_state().drainer.start(std::move(sink), period);
+}
+
+void stop_draining()
+{
+  State & state = get_state();
+  state.drainer.stop();
+}
+
+uint64_t get_dropped_event_count()
+{
+  return get_state().dropped_events.load(std::memory_order_relaxed);
+}
+
+void write_event(std::ostream & out, const Event & event)
+{
+  out << "[dynmsg] " << event.timestamp << " thread " << event.thread_index << ' ' <<
+    category_name(event.category) << ' ' << event.what << ' ' <<
+    (nullptr == event.name ? "-" : event.name) << ' ' << event.value;
+}
+
+}  // namespace tracing
+
+}  // namespace dynmsg
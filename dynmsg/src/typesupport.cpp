@@ -27,10 +27,32 @@
 namespace dynmsg
 {
 
+std::string get_type_name(const char * type_namespace, const char * type_name)
+{
+  std::string name;
+  for (const char * character = type_namespace; '\0' != *character; ++character) {
+    const char separator = character[0];
+    if ((':' == separator || '_' == separator) && separator == character[1]) {
+      name += '/';
+      ++character;
+    } else {
+      name += *character;
+    }
+  }
+  return name + '/' + type_name;
+}
+
 namespace c
 {
 
-const TypeInfo * get_type_info(const InterfaceTypeName & interface_type)
+namespace
+{
+
+// Load a function from the C introspection library of the package containing an interface type.
+// Returns nullptr if the library or the function cannot be loaded.
+void * load_introspection_function(
+  const InterfaceTypeName & interface_type,
+  const std::string & function_name)
 {
   // Load the introspection library for the package containing the requested type
   std::stringstream ts_lib_name;
@@ -47,21 +69,28 @@ const TypeInfo * get_type_info(const InterfaceTypeName & interface_type)
   }
   // Load the function that, when called, will give us the introspection information for the
   // interface type we are interested in
-  std::stringstream ts_func_name;
-  ts_func_name << "rosidl_typesupport_introspection_c__get_message_type_support_handle__" <<
-    interface_type.first << "__msg__" << interface_type.second;
   RCUTILS_LOG_DEBUG_NAMED(
-    "dynmsg", "Loading type support function %s", ts_func_name.str().c_str());
-
-  get_message_ts_func introspection_type_support_handle_func =
-    reinterpret_cast<get_message_ts_func>(dlsym(
-      introspection_type_support_lib,
-      ts_func_name.str().c_str()));
-  if (introspection_type_support_handle_func == nullptr) {
+    "dynmsg", "Loading type support function %s", function_name.c_str());
+  void * function = dlsym(introspection_type_support_lib, function_name.c_str());
+  if (function == nullptr) {
     RCUTILS_LOG_ERROR_NAMED(
       "dynmsg",
       "failed to load introspection type support function: %s",
       dlerror());
+  }
+  return function;
+}
+
+}  // namespace
+
+const TypeInfo * get_type_info(const InterfaceTypeName & interface_type)
+{
+  get_message_ts_func introspection_type_support_handle_func =
+    reinterpret_cast<get_message_ts_func>(load_introspection_function(
+      interface_type,
+      "rosidl_typesupport_introspection_c__get_message_type_support_handle__" +
+      interface_type.first + "__msg__" + interface_type.second));
+  if (introspection_type_support_handle_func == nullptr) {
     return nullptr;
   }
 
@@ -79,6 +108,27 @@ const TypeInfo * get_type_info(const InterfaceTypeName & interface_type)
   return type_info;
 }
 
+const ServiceTypeInfo * get_service_type_info(const InterfaceTypeName & interface_type)
+{
+  get_service_ts_func introspection_type_support_handle_func =
+    reinterpret_cast<get_service_ts_func>(load_introspection_function(
+      interface_type,
+      "rosidl_typesupport_introspection_c__get_service_type_support_handle__" +
+      interface_type.first + "__srv__" + interface_type.second));
+  if (introspection_type_support_handle_func == nullptr) {
+    return nullptr;
+  }
+
+  // Call the function to get the introspection information we want
+  const rosidl_service_type_support_t * introspection_ts =
+    introspection_type_support_handle_func();
+  RCUTILS_LOG_DEBUG_NAMED(
+    "dynmsg",
+    "Loaded service type support %s",
+    introspection_ts->typesupport_identifier);
+  return reinterpret_cast<const ServiceTypeInfo *>(introspection_ts->data);
+}
+
 dynmsg_ret_t ros_message_with_typeinfo_init(
   const TypeInfo * type_info,
   RosMessage * ros_msg,
@@ -117,14 +167,18 @@ dynmsg_ret_t ros_message_init(
 
 void ros_message_destroy_with_allocator(RosMessage * ros_msg, rcutils_allocator_t * allocator)
 {
+  rcutils_allocator_t default_allocator = rcutils_get_default_allocator();
+  if (!allocator) {
+    allocator = &default_allocator;
+  }
   ros_msg->type_info->fini_function(ros_msg->data);
   allocator->deallocate(ros_msg->data, allocator->state);
 }
 
 void ros_message_destroy(RosMessage * ros_msg)
 {
-  ros_msg->type_info->fini_function(ros_msg->data);
-  delete[] ros_msg->data;
+  // The buffer was allocated with the default allocator by ros_message_init()
+  ros_message_destroy_with_allocator(ros_msg, nullptr);
 }
 
 }  // namespace c
@@ -203,6 +257,10 @@ dynmsg_ret_t ros_message_with_typeinfo_init(
   RosMessage_Cpp * ros_msg,
   rcutils_allocator_t * allocator)
 {
+  rcutils_allocator_t default_allocator = rcutils_get_default_allocator();
+  if (!allocator) {
+    allocator = &default_allocator;
+  }
   RCUTILS_LOG_DEBUG_NAMED(
     "dynmsg",
     "Allocating message buffer of size %ld bytes",
@@ -221,6 +279,10 @@ dynmsg_ret_t ros_message_with_typeinfo_init(
 
 void ros_message_destroy_with_allocator(RosMessage_Cpp * ros_msg, rcutils_allocator_t * allocator)
 {
+  rcutils_allocator_t default_allocator = rcutils_get_default_allocator();
+  if (!allocator) {
+    allocator = &default_allocator;
+  }
   ros_msg->type_info->fini_function(ros_msg->data);
   allocator->deallocate(ros_msg->data, allocator->state);
 }
@@ -12,8 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
+#include <string>
 #include <vector>
 
+#include "rcutils/logging_macros.h"
+
 #include "dynmsg/vector_utils.hpp"
 
 /// Memory layout of an std::vector.
@@ -58,4 +62,69 @@ size_t get_vector_size(const uint8_t * vector, size_t element_size)
   ) / element_size;
 }
 
+size_t get_vector_capacity(const uint8_t * vector, size_t element_size)
+{
+  if (0ul == element_size) {
+    return 0ul;
+  }
+  vector_union v = {reinterpret_cast<std::vector<int> *>(const_cast<uint8_t *>(vector))};
+  return (
+    reinterpret_cast<uint64_t>(v.fake->end_capacity) - reinterpret_cast<uint64_t>(v.fake->begin)
+  ) / element_size;
+}
+
+const uint8_t * get_vector_data(const uint8_t * vector)
+{
+  const uint8_t * data = nullptr;
+  memcpy(&data, vector, sizeof(data));
+  return data;
+}
+
+namespace
+{
+
+// Element of 24 bytes, like some nested messages
+struct Triple
+{
+  uint64_t values[3];
+};
+
+// Check the functions relying on the layout against a vector with the given size and capacity
+template<typename T>
+bool check_vector_layout(size_t size, size_t capacity)
+{
+  std::vector<T> vector;
+  vector.reserve(capacity);
+  vector.resize(size);
+  const uint8_t * bytes = reinterpret_cast<const uint8_t *>(&vector);
+  return vector.size() == get_vector_size(bytes, sizeof(T)) &&
+    vector.capacity() == get_vector_capacity(bytes, sizeof(T)) &&
+    reinterpret_cast<const uint8_t *>(vector.data()) == get_vector_data(bytes);
+}
+
+bool check_vector_layout()
+{
+  const bool supported =
+    sizeof(std::vector<int>) == sizeof(fake_vector) &&
+    check_vector_layout<uint8_t>(0u, 0u) &&
+    check_vector_layout<uint8_t>(3u, 17u) &&
+    check_vector_layout<int32_t>(5u, 9u) &&
+    check_vector_layout<long double>(2u, 2u) &&
+    check_vector_layout<std::string>(4u, 6u) &&
+    check_vector_layout<Triple>(7u, 8u);
+  if (!supported) {
+    RCUTILS_LOG_DEBUG_NAMED(
+      "dynmsg", "std::vector layout is not supported, using the introspection functions instead");
+  }
+  return supported;
+}
+
+}  // namespace
+
+bool is_vector_layout_supported()
+{
+  static const bool supported = check_vector_layout();
+  return supported;
+}
+
 }  // namespace dynmsg
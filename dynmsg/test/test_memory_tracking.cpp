@@ -0,0 +1,127 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <yaml-cpp/yaml.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/memory_tracking.hpp"
+#include "dynmsg/message_reading.hpp"
+#include "dynmsg/msg_parser.hpp"
+#include "dynmsg/typesupport.hpp"
+
+// Report the allocations made with operator new to dynmsg, with their sizes, which are stored
+// before the allocated blocks
+constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+void * operator new(size_t size)
+{
+  void * block = std::malloc(HEADER_SIZE + size);
+  if (nullptr == block) {
+    throw std::bad_alloc();
+  }
+  *static_cast<size_t *>(block) = size;
+  dynmsg::memory_tracking::record_allocation(size);
+  return static_cast<char *>(block) + HEADER_SIZE;
+}
+
+void operator delete(void * ptr) noexcept
+{
+  if (nullptr == ptr) {
+    return;
+  }
+  void * block = static_cast<char *>(ptr) - HEADER_SIZE;
+  dynmsg::memory_tracking::record_deallocation(*static_cast<size_t *>(block));
+  std::free(block);
+}
+
+void operator delete(void * ptr, size_t) noexcept
+{
+  operator delete(ptr);
+}
+
+class TestMemoryTracking : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    type_info = dynmsg::c::get_type_info({"std_msgs", "Header"});
+    ASSERT_NE(nullptr, type_info);
+    dynmsg::memory_tracking::set_enabled(true);
+    dynmsg::memory_tracking::reset_last_conversion_memory();
+  }
+
+  void TearDown() override
+  {
+    dynmsg::memory_tracking::set_enabled(false);
+    dynmsg::memory_tracking::reset_last_conversion_memory();
+  }
+
+  // Parse a header with a frame ID of the given length, and return the memory used by parsing it
+  dynmsg::memory_tracking::ConversionMemory parse(size_t frame_id_length)
+  {
+    const std::string yaml = "{frame_id: " + std::string(frame_id_length, 'f') + "}";
+    dynmsg::c::DynamicMessage message = dynmsg::c::DynamicMessage::adopt(
+      dynmsg::c::yaml_and_typeinfo_to_rosmsg(type_info, yaml, nullptr));
+    return dynmsg::memory_tracking::get_last_conversion_memory();
+  }
+
+  const TypeInfo * type_info = nullptr;
+};
+
+TEST_F(TestMemoryTracking, disabled)
+{
+  dynmsg::memory_tracking::set_enabled(false);
+  EXPECT_FALSE(dynmsg::memory_tracking::is_enabled());
+  const auto memory = parse(10u);
+  EXPECT_EQ(0u, memory.peak_bytes);
+  EXPECT_EQ(0u, memory.allocated_bytes);
+  EXPECT_EQ(0u, memory.allocations);
+}
+
+TEST_F(TestMemoryTracking, to_yaml)
+{
+  dynmsg::c::DynamicMessage message(type_info);
+  const YAML::Node yaml = dynmsg::c::message_to_yaml(message.get());
+  const auto memory = dynmsg::memory_tracking::get_last_conversion_memory();
+  // The YAML nodes are still alive at the end of the conversion
+  EXPECT_LT(0u, memory.peak_bytes);
+  EXPECT_LE(memory.peak_bytes, memory.allocated_bytes);
+  EXPECT_LT(0u, memory.allocations);
+
+  // Allocations made outside of conversions are not counted
+  std::unique_ptr<char[]> other(new char[1000]);
+  const auto after = dynmsg::memory_tracking::get_last_conversion_memory();
+  EXPECT_EQ(memory.peak_bytes, after.peak_bytes);
+  EXPECT_EQ(memory.allocations, after.allocations);
+
+  dynmsg::memory_tracking::reset_last_conversion_memory();
+  EXPECT_EQ(0u, dynmsg::memory_tracking::get_last_conversion_memory().peak_bytes);
+}
+
+TEST_F(TestMemoryTracking, peak)
+{
+  const auto small = parse(10u);
+  const auto large = parse(100000u);
+  EXPECT_LT(0u, small.peak_bytes);
+  // The YAML nodes hold a copy of the frame ID, which is freed before the end of the conversion
+  EXPECT_LE(small.peak_bytes + 100000u - 10u, large.peak_bytes);
+  EXPECT_LE(large.peak_bytes, large.allocated_bytes);
+}
@@ -0,0 +1,230 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <yaml-cpp/yaml.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/message_reading.hpp"
+#include "dynmsg/message_size.hpp"
+#include "dynmsg/metrics.hpp"
+#include "dynmsg/msg_parser.hpp"
+#include "dynmsg/typesupport.hpp"
+
+class TestMetrics : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    type_info = dynmsg::c::get_type_info({"std_msgs", "Header"});
+    ASSERT_NE(nullptr, type_info);
+    dynmsg::metrics::reset();
+    dynmsg::metrics::set_enabled(true);
+  }
+
+  void TearDown() override
+  {
+    dynmsg::metrics::set_enabled(false);
+    dynmsg::metrics::reset();
+  }
+
+  void convert(size_t count)
+  {
+    dynmsg::c::DynamicMessage message(type_info);
+    for (size_t ii = 0; ii < count; ++ii) {
+      dynmsg::c::message_to_yaml(message.get());
+    }
+  }
+
+  static const dynmsg::metrics::SeriesSnapshot * find(
+    const dynmsg::metrics::Snapshot & snapshot, dynmsg::metrics::Operation operation)
+  {
+    for (const auto & series : snapshot.series) {
+      if (series.operation == operation && series.type == "std_msgs/msg/Header") {
+        return &series;
+      }
+    }
+    return nullptr;
+  }
+
+  static uint64_t get_error_count(
+    const dynmsg::metrics::SeriesSnapshot & series, dynmsg::metrics::ErrorKind kind)
+  {
+    return series.errors[static_cast<size_t>(kind)];
+  }
+
+  const TypeInfo * type_info = nullptr;
+};
+
+TEST_F(TestMetrics, disabled)
+{
+  dynmsg::metrics::set_enabled(false);
+  EXPECT_FALSE(dynmsg::metrics::is_enabled());
+  convert(2);
+  for (const auto & series : dynmsg::metrics::get_snapshot().series) {
+    EXPECT_EQ(0u, series.messages);
+    EXPECT_EQ(0u, series.latency.count);
+  }
+}
+
+TEST_F(TestMetrics, to_yaml)
+{
+  convert(5);
+  const auto snapshot = dynmsg::metrics::get_snapshot();
+  const auto series = find(snapshot, dynmsg::metrics::Operation::c_to_yaml);
+  ASSERT_NE(nullptr, series);
+  EXPECT_EQ(5u, series->messages);
+  // The serialized size of an empty header is the encapsulation, the stamp, and the length and the
+  // terminator of the frame ID
+  EXPECT_EQ(5u * (4u + 8u + 4u + 1u), series->bytes_in);
+  EXPECT_EQ(0u, series->bytes_out);
+  EXPECT_EQ(0u, get_error_count(*series, dynmsg::metrics::ErrorKind::conversion));
+  EXPECT_EQ(5u, series->latency.count);
+  uint64_t bucket_count = 0u;
+  uint64_t previous_bound = 0u;
+  for (const auto & bucket : series->latency.buckets) {
+    EXPECT_LT(previous_bound, bucket.first);
+    previous_bound = bucket.first;
+    bucket_count += bucket.second;
+  }
+  EXPECT_EQ(5u, bucket_count);
+  // The nested builtin_interfaces/msg/Time is part of the conversion of the header
+  for (const auto & other : snapshot.series) {
+    EXPECT_TRUE(other.type != "builtin_interfaces/msg/Time" || 0u == other.messages);
+  }
+}
+
+TEST_F(TestMetrics, from_yaml)
+{
+  const std::string yaml = "{stamp: {sec: 1}, frame_id: frame}";
+  RosMessage message = dynmsg::c::yaml_and_typeinfo_to_rosmsg(type_info, yaml, nullptr);
+  const size_t message_size = dynmsg::c::serialized_size(message);
+  dynmsg::c::ros_message_destroy(&message);
+
+  const auto series =
+    find(dynmsg::metrics::get_snapshot(), dynmsg::metrics::Operation::c_from_yaml);
+  ASSERT_NE(nullptr, series);
+  EXPECT_EQ(1u, series->messages);
+  EXPECT_EQ(yaml.size(), series->bytes_in);
+  EXPECT_EQ(4u + 8u + 4u + 6u, message_size);
+  EXPECT_EQ(message_size, series->bytes_out);
+}
+
+TEST_F(TestMetrics, errors)
+{
+  EXPECT_THROW(
+    dynmsg::c::yaml_and_typeinfo_to_rosmsg(type_info, "{stamp: {sec: [}", nullptr),
+    YAML::Exception);
+  EXPECT_THROW(
+    dynmsg::c::yaml_and_typeinfo_to_rosmsg(type_info, "{stamp: {sec: second}}", nullptr),
+    YAML::Exception);
+
+  const auto series =
+    find(dynmsg::metrics::get_snapshot(), dynmsg::metrics::Operation::c_from_yaml);
+  ASSERT_NE(nullptr, series);
+  EXPECT_EQ(0u, series->messages);
+  EXPECT_EQ(2u, get_error_count(*series, dynmsg::metrics::ErrorKind::yaml));
+  EXPECT_EQ(0u, get_error_count(*series, dynmsg::metrics::ErrorKind::conversion));
+  EXPECT_EQ(0u, series->bytes_out);
+  // Failed conversions are timed too
+  EXPECT_EQ(2u, series->latency.count);
+}
+
+TEST_F(TestMetrics, conversion_during_unwinding)
+{
+  // A conversion made by a destructor while an exception propagates does not fail
+  struct ConvertOnDestruction
+  {
+    ~ConvertOnDestruction()
+    {
+      dynmsg::c::DynamicMessage message(type_info);
+      dynmsg::c::message_to_yaml(message.get());
+    }
+    const TypeInfo * type_info;
+  };
+  EXPECT_THROW(
+    {
+      ConvertOnDestruction convert_on_destruction{type_info};
+      throw std::runtime_error("unwinding");
+    },
+    std::runtime_error);
+
+  const auto series =
+    find(dynmsg::metrics::get_snapshot(), dynmsg::metrics::Operation::c_to_yaml);
+  ASSERT_NE(nullptr, series);
+  EXPECT_EQ(1u, series->messages);
+  EXPECT_EQ(0u, get_error_count(*series, dynmsg::metrics::ErrorKind::conversion));
+}
+
+TEST_F(TestMetrics, reset)
+{
+  convert(2);
+  dynmsg::metrics::reset();
+  const auto series =
+    find(dynmsg::metrics::get_snapshot(), dynmsg::metrics::Operation::c_to_yaml);
+  ASSERT_NE(nullptr, series);
+  EXPECT_EQ(0u, series->messages);
+  EXPECT_EQ(0u, series->latency.count);
+  EXPECT_TRUE(series->latency.buckets.empty());
+}
+
+TEST_F(TestMetrics, exporters)
+{
+  convert(3);
+  const auto snapshot = dynmsg::metrics::get_snapshot();
+
+  const std::string text = dynmsg::metrics::to_prometheus_text(snapshot);
+  const std::string labels = "operation=\"c.to_yaml\",type=\"std_msgs/msg/Header\"";
+  EXPECT_NE(std::string::npos, text.find("# TYPE dynmsg_messages_total counter\n"));
+  EXPECT_NE(std::string::npos, text.find("dynmsg_messages_total{" + labels + "} 3\n"));
+  EXPECT_NE(std::string::npos, text.find("dynmsg_bytes_out_total{" + labels + "} 0\n"));
+  EXPECT_NE(
+    std::string::npos, text.find("dynmsg_errors_total{" + labels + ",kind=\"yaml\"} 0\n"));
+  EXPECT_NE(
+    std::string::npos,
+    text.find("dynmsg_conversion_latency_seconds_bucket{" + labels + ",le=\"+Inf\"} 3\n"));
+  // The histogram has the same buckets whatever the latencies, up to 2^37 - 1 nanoseconds
+  const std::string bucket = "dynmsg_conversion_latency_seconds_bucket{" + labels + ",le=";
+  size_t bucket_count = 0u;
+  for (size_t position = text.find(bucket); std::string::npos != position;
+    position = text.find(bucket, position + 1u))
+  {
+    ++bucket_count;
+  }
+  EXPECT_EQ(37u - 8u + 1u + 1u, bucket_count);
+  EXPECT_NE(std::string::npos, text.find(bucket + "\"0.000000255\"} "));
+  EXPECT_NE(std::string::npos, text.find(bucket + "\"137.438953471\"} 3\n"));
+  EXPECT_NE(
+    std::string::npos, text.find("dynmsg_conversion_latency_seconds_count{" + labels + "} 3\n"));
+
+  const YAML::Node json = YAML::Load(dynmsg::metrics::to_json(snapshot));
+  ASSERT_TRUE(json["series"].IsSequence());
+  bool found = false;
+  for (const auto & series : json["series"]) {
+    if (series["operation"].as<std::string>() == "c.to_yaml" &&
+      series["type"].as<std::string>() == "std_msgs/msg/Header")
+    {
+      found = true;
+      EXPECT_EQ(3u, series["messages"].as<uint64_t>());
+      EXPECT_EQ(0u, series["bytes_out"].as<uint64_t>());
+      EXPECT_EQ(0u, series["errors"]["yaml"].as<uint64_t>());
+      EXPECT_EQ(3u, series["latency"]["count"].as<uint64_t>());
+      EXPECT_TRUE(series["latency"]["buckets"].IsSequence());
+    }
+  }
+  EXPECT_TRUE(found);
+}
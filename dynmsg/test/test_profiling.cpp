@@ -0,0 +1,211 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/message_reading.hpp"
+#include "dynmsg/msg_parser.hpp"
+#include "dynmsg/profiling.hpp"
+#include "dynmsg/typesupport.hpp"
+
+// Count the allocations made by each thread with operator new, for the profiler to attribute them
+thread_local uint64_t allocation_count = 0u;
+thread_local uint64_t allocated_bytes = 0u;
+
+void * operator new(size_t size)
+{
+  ++allocation_count;
+  allocated_bytes += size;
+  void * ptr = std::malloc(0u == size ? 1u : size);
+  if (nullptr == ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void * ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+dynmsg::profiling::Allocations count_allocations()
+{
+  return dynmsg::profiling::Allocations{allocation_count, allocated_bytes};
+}
+
+class TestProfiling : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    type_info = dynmsg::c::get_type_info({"std_msgs", "Header"});
+    ASSERT_NE(nullptr, type_info);
+    dynmsg::profiling::reset();
+  }
+
+  void TearDown() override
+  {
+    dynmsg::profiling::stop();
+    dynmsg::profiling::reset();
+  }
+
+  void convert(size_t count)
+  {
+    dynmsg::c::DynamicMessage message(type_info);
+    for (size_t ii = 0; ii < count; ++ii) {
+      dynmsg::c::message_to_yaml(message.get());
+    }
+  }
+
+  static const dynmsg::profiling::FieldCost * find(
+    const std::vector<dynmsg::profiling::FieldCost> & report,
+    const std::string & operation,
+    const std::string & path)
+  {
+    for (const auto & cost : report) {
+      if (cost.operation == operation && cost.path == path) {
+        return &cost;
+      }
+    }
+    return nullptr;
+  }
+
+  const TypeInfo * type_info = nullptr;
+};
+
+TEST_F(TestProfiling, not_running)
+{
+  convert(3);
+  EXPECT_TRUE(dynmsg::profiling::get_report().empty());
+}
+
+TEST_F(TestProfiling, paths)
+{
+  dynmsg::profiling::start();
+  convert(4);
+  dynmsg::profiling::stop();
+  convert(4);
+
+  const auto report = dynmsg::profiling::get_report();
+  ASSERT_EQ(5u, report.size());
+  for (const auto & cost : report) {
+    EXPECT_EQ("c.to_yaml", cost.operation);
+    EXPECT_EQ("std_msgs/msg/Header", cost.type);
+    EXPECT_EQ(4u, cost.messages);
+    EXPECT_EQ(4u, cost.count) << cost.path;
+    EXPECT_LE(cost.self_ns, cost.total_ns);
+    EXPECT_EQ(0u, cost.total_allocations.count);
+  }
+  // The costs are sorted by decreasing self time
+  for (size_t ii = 1; ii < report.size(); ++ii) {
+    EXPECT_GE(report[ii - 1].self_ns, report[ii].self_ns);
+  }
+
+  const auto message = find(report, "c.to_yaml", "");
+  const auto stamp = find(report, "c.to_yaml", "stamp");
+  const auto sec = find(report, "c.to_yaml", "stamp.sec");
+  ASSERT_NE(nullptr, message);
+  ASSERT_NE(nullptr, stamp);
+  ASSERT_NE(nullptr, sec);
+  EXPECT_NE(nullptr, find(report, "c.to_yaml", "stamp.nanosec"));
+  EXPECT_NE(nullptr, find(report, "c.to_yaml", "frame_id"));
+  EXPECT_LE(stamp->total_ns, message->total_ns);
+  EXPECT_LE(sec->total_ns, stamp->total_ns);
+}
+
+TEST_F(TestProfiling, parsing)
+{
+  dynmsg::profiling::start();
+  RosMessage message = dynmsg::c::yaml_and_typeinfo_to_rosmsg(
+    type_info, "{stamp: {sec: 1}, frame_id: frame}", nullptr);
+  dynmsg::c::ros_message_destroy(&message);
+  dynmsg::profiling::stop();
+
+  const auto report = dynmsg::profiling::get_report();
+  EXPECT_NE(nullptr, find(report, "c.from_yaml", ""));
+  EXPECT_NE(nullptr, find(report, "c.from_yaml", "stamp.sec"));
+  EXPECT_NE(nullptr, find(report, "c.from_yaml", "frame_id"));
+  // Members missing from the YAML are not converted
+  EXPECT_EQ(nullptr, find(report, "c.from_yaml", "stamp.nanosec"));
+}
+
+TEST_F(TestProfiling, sampling)
+{
+  dynmsg::profiling::ProfilingOptions options;
+  options.sample_period = 3;
+  dynmsg::profiling::start(options);
+  convert(9);
+
+  const auto report = dynmsg::profiling::get_report();
+  ASSERT_FALSE(report.empty());
+  EXPECT_EQ(3u, report[0].messages);
+
+  dynmsg::profiling::reset();
+  EXPECT_TRUE(dynmsg::profiling::get_report().empty());
+}
+
+TEST_F(TestProfiling, allocations)
+{
+  dynmsg::profiling::ProfilingOptions options;
+  options.count_allocations = &count_allocations;
+  dynmsg::profiling::start(options);
+  convert(1);
+
+  const auto report = dynmsg::profiling::get_report();
+  const auto message = find(report, "c.to_yaml", "");
+  const auto frame_id = find(report, "c.to_yaml", "frame_id");
+  ASSERT_NE(nullptr, message);
+  ASSERT_NE(nullptr, frame_id);
+  // Building the YAML nodes allocates
+  EXPECT_LT(0u, frame_id->total_allocations.count);
+  EXPECT_LT(0u, frame_id->total_allocations.bytes);
+  // The allocations of the message are split between its members and itself
+  uint64_t self_allocations = 0u;
+  for (const auto & cost : report) {
+    EXPECT_LE(cost.self_allocations.count, cost.total_allocations.count);
+    self_allocations += cost.self_allocations.count;
+  }
+  EXPECT_EQ(message->total_allocations.count, self_allocations);
+}
+
+TEST_F(TestProfiling, write_report)
+{
+  dynmsg::profiling::start();
+  convert(2);
+  const auto report = dynmsg::profiling::get_report();
+
+  std::ostringstream all;
+  dynmsg::profiling::write_report(all, report);
+  EXPECT_NE(std::string::npos, all.str().find("stamp.nanosec"));
+  EXPECT_NE(std::string::npos, all.str().find("(message)"));
+
+  std::ostringstream first;
+  dynmsg::profiling::write_report(first, report, 1);
+  // A header line and a row
+  const std::string first_rows = first.str();
+  EXPECT_EQ(2, std::count(first_rows.begin(), first_rows.end(), '\n'));
+}
@@ -0,0 +1,166 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dynmsg/tracing.hpp"
+
+using dynmsg::tracing::Event;
+
+class TestTracing : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    dynmsg::tracing::set_enabled_categories(0u);
+    dynmsg::tracing::drain([](const Event &) {});
+  }
+
+  void TearDown() override
+  {
+    dynmsg::tracing::stop_draining();
+    dynmsg::tracing::set_enabled_categories(0u);
+  }
+
+  static std::vector<Event> drain()
+  {
+    std::vector<Event> events;
+    dynmsg::tracing::drain([&events](const Event & event) {events.push_back(event);});
+    return events;
+  }
+};
+
+TEST_F(TestTracing, disabled)
+{
+  int evaluated = 0;
+  DYNMSG_TRACE(dynmsg::tracing::CATEGORY_PARSER, "event", nullptr, ++evaluated);
+  EXPECT_EQ(0, evaluated);
+  EXPECT_TRUE(drain().empty());
+
+  dynmsg::tracing::set_enabled_categories(dynmsg::tracing::CATEGORY_READER);
+  EXPECT_FALSE(dynmsg::tracing::is_enabled(dynmsg::tracing::CATEGORY_PARSER));
+  DYNMSG_TRACE(dynmsg::tracing::CATEGORY_PARSER, "event", nullptr, ++evaluated);
+  EXPECT_EQ(0, evaluated);
+  EXPECT_TRUE(drain().empty());
+}
+
+TEST_F(TestTracing, enabled)
+{
+  dynmsg::tracing::set_enabled_categories(dynmsg::tracing::CATEGORY_PARSER);
+  EXPECT_EQ(dynmsg::tracing::CATEGORY_PARSER, dynmsg::tracing::get_enabled_categories());
+  DYNMSG_TRACE(dynmsg::tracing::CATEGORY_PARSER, "first", "a", 1);
+  DYNMSG_TRACE(dynmsg::tracing::CATEGORY_READER, "ignored", "b", 2);
+  DYNMSG_TRACE(dynmsg::tracing::CATEGORY_PARSER, "second", nullptr, 3);
+
+  const std::vector<Event> events = drain();
+  ASSERT_EQ(2u, events.size());
+  EXPECT_STREQ("first", events[0].what);
+  EXPECT_STREQ("a", events[0].name);
+  EXPECT_EQ(1, events[0].value);
+  EXPECT_EQ(dynmsg::tracing::CATEGORY_PARSER, events[0].category);
+  EXPECT_STREQ("second", events[1].what);
+  EXPECT_EQ(nullptr, events[1].name);
+  EXPECT_EQ(3, events[1].value);
+  EXPECT_LE(events[0].timestamp, events[1].timestamp);
+  EXPECT_EQ(events[0].thread_index, events[1].thread_index);
+
+  // Drained events are removed
+  EXPECT_TRUE(drain().empty());
+}
+
+TEST_F(TestTracing, parse_categories)
+{
+  EXPECT_EQ(0u, dynmsg::tracing::parse_categories(""));
+  EXPECT_EQ(dynmsg::tracing::CATEGORY_PARSER, dynmsg::tracing::parse_categories("parser"));
+  EXPECT_EQ(
+    dynmsg::tracing::CATEGORY_PARSER | dynmsg::tracing::CATEGORY_READER,
+    dynmsg::tracing::parse_categories("reader,parser"));
+  EXPECT_EQ(dynmsg::tracing::CATEGORY_ALL, dynmsg::tracing::parse_categories("all"));
+  EXPECT_THROW(dynmsg::tracing::parse_categories("parser,unknown"), std::runtime_error);
+}
+
+TEST_F(TestTracing, threads)
+{
+  dynmsg::tracing::set_enabled_categories(dynmsg::tracing::CATEGORY_ALL);
+  DYNMSG_TRACE(dynmsg::tracing::CATEGORY_READER, "main", nullptr, 0);
+  std::thread thread([]() {DYNMSG_TRACE(dynmsg::tracing::CATEGORY_READER, "other", nullptr, 0);});
+  thread.join();
+
+  // The events of the thread are kept after it exits
+  const std::vector<Event> events = drain();
+  ASSERT_EQ(2u, events.size());
+  EXPECT_NE(events[0].thread_index, events[1].thread_index);
+}
+
+TEST_F(TestTracing, dropped_events)
+{
+  dynmsg::tracing::set_enabled_categories(dynmsg::tracing::CATEGORY_ALL);
+  const uint64_t dropped_before = dynmsg::tracing::get_dropped_event_count();
+  // Without draining, more events than a ring can hold
+  const size_t recorded = 100000u;
+  std::thread thread(
+    [recorded]() {
+      for (size_t ii = 0; ii < recorded; ++ii) {
+        DYNMSG_TRACE(dynmsg::tracing::CATEGORY_PARSER, "event", nullptr, ii);
+      }
+    });
+  thread.join();
+
+  const std::vector<Event> events = drain();
+  const uint64_t dropped = dynmsg::tracing::get_dropped_event_count() - dropped_before;
+  EXPECT_LT(0u, dropped);
+  EXPECT_EQ(recorded, events.size() + dropped);
+  // The oldest events are kept
+  for (size_t ii = 0; ii < events.size(); ++ii) {
+    EXPECT_EQ(static_cast<int64_t>(ii), events[ii].value);
+  }
+}
+
+TEST_F(TestTracing, start_draining)
+{
+  std::mutex mutex;
+  std::vector<Event> events;
+  dynmsg::tracing::start_draining(
+    [&mutex, &events](const Event & event) {
+      std::lock_guard<std::mutex> lock(mutex);
+      events.push_back(event);
+    },
+    std::chrono::milliseconds(1));
+  dynmsg::tracing::set_enabled_categories(dynmsg::tracing::CATEGORY_ALL);
+  for (int ii = 0; ii < 10; ++ii) {
+    DYNMSG_TRACE(dynmsg::tracing::CATEGORY_PARSER, "event", nullptr, ii);
+  }
+
+  // Stopping drains the remaining events
+  dynmsg::tracing::stop_draining();
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(10u, events.size());
+  EXPECT_EQ(9, events.back().value);
+}
+
+TEST_F(TestTracing, write_event)
+{
+  const Event event{42, 3u, dynmsg::tracing::CATEGORY_READER, "member_to_yaml", "data", 7};
+  std::ostringstream stream;
+  dynmsg::tracing::write_event(stream, event);
+  EXPECT_EQ("[dynmsg] 42 thread 3 reader member_to_yaml data 7", stream.str());
+}
@@ -24,6 +24,18 @@ TEST(TestTypesupport, c)
   EXPECT_EQ(nullptr, info_bad);
 }
 
+TEST(TestTypesupport, c_service)
+{
+  const ServiceTypeInfo * info =
+    dynmsg::c::get_service_type_info({"example_interfaces", "AddTwoInts"});
+  ASSERT_NE(nullptr, info);
+  EXPECT_STREQ("AddTwoInts_Request", info->request_members_->message_name_);
+  EXPECT_STREQ("AddTwoInts_Response", info->response_members_->message_name_);
+  const ServiceTypeInfo * info_bad =
+    dynmsg::c::get_service_type_info({"example_interfaces", "SuperRealSrv"});
+  EXPECT_EQ(nullptr, info_bad);
+}
+
 TEST(TestTypesupport, cpp)
 {
   const TypeInfo_Cpp * info = dynmsg::cpp::get_type_info({"std_msgs", "String"});
@@ -31,3 +43,16 @@ TEST(TestTypesupport, cpp)
   const TypeInfo_Cpp * info_bad = dynmsg::cpp::get_type_info({"super_msgs", "SuperRealMsg"});
   EXPECT_EQ(nullptr, info_bad);
 }
+
+TEST(TestTypesupport, type_name)
+{
+  const TypeInfo * info = dynmsg::c::get_type_info({"std_msgs", "Header"});
+  ASSERT_NE(nullptr, info);
+  const TypeInfo_Cpp * info_cpp = dynmsg::cpp::get_type_info({"std_msgs", "Header"});
+  ASSERT_NE(nullptr, info_cpp);
+  EXPECT_EQ(
+    "std_msgs/msg/Header", dynmsg::get_type_name(info->message_namespace_, info->message_name_));
+  EXPECT_EQ(
+    "std_msgs/msg/Header",
+    dynmsg::get_type_name(info_cpp->message_namespace_, info_cpp->message_name_));
+}
@@ -67,3 +67,26 @@ TEST(TestVectorUtils, get_vector_size)
   std::vector<void *> vector_void;
   EXPECT_EQ(0ul, _get_vector_size(vector_void));
 }
+
+TEST(TestVectorUtils, get_vector_data)
+{
+  std::vector<some_custom_object> vector_custom(3);
+  vector_custom.reserve(10);
+  const uint8_t * vector = reinterpret_cast<const uint8_t *>(&vector_custom);
+  EXPECT_EQ(
+    reinterpret_cast<const uint8_t *>(vector_custom.data()), dynmsg::get_vector_data(vector));
+  EXPECT_EQ(10ul, dynmsg::get_vector_capacity(vector, sizeof(some_custom_object)));
+
+  std::vector<double> vector_empty;
+  EXPECT_EQ(nullptr, dynmsg::get_vector_data(reinterpret_cast<const uint8_t *>(&vector_empty)));
+}
+
+TEST(TestVectorUtils, is_vector_layout_supported)
+{
+  // The standard libraries of the supported platforms all have the assumed layout
+#if defined(__GLIBCXX__) || defined(_LIBCPP_VERSION)
+  EXPECT_TRUE(dynmsg::is_vector_layout_supported());
+#endif
+  // The result is cached
+  EXPECT_EQ(dynmsg::is_vector_layout_supported(), dynmsg::is_vector_layout_supported());
+}
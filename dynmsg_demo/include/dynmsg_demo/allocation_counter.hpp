@@ -0,0 +1,36 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG_DEMO__ALLOCATION_COUNTER_HPP_
+#define DYNMSG_DEMO__ALLOCATION_COUNTER_HPP_
+
+#include <cstddef>
+
+// Number of heap allocations made by the process, and the bytes requested by them
+struct AllocationCounts
+{
+  size_t allocations;
+  size_t bytes;
+};
+
+// Get the number of heap allocations made by the process so far.
+// Only available in programs linked with the dynmsg_demo_allocation_counter library, which replaces
+// the global operator new to count allocations.
+AllocationCounts get_allocation_counts();
+
+// Get the number of heap allocations made by the calling thread so far.
+// Only available in programs linked with the dynmsg_demo_allocation_counter library.
+AllocationCounts get_thread_allocation_counts();
+
+#endif  // DYNMSG_DEMO__ALLOCATION_COUNTER_HPP_
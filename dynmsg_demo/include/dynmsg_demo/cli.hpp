@@ -15,8 +15,10 @@
 #ifndef DYNMSG_DEMO__CLI_HPP_
 #define DYNMSG_DEMO__CLI_HPP_
 
+#include <cstddef>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 // Commands available in the CLI tool
 enum class Command
@@ -24,19 +26,35 @@ enum class Command
   Unknown,
   TopicEcho,
   TopicPublish,
+  TopicHz,
+  TopicBandwidth,
+  TopicLatency,
   ServiceCall,
   ServiceHost,
   Discover,
+  Bench,
 };
 
 struct Arguments
 {
   Command cmd;
   std::unordered_map<std::string, std::string> params;
+  // Topics given to commands that accept several of them
+  std::vector<std::string> topics;
 };
 
 // Parse the arguments given on the command line into a command and its arguments.
 // Some simple error checking is performed only.
 Arguments parse_arguments(int argc, char ** argv);
 
+// Get an optional non-negative integer parameter, e.g. a count, or the default value if it was not
+// given.
+// Throws std::runtime_error if the value given is not a non-negative integer.
+size_t get_count_param(const Arguments & args, const std::string & name, size_t default_value);
+
+// Get an optional non-negative floating-point parameter, e.g. a duration in seconds, or the default
+// value if it was not given.
+// Throws std::runtime_error if the value given is not a non-negative number.
+double get_seconds_param(const Arguments & args, const std::string & name, double default_value);
+
 #endif  // DYNMSG_DEMO__CLI_HPP_
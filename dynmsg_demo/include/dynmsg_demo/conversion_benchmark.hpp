@@ -0,0 +1,63 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG_DEMO__CONVERSION_BENCHMARK_HPP_
+#define DYNMSG_DEMO__CONVERSION_BENCHMARK_HPP_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "dynmsg_demo/allocation_counter.hpp"
+#include "dynmsg_demo/type_registry.hpp"
+
+struct BenchmarkOptions
+{
+  // Time to run each benchmark for, in seconds
+  double duration;
+  // Function giving the number of allocations made so far, or null to not count allocations
+  AllocationCounts (* count_allocations)();
+};
+
+// The result of running one conversion benchmark
+struct BenchmarkResult
+{
+  std::string name;
+  size_t iterations;
+  double ns_per_message;
+  // Size of the data produced or consumed for each message, or 0 if it does not apply
+  size_t bytes_per_message;
+  // Allocations made for each message, or negative if allocations were not counted
+  double allocations_per_message;
+};
+
+// Measure how fast dynmsg converts messages of a type, without using the middleware.
+//
+// The message is parsed from the given YAML representation, or left with its default values if the
+// YAML is empty. The benchmarks cover initializing and destroying messages, converting them to and
+// from YAML, rendering them as JSON, serializing and deserializing them to CDR, and converting
+// between the C and C++ layouts. Benchmarks of the C++ layout are skipped if its introspection
+// information cannot be loaded.
+//
+// Throws std::runtime_error if the message cannot be parsed, or if a conversion fails.
+std::vector<BenchmarkResult> run_conversion_benchmarks(
+  const MessageType & type,
+  const std::string & message_yaml,
+  const BenchmarkOptions & options);
+
+// Print benchmark results as a table.
+void print_benchmark_results(const std::vector<BenchmarkResult> & results, std::ostream & out);
+
+#endif  // DYNMSG_DEMO__CONVERSION_BENCHMARK_HPP_
@@ -0,0 +1,144 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG_DEMO__ECHO_PIPELINE_HPP_
+#define DYNMSG_DEMO__ECHO_PIPELINE_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dynmsg/typesupport.hpp"
+#include "dynmsg_demo/type_registry.hpp"
+
+#include "rcl/types.h"
+
+// Text formats that messages can be printed in
+enum class OutputFormat
+{
+  Yaml,
+  Json,
+};
+
+// Parse the name of an output format ("yaml" or "json").
+// Throws std::runtime_error if the name is not a known format.
+OutputFormat parse_output_format(const std::string & name);
+
+// Convert a ROS message to text in the given format, without a trailing newline.
+// If a topic is given, the text is tagged with it, to tell messages from different topics apart.
+std::string render_message(
+  const RosMessage & message,
+  OutputFormat format,
+  const std::string & topic = std::string());
+
+// Get the text to print after each message in the given format.
+const char * message_separator(OutputFormat format);
+
+// Converts serialized messages to text on a pool of worker threads, and prints them in the order
+// they were received.
+//
+// Messages are taken into a fixed ring of reusable serialized message buffers. Buffers are handed
+// between the receiving thread and the worker threads through atomic indices, so the receiving
+// thread never waits for messages to be converted or printed. When all buffers are in use, further
+// messages are taken into a separate buffer and dropped.
+//
+// next_buffer() and commit() must only be called from a single thread.
+class EchoPipeline
+{
+public:
+  // Start the worker threads.
+  // Throws std::runtime_error if the buffers cannot be allocated.
+  EchoPipeline(
+    OutputFormat format,
+    size_t threads,
+    size_t capacity,
+    std::ostream & out);
+  // Waits for all committed messages to be printed.
+  ~EchoPipeline();
+
+  EchoPipeline(const EchoPipeline &) = delete;
+  EchoPipeline & operator=(const EchoPipeline &) = delete;
+
+  // Get the buffer to take the next message into.
+  // If all the buffers in the ring are in use, the returned buffer is not part of the ring, and the
+  // message taken into it will be dropped when it is committed.
+  rcl_serialized_message_t * next_buffer();
+  // Queue the message taken into the buffer returned by next_buffer() for printing.
+  // If topic is not empty, the message is tagged with it. The type and the topic must remain valid
+  // until the message has been printed.
+  void commit(const MessageType & type, const std::string & topic);
+
+  // Wait for all committed messages to be printed, and stop the worker threads.
+  void finish();
+
+  // Get the number of messages that were dropped because all buffers were in use.
+  size_t dropped() const
+  {
+    return dropped_;
+  }
+
+private:
+  enum SlotState : int
+  {
+    SlotFree,
+    SlotFilled,
+    SlotRendered,
+  };
+
+  struct Slot
+  {
+    rcl_serialized_message_t buffer;
+    const MessageType * type;
+    const std::string * topic;
+    std::string text;
+    std::atomic<int> state;
+  };
+
+  void run_worker();
+  void print_rendered();
+
+  const OutputFormat format_;
+  std::ostream & out_;
+
+  std::unique_ptr<Slot[]> slots_;
+  const size_t capacity_;
+  rcl_serialized_message_t overflow_buffer_;
+  bool overflowing_;
+  size_t dropped_;
+
+  // Only used by the receiving thread
+  size_t write_index_;
+  // Number of messages committed to the ring
+  std::atomic<size_t> committed_;
+  // Next message to be converted by a worker thread
+  std::atomic<size_t> claim_index_;
+  // Next message to be printed, guarded by print_mutex_
+  size_t print_index_;
+  std::mutex print_mutex_;
+  std::condition_variable printed_;
+
+  // Used only to put idle worker threads to sleep
+  std::mutex idle_mutex_;
+  std::condition_variable work_available_;
+  std::atomic<bool> stopping_;
+  std::vector<std::thread> workers_;
+};
+
+#endif  // DYNMSG_DEMO__ECHO_PIPELINE_HPP_
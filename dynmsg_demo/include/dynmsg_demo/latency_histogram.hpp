@@ -0,0 +1,76 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG_DEMO__LATENCY_HISTOGRAM_HPP_
+#define DYNMSG_DEMO__LATENCY_HISTOGRAM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// A histogram of latencies in nanoseconds, in the style of HdrHistogram.
+//
+// Values are counted in log-linear buckets: each power of two is split into SUB_BUCKET_COUNT
+// buckets of equal width. Values of any magnitude are therefore recorded with a relative error of
+// less than 1%, in a fixed amount of memory, and recording a value is cheap.
+class LatencyHistogram
+{
+public:
+  static constexpr size_t SUB_BUCKET_BITS = 7;
+  static constexpr size_t SUB_BUCKET_COUNT = size_t{1} << SUB_BUCKET_BITS;
+
+  LatencyHistogram();
+
+  // Record a value.
+  void record(uint64_t value);
+  // Add all the values recorded in another histogram.
+  void add(const LatencyHistogram & other);
+  // Remove all the values.
+  void reset();
+
+  uint64_t count() const
+  {
+    return count_;
+  }
+  // The exact smallest and largest values recorded, or 0 if there are none
+  uint64_t min() const;
+  uint64_t max() const
+  {
+    return max_;
+  }
+  // The exact mean of the values recorded, or 0 if there are none
+  double mean() const;
+
+  // Get the value below which the given percentage of the values fall, e.g. 99.9.
+  // This is the highest value that is counted in the same bucket, but at most the largest value.
+  uint64_t percentile(double percentage) const;
+
+  // Print the distribution of the values as a table of percentiles, like HdrHistogram does.
+  // Values are divided by unit_scale, e.g. 1000 to print them in microseconds.
+  void print_distribution(std::ostream & out, double unit_scale) const;
+
+private:
+  static size_t bucket_index(uint64_t value);
+  static uint64_t bucket_highest_value(size_t index);
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_;
+  uint64_t min_;
+  uint64_t max_;
+  // Sum of the values, as a double so that it cannot overflow
+  double sum_;
+};
+
+#endif  // DYNMSG_DEMO__LATENCY_HISTOGRAM_HPP_
@@ -0,0 +1,61 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG_DEMO__MESSAGE_FIELDS_HPP_
+#define DYNMSG_DEMO__MESSAGE_FIELDS_HPP_
+
+#include <cstdint>
+#include <string>
+
+#include "dynmsg/typesupport.hpp"
+
+// A numeric member of a message, which can be read and written in place
+struct NumericField
+{
+  // The rosidl_typesupport_introspection_c__ROS_TYPE_* type of the member
+  uint8_t type_id;
+  uint8_t * data;
+};
+
+// Find a numeric member of a message by its path, e.g. "header.stamp.sec".
+// Members of nested messages are separated by dots. Array and sequence members are not supported.
+// Throws std::runtime_error if there is no such member, or if it is not a single numeric value.
+NumericField find_numeric_field(const RosMessage & message, const std::string & path);
+
+// Set the value of a numeric member, converting it to the member's type.
+void set_numeric_field(const NumericField & field, int64_t value);
+
+// Get the value of a numeric member, converted to an integer.
+int64_t get_numeric_field(const NumericField & field);
+
+// A time stamp in a message.
+// This is either a message with sec and nanosec members, like builtin_interfaces/Time, or an
+// integer member holding a number of nanoseconds, in which case sec.data is null.
+struct StampField
+{
+  NumericField sec;
+  NumericField nanosec;
+};
+
+// Find a time stamp member of a message by its path, e.g. "header.stamp".
+// Throws std::runtime_error if there is no such member, or if it is not a time stamp.
+StampField find_stamp_field(const RosMessage & message, const std::string & path);
+
+// Set the value of a time stamp member, in nanoseconds.
+void set_stamp_field(const StampField & field, int64_t nanoseconds);
+
+// Get the value of a time stamp member, in nanoseconds.
+int64_t get_stamp_field(const StampField & field);
+
+#endif  // DYNMSG_DEMO__MESSAGE_FIELDS_HPP_
@@ -0,0 +1,84 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG_DEMO__TOPIC_STATISTICS_HPP_
+#define DYNMSG_DEMO__TOPIC_STATISTICS_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Statistics over a window of the most recent messages received on a topic
+struct WindowSummary
+{
+  // Number of messages in the window
+  size_t count;
+  // Messages per second, from the first to the last message in the window
+  double rate;
+  // Time between consecutive messages, in seconds
+  double mean_interval;
+  double min_interval;
+  double max_interval;
+  double stddev_interval;
+  // Serialized bytes per second, from the first to the last message in the window
+  double bytes_per_second;
+  // Serialized size of the messages, in bytes
+  double mean_size;
+  size_t min_size;
+  size_t max_size;
+};
+
+// Records the arrival times and sizes of the messages received on a topic, to measure its rate and
+// bandwidth.
+//
+// Only the most recent messages are kept, in a ring of a fixed size, so the memory used does not
+// grow over time, and adding a message is cheap. The statistics are computed on demand.
+class TopicStatistics
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Create statistics over a window of the given number of messages, at least 2.
+  explicit TopicStatistics(size_t window);
+
+  // Record a message, received at the given time, with the given serialized size.
+  void add(const Clock::time_point & arrival, size_t size);
+
+  // Compute the statistics of the messages in the window.
+  // The rates and intervals are 0 if there are fewer than two messages in the window.
+  WindowSummary summarize() const;
+
+  // Get the total number of messages recorded, including those no longer in the window.
+  uint64_t total_count() const
+  {
+    return total_count_;
+  }
+
+private:
+  struct Sample
+  {
+    Clock::time_point arrival;
+    size_t size;
+  };
+
+  // Number of samples kept; the capacity of samples_ may be larger
+  size_t window_;
+  std::vector<Sample> samples_;
+  // Index of the next sample to overwrite
+  size_t next_;
+  uint64_t total_count_;
+};
+
+#endif  // DYNMSG_DEMO__TOPIC_STATISTICS_HPP_
@@ -0,0 +1,79 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DYNMSG_DEMO__TYPE_REGISTRY_HPP_
+#define DYNMSG_DEMO__TYPE_REGISTRY_HPP_
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+
+#include "dynmsg/typesupport.hpp"
+
+// The type support and introspection information of a message type
+struct MessageType
+{
+  InterfaceTypeName name;
+  const TypeInfo * type_info;
+  const TypeSupport * type_support;
+};
+
+// The type support of a service type, and the introspection information of its request and
+// response message types
+struct ServiceType
+{
+  InterfaceTypeName name;
+  const TypeInfo * request_type_info;
+  const TypeInfo * response_type_info;
+  const ServiceTypeSupport * type_support;
+};
+
+// Loads the type support and introspection information of message and service types once per
+// type, so that they are shared by all the topics and services of the same type.
+// Both are resolved together the first time a type is requested, and are cached from then on.
+//
+// The registry may be used from several threads at once.
+class TypeRegistry
+{
+public:
+  // Get the registry shared by the whole process.
+  static TypeRegistry & shared();
+
+  // Get a message type, loading it the first time it is requested.
+  // The returned reference remains valid as long as the registry exists.
+  // Throws std::runtime_error if the type support or the introspection information of the type
+  // cannot be loaded.
+  const MessageType & get(const InterfaceTypeName & interface_type);
+  // Get a service type, loading it the first time it is requested.
+  // The returned reference remains valid as long as the registry exists.
+  // Throws std::runtime_error if the type support or the introspection information of the type
+  // cannot be loaded.
+  const ServiceType & get_service(const InterfaceTypeName & interface_type);
+
+  // Get the number of message and service types loaded.
+  size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return types_.size() + services_.size();
+  }
+
+private:
+  // Guards the maps. Elements of a std::map are never moved, so references to them remain valid
+  // without holding the lock.
+  mutable std::mutex mutex_;
+  std::map<InterfaceTypeName, MessageType> types_;
+  std::map<InterfaceTypeName, ServiceType> services_;
+};
+
+#endif  // DYNMSG_DEMO__TYPE_REGISTRY_HPP_
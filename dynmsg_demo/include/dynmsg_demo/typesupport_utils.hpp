@@ -15,8 +15,10 @@
 #ifndef DYNMSG_DEMO__TYPESUPPORT_UTILS_HPP_
 #define DYNMSG_DEMO__TYPESUPPORT_UTILS_HPP_
 
+#include <functional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "dynmsg/typesupport.hpp"
 
@@ -29,7 +31,8 @@ extern "C"
 // The topic must be being published or subscribed to by at least one node. If it is not, then the
 // topic will not exist and so no type information will be retrievable.
 // Additionally, the topic must have been discovered by this node. This may require waiting some
-// time after starting calling rcl_init() for dynamic discovery to discover the topic.
+// time after starting calling rcl_init() for dynamic discovery to discover the topic, which
+// wait_for_topic_types() does.
 InterfaceTypeName get_topic_type(const rcl_node_t * node, const std::string & topic);
 // Split a type specified as a string into the namespace and type name.
 // The string must be in the format "[namespace]/[type]", for example "example_interfaces/Int32".
@@ -44,6 +47,39 @@ InterfaceTypeName get_topic_type_from_string_type(const std::string & type);
 // function, when called, provides a pointer to the type support structure for the specified
 // interface type. This pointer is returned. It can be passed to functions such as
 // rcl_subscription_init().
+// The symbol is looked up again on every call; TypeRegistry caches the result together with the
+// introspection information of the type.
 const TypeSupport * get_type_support(const InterfaceTypeName & interface_type);
+
+// Search for and load the type support library for a single service type.
+// This works like get_type_support(), but loads a function named following the pattern
+// "rosidl_typesupport_c__get_service_type_support_handle__[namespace]__srv__[type]". The returned
+// type support can be passed to functions such as rcl_client_init() and rcl_service_init().
+const ServiceTypeSupport * get_service_type_support(const InterfaceTypeName & interface_type);
 }  // extern "C"
+
+// Wait until the ROS graph information known to a node satisfies a condition.
+// The condition is checked straight away, and again each time the node's graph guard condition is
+// triggered, so this returns as soon as discovery has found what the condition needs. Returns
+// false if the condition is not satisfied before the timeout in seconds elapses, or waits forever
+// if the timeout is 0.
+bool wait_for_graph(
+  const rcl_node_t * node,
+  const std::function<bool()> & condition,
+  double timeout);
+
+// Wait for each of the given topics to have a publisher, and get their types.
+// Throws std::runtime_error if any topic has no publisher once the timeout in seconds has elapsed,
+// or waits forever if the timeout is 0.
+std::vector<InterfaceTypeName> wait_for_topic_types(
+  const rcl_node_t * node,
+  const std::vector<std::string> & topics,
+  double timeout);
+
+// Wait until the ROS graph information known to a node has not changed for the quiet period, or
+// until the timeout elapses, both in seconds. If the timeout is 0, waits as long as the graph keeps
+// changing.
+// Used when there is nothing specific to wait for, for example to list everything in the graph.
+void wait_for_graph_to_settle(const rcl_node_t * node, double quiet_period, double timeout);
+
 #endif  // DYNMSG_DEMO__TYPESUPPORT_UTILS_HPP_
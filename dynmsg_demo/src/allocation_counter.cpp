@@ -0,0 +1,114 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "dynmsg_demo/allocation_counter.hpp"
+
+// Replacements for the global allocation functions, which count every allocation made with
+// operator new before forwarding it to malloc().
+// Allocations made directly with malloc(), e.g. by the rosidl_runtime_c functions, are not counted,
+// unlike in the allocation counting of the test_dynmsg benchmarks, which replaces malloc() too.
+
+namespace
+{
+
+std::atomic<size_t> allocation_count(0);
+std::atomic<size_t> allocated_bytes(0);
+
+// Allocations of each thread, for the profiler, which attributes the allocations of each thread to
+// the conversion it is running. These are only integers, so that the thread_local variable is
+// initialized statically, and can be used from operator new at any time in the life of the thread.
+thread_local AllocationCounts thread_counts = {0, 0};
+
+void * counted_allocate(size_t size) noexcept
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  AllocationCounts & counts = thread_counts;
+  ++counts.allocations;
+  counts.bytes += size;
+  // malloc(0) may return null, but operator new must return a unique pointer
+  return std::malloc(0 == size ? 1 : size);
+}
+
+}  // namespace
+
+AllocationCounts get_allocation_counts()
+{
+  return AllocationCounts{
+    allocation_count.load(std::memory_order_relaxed),
+    allocated_bytes.load(std::memory_order_relaxed)};
+}
+
+AllocationCounts get_thread_allocation_counts()
+{
+  return thread_counts;
+}
+
+void * operator new(size_t size)
+{
+  void * ptr = counted_allocate(size);
+  if (nullptr == ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void * operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void * operator new(size_t size, const std::nothrow_t &) noexcept
+{
+  return counted_allocate(size);
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+  return counted_allocate(size);
+}
+
+void operator delete(void * ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, const std::nothrow_t &) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr, const std::nothrow_t &) noexcept
+{
+  std::free(ptr);
+}
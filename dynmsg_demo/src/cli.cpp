@@ -16,6 +16,7 @@
 
 #include <cstring>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
 
@@ -24,15 +25,73 @@ using namespace std::string_literals;
 void print_help_and_exit(const char * program_name)
 {
   std::cout << "Usage:\n" <<
-    "  " << program_name << " echo <topic>\n" <<
-    "  " << program_name << " publish <topic> <type> <message>\n" <<
-    "  " << program_name << " call <service> <request>\n" <<
-    "  " << program_name << " host <service> <response>\n" <<
-    "  " << program_name << " discover\n" <<
+    "  " << program_name << " echo [<topic>...] [--regex <pattern>] [--count <n>]\n" <<
+    "      [--timeout <seconds>] [--threads <n>] [--format yaml|json]\n" <<
+    "      [--discovery-timeout <seconds>] [--profile]\n" <<
+    "  " << program_name << " publish <topic> <type> <message> [--rate <hz>] [--count <n>]\n" <<
+    "      [--duration <seconds>] [--burst <n>] [--sequence-field <field>]\n" <<
+    "      [--stamp-field <field>]\n" <<
+    "  " << program_name << " latency <topic> --stamp-field <field> [--count <n>]\n" <<
+    "      [--timeout <seconds>] [--discovery-timeout <seconds>]\n" <<
+    "  " << program_name << " hz <topic> [<topic>...] [--window <n>] [--timeout <seconds>]\n" <<
+    "      [--discovery-timeout <seconds>]\n" <<
+    "  " << program_name << " bw <topic> [<topic>...] [--window <n>] [--timeout <seconds>]\n" <<
+    "      [--discovery-timeout <seconds>]\n" <<
+    "  " << program_name << " call <service> <type> <request> [--rate <hz>] [--count <n>]\n" <<
+    "      [--timeout <seconds>]\n" <<
+    "  " << program_name << " host <service> <type> <response> [--count <n>]\n" <<
+    "      [--timeout <seconds>]\n" <<
+    "  " << program_name << " discover [--discovery-timeout <seconds>]\n" <<
+    "  " << program_name << " bench <type> [<message>] [--duration <seconds>] [--profile]\n" <<
     std::endl;
   exit(1);
 }
 
+// Optional arguments of a command, with whether each of them takes a value
+using OptionSpec = std::unordered_map<std::string, bool>;
+
+// Parse the optional arguments following the positional arguments of a command.
+// Options are given as "--name value", or just "--name" for flags.
+void parse_options(
+  int argc,
+  char ** argv,
+  int first_option,
+  const OptionSpec & spec,
+  Arguments & args)
+{
+  for (int ii = first_option; ii < argc; ++ii) {
+    const std::string arg = argv[ii];
+    if (arg.rfind("--", 0) != 0) {
+      print_help_and_exit(argv[0]);
+    }
+    const auto option = spec.find(arg.substr(2));
+    if (option == spec.end()) {
+      std::cout << "Unknown option '" << arg << "'\n";
+      print_help_and_exit(argv[0]);
+    }
+    if (!option->second) {
+      args.params[option->first] = "true";
+      continue;
+    }
+    if (ii + 1 >= argc) {
+      std::cout << "Missing value for option '" << arg << "'\n";
+      print_help_and_exit(argv[0]);
+    }
+    args.params[option->first] = argv[++ii];
+  }
+}
+
+// Collect the topics given as positional arguments, up to the first optional argument.
+// Returns the index of the first optional argument.
+int parse_topics(int argc, char ** argv, int first_topic, Arguments & args)
+{
+  int ii = first_topic;
+  for (; ii < argc && std::string(argv[ii]).rfind("--", 0) != 0; ++ii) {
+    args.topics.push_back(argv[ii]);
+  }
+  return ii;
+}
+
 Arguments parse_arguments(int argc, char ** argv)
 {
   if (argc < 2 ||
@@ -46,10 +105,15 @@ Arguments parse_arguments(int argc, char ** argv)
 
   if (argv[1] == "echo"s) {
     args.cmd = Command::TopicEcho;
-    if (argc < 3) {
+    const int first_option = parse_topics(argc, argv, 2, args);
+    parse_options(
+      argc, argv, first_option,
+      {{"regex", true}, {"count", true}, {"timeout", true}, {"threads", true}, {"format", true},
+        {"discovery-timeout", true}, {"profile", false}},
+      args);
+    if (args.topics.empty() && args.params.count("regex") == 0) {
       print_help_and_exit(argv[0]);
     }
-    args.params["topic"] = argv[2];
   } else if (argv[1] == "publish"s) {
     args.cmd = Command::TopicPublish;
     if (argc < 5) {
@@ -58,25 +122,110 @@ Arguments parse_arguments(int argc, char ** argv)
     args.params["topic"] = argv[2];
     args.params["type"] = argv[3];
     args.params["msg"] = argv[4];
+    parse_options(
+      argc, argv, 5,
+      {{"rate", true}, {"count", true}, {"duration", true}, {"burst", true},
+        {"sequence-field", true}, {"stamp-field", true}},
+      args);
+  } else if (argv[1] == "latency"s) {
+    args.cmd = Command::TopicLatency;
+    if (argc < 3) {
+      print_help_and_exit(argv[0]);
+    }
+    args.params["topic"] = argv[2];
+    parse_options(
+      argc, argv, 3,
+      {{"stamp-field", true}, {"count", true}, {"timeout", true}, {"discovery-timeout", true}},
+      args);
+    if (args.params.count("stamp-field") == 0) {
+      std::cout << "Missing option '--stamp-field'\n";
+      print_help_and_exit(argv[0]);
+    }
+  } else if (argv[1] == "hz"s || argv[1] == "bw"s) {
+    args.cmd = argv[1] == "hz"s ? Command::TopicHz : Command::TopicBandwidth;
+    const int first_option = parse_topics(argc, argv, 2, args);
+    parse_options(
+      argc, argv, first_option,
+      {{"window", true}, {"timeout", true}, {"discovery-timeout", true}}, args);
+    if (args.topics.empty()) {
+      print_help_and_exit(argv[0]);
+    }
   } else if (argv[1] == "call"s) {
     args.cmd = Command::ServiceCall;
-    if (argc < 4) {
+    if (argc < 5) {
       print_help_and_exit(argv[0]);
     }
     args.params["service"] = argv[2];
-    args.params["req"] = argv[3];
+    args.params["type"] = argv[3];
+    args.params["req"] = argv[4];
+    parse_options(argc, argv, 5, {{"rate", true}, {"count", true}, {"timeout", true}}, args);
   } else if (argv[1] == "host"s) {
     args.cmd = Command::ServiceHost;
-    if (argc < 4) {
+    if (argc < 5) {
       print_help_and_exit(argv[0]);
     }
     args.params["service"] = argv[2];
-    args.params["resp"] = argv[3];
+    args.params["type"] = argv[3];
+    args.params["resp"] = argv[4];
+    parse_options(argc, argv, 5, {{"count", true}, {"timeout", true}}, args);
+  } else if (argv[1] == "bench"s) {
+    args.cmd = Command::Bench;
+    if (argc < 3) {
+      print_help_and_exit(argv[0]);
+    }
+    args.params["type"] = argv[2];
+    int first_option = 3;
+    if (argc > 3 && std::string(argv[3]).rfind("--", 0) != 0) {
+      args.params["msg"] = argv[3];
+      first_option = 4;
+    }
+    parse_options(argc, argv, first_option, {{"duration", true}, {"profile", false}}, args);
   } else if (argv[1] == "discover"s) {
     args.cmd = Command::Discover;
+    parse_options(argc, argv, 2, {{"discovery-timeout", true}}, args);
   } else {
     print_help_and_exit(argv[0]);
   }
 
   return args;
 }
+
+size_t get_count_param(const Arguments & args, const std::string & name, size_t default_value)
+{
+  const auto param = args.params.find(name);
+  if (param == args.params.end()) {
+    return default_value;
+  }
+  size_t parsed_length = 0;
+  unsigned long long value = 0;  // NOLINT(runtime/int)
+  try {
+    value = std::stoull(param->second, &parsed_length);
+  } catch (const std::logic_error &) {
+    parsed_length = 0;
+  }
+  if (param->second.empty() || parsed_length != param->second.size() ||
+    param->second[0] == '-')
+  {
+    throw std::runtime_error("invalid value for --" + name + ": " + param->second);
+  }
+  return static_cast<size_t>(value);
+}
+
+double get_seconds_param(const Arguments & args, const std::string & name, double default_value)
+{
+  const auto param = args.params.find(name);
+  if (param == args.params.end()) {
+    return default_value;
+  }
+  size_t parsed_length = 0;
+  double value = 0.0;
+  try {
+    value = std::stod(param->second, &parsed_length);
+  } catch (const std::logic_error &) {
+    parsed_length = 0;
+  }
+  if (param->second.empty() || parsed_length != param->second.size() || !(value >= 0.0)) {
+    throw std::runtime_error("invalid value for --" + name + ": " + param->second);
+  }
+  return value;
+}
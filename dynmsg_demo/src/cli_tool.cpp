@@ -12,111 +12,925 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <unistd.h>
-
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <regex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "dynmsg/dynamic_message.hpp"
 #include "dynmsg/message_reading.hpp"
 #include "dynmsg/msg_parser.hpp"
+#include "dynmsg/profiling.hpp"
+#include "dynmsg_demo/allocation_counter.hpp"
 #include "dynmsg_demo/cli.hpp"
+#include "dynmsg_demo/conversion_benchmark.hpp"
+#include "dynmsg_demo/echo_pipeline.hpp"
+#include "dynmsg_demo/latency_histogram.hpp"
+#include "dynmsg_demo/message_fields.hpp"
+#include "dynmsg_demo/topic_statistics.hpp"
+#include "dynmsg_demo/type_registry.hpp"
 #include "dynmsg_demo/typesupport_utils.hpp"
 
+#include "rcl/client.h"
 #include "rcl/context.h"
 #include "rcl/error_handling.h"
 #include "rcl/graph.h"
+#include "rcl/guard_condition.h"
 #include "rcl/init_options.h"
 #include "rcl/node_options.h"
 #include "rcl/node.h"
 #include "rcl/rcl.h"
+#include "rcl/service.h"
 #include "rcl/subscription.h"
 #include "rcl/types.h"
+#include "rcl/wait.h"
 #include "rcl_action/graph.h"
 
 #include "rcutils/logging_macros.h"
+#include "rmw/serialized_message.h"
+
+// Time to wait for discovery to find the topics a command needs, in seconds
+constexpr double DEFAULT_DISCOVERY_TIMEOUT = 5.0;
+// Time without changes after which the ROS graph information is considered complete, in seconds
+constexpr double GRAPH_QUIET_PERIOD = 0.2;
+
+// Number of serialized message buffers used when converting messages on worker threads
+constexpr size_t ECHO_BUFFER_COUNT = 256;
+
+struct EchoOptions
+{
+  // Number of messages to echo, or 0 for no limit
+  size_t count;
+  // Time to echo messages for in seconds, or 0 for no limit
+  double timeout;
+  // Number of worker threads to convert messages on, or 0 to convert them on the receiving thread
+  size_t threads;
+  OutputFormat format;
+  // Whether to tag each message with its topic
+  bool tag_topics;
+  // Whether to profile the conversions, and print the cost of each field when echoing stops
+  bool profile;
+};
 
-class NotImplemented : public std::logic_error
+// Get the allocations of the calling thread counted by the dynmsg_demo_allocation_counter library,
+// for the profiler; the echo command converts messages on several threads at once
+dynmsg::profiling::Allocations count_allocations_for_profiler()
+{
+  const AllocationCounts counts = get_thread_allocation_counts();
+  return dynmsg::profiling::Allocations{counts.allocations, counts.bytes};
+}
+
+// Start attributing the time and allocations of the conversions to the fields of the messages
+void start_profiling()
+{
+  dynmsg::profiling::ProfilingOptions options;
+  options.count_allocations = &count_allocations_for_profiler;
+  dynmsg::profiling::start(options);
+}
+
+// Stop profiling, and print the costs of the fields, the most expensive first
+void print_profile(std::ostream & out)
+{
+  dynmsg::profiling::stop();
+  out << "\nConversion costs by field, per message:\n";
+  dynmsg::profiling::write_report(out, dynmsg::profiling::get_report());
+}
+
+// Calls a function when it goes out of scope, unless it is dismissed first, e.g. to release
+// resources when a command throws
+class ScopeExit
 {
 public:
-  NotImplemented()
-  : std::logic_error("Not implemented") {}
+  explicit ScopeExit(std::function<void()> function)
+  : function_(std::move(function))
+  {}
+
+  ~ScopeExit()
+  {
+    if (function_) {
+      function_();
+    }
+  }
+
+  ScopeExit(const ScopeExit &) = delete;
+  ScopeExit & operator=(const ScopeExit &) = delete;
+
+  // Do not call the function
+  void dismiss()
+  {
+    function_ = nullptr;
+  }
+
+private:
+  std::function<void()> function_;
+};
+
+// Set when the process receives SIGINT while an InterruptGuardCondition exists
+std::atomic<bool> interrupted(false);
+
+void handle_interrupt(int signal)
+{
+  interrupted.store(true);
+  std::signal(signal, SIG_DFL);
+}
+
+// A guard condition which is triggered when the process is interrupted with SIGINT (Ctrl-C), so
+// that a command waiting on it can stop and report rather than the process being killed. A second
+// SIGINT kills the process as usual.
+//
+// Triggering a guard condition is not async-signal-safe, so the signal handler only sets a flag,
+// and a thread which checks the flag periodically triggers the guard condition. The previous
+// handler of SIGINT is restored on destruction.
+class InterruptGuardCondition
+{
+public:
+  explicit InterruptGuardCondition(rcl_context_t * context)
+  : guard_condition_(rcl_get_zero_initialized_guard_condition()),
+    stopping_(false)
+  {
+    auto ret = rcl_guard_condition_init(
+      &guard_condition_, context, rcl_guard_condition_get_default_options());
+    if (ret != RCL_RET_OK) {
+      throw std::runtime_error(rcl_get_error_string().str);
+    }
+    interrupted.store(false);
+    previous_handler_ = std::signal(SIGINT, &handle_interrupt);
+    try {
+      watcher_ = std::thread(
+        [this]() {
+          std::unique_lock<std::mutex> lock(mutex_);
+          while (!stopping_) {
+            if (interrupted.load()) {
+              if (RCL_RET_OK != rcl_trigger_guard_condition(&guard_condition_)) {
+                RCUTILS_LOG_ERROR_NAMED("cli-tool", "interrupt guard condition trigger failed");
+              }
+              return;
+            }
+            stopped_.wait_for(lock, std::chrono::milliseconds(50));
+          }
+        });
+    } catch (...) {
+      restore();
+      throw;
+    }
+  }
+
+  ~InterruptGuardCondition()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    stopped_.notify_one();
+    watcher_.join();
+    restore();
+  }
+
+  InterruptGuardCondition(const InterruptGuardCondition &) = delete;
+  InterruptGuardCondition & operator=(const InterruptGuardCondition &) = delete;
+
+  const rcl_guard_condition_t * get() const
+  {
+    return &guard_condition_;
+  }
+
+  // Whether the process was interrupted
+  bool triggered() const
+  {
+    return interrupted.load();
+  }
+
+private:
+  // Restore the previous handler of SIGINT, and finalize the guard condition
+  void restore()
+  {
+    std::signal(SIGINT, SIG_ERR == previous_handler_ ? SIG_DFL : previous_handler_);
+    if (rcl_guard_condition_fini(&guard_condition_) != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "guard condition fini failed");
+    }
+  }
+
+  rcl_guard_condition_t guard_condition_;
+  void (* previous_handler_)(int);
+  std::mutex mutex_;
+  std::condition_variable stopped_;
+  bool stopping_;
+  std::thread watcher_;
 };
 
-// Read one message from a topic, convert it to YAML, and print it to the terminal.
+// A topic and its interface type
+using TopicAndType = std::pair<std::string, InterfaceTypeName>;
+
+// Wait for each of the given topics to have a publisher, and get their interface types from the ROS
+// graph information.
+// Throws std::runtime_error if any of the topics has no publisher when the timeout elapses.
+std::vector<TopicAndType> wait_for_topics(
+  const rcl_node_t * node,
+  const std::vector<std::string> & topics,
+  double timeout)
+{
+  const std::vector<InterfaceTypeName> types = wait_for_topic_types(node, topics, timeout);
+  std::vector<TopicAndType> topics_and_types;
+  for (size_t ii = 0; ii < topics.size(); ++ii) {
+    topics_and_types.emplace_back(topics[ii], types[ii]);
+  }
+  return topics_and_types;
+}
+
+// Find the topics whose names match a regular expression, and their interface types, from the ROS
+// graph information.
+std::vector<TopicAndType> find_topics(const rcl_node_t * node, const std::regex & pattern)
+{
+  auto topics = rcl_get_zero_initialized_names_and_types();
+  auto allocator = rcl_get_default_allocator();
+  auto ret = rcl_get_topic_names_and_types(node, &allocator, false, &topics);
+  if (ret != RCL_RET_OK) {
+    throw std::runtime_error(rcl_get_error_string().str);
+  }
+  std::vector<TopicAndType> matching;
+  for (size_t ii = 0; ii < topics.names.size; ++ii) {
+    const std::string name = topics.names.data[ii];
+    if (!std::regex_match(name, pattern) || 0 == topics.types[ii].size) {
+      continue;
+    }
+    // Types are formatted as "package/msg/Type"
+    const std::string type = topics.types[ii].data[0];
+    matching.emplace_back(
+      name, InterfaceTypeName{type.substr(0, type.find('/')), type.substr(type.rfind('/') + 1)});
+  }
+  ret = rcl_names_and_types_fini(&topics);
+  if (ret != RCL_RET_OK) {
+    throw std::runtime_error(rcl_get_error_string().str);
+  }
+  return matching;
+}
+
+// Read messages from one or more topics, convert them to YAML or JSON, and print them to the
+// terminal.
+//
+// This function loads the type support and introspection information of each interface type once,
+// however many topics have that type. The type support is used to subscribe to each topic. All the
+// subscriptions are added to a single wait set, and the function blocks in rcl_wait() until
+// messages arrive, so no CPU time is used while the topics are idle. All available messages are
+// taken after each wake-up, and the introspection library is used to read the binary data of each
+// of them and convert it to a YAML representation. Messages can be tagged with their topic, to tell
+// them apart when echoing several topics.
+//
+// If worker threads are requested, messages are instead taken in their serialized form, and
+// deserialized and converted on the worker threads. The receiving thread then never waits for
+// conversion, which avoids messages being dropped by the middleware when conversion is slow.
 //
-// This function will look up the topic via the ROS graph information to find the interface type.
-// It then loads the type support and introspection information. The type support is used to
-// subscribe to the topic and wait for a message. Upon reception of a message, the introspection
-// library is used to read the binary data and convert it to a YAML representation.
+// Echoing stops after the requested number of messages have been received from all topics or the
+// timeout has elapsed, if either was given, or when the process is interrupted with SIGINT. A guard
+// condition in the wait set wakes the function up when the process is interrupted, so that it still
+// stops the worker threads, prints the profile and finalizes the subscriptions.
+//
+// If profiling is requested, the costs of converting each field are printed to stderr when echoing
+// stops, apart from the printed messages.
 int
-echo_topic(
+echo_topics(
   rcl_node_t * node,
+  const std::vector<TopicAndType> & topics,
+  const EchoOptions & options)
+{
+  struct EchoTopic
+  {
+    std::string name;
+    const MessageType & type;
+    rcl_subscription_t sub;
+  };
+  std::vector<EchoTopic> echoed;
+  echoed.reserve(topics.size());
+  const InterruptGuardCondition interrupt(node->context);
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  auto cleanup = [&]() {
+      int result = 0;
+      if (RCL_RET_OK != rcl_wait_set_fini(&wait_set)) {
+        RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait set fini failed");
+        result = 1;
+      }
+      for (auto & topic : echoed) {
+        if (RCL_RET_OK != rcl_subscription_fini(&topic.sub, node)) {
+          RCUTILS_LOG_ERROR_NAMED("cli-tool", "subscription fini failed");
+          result = 1;
+        }
+      }
+      return result;
+    };
+  // Also finalize everything when returning early or when rendering a message throws
+  ScopeExit cleanup_on_exit([&]() {cleanup();});
+
+  RCUTILS_LOG_DEBUG_NAMED("cli-tool", "Creating subscriptions");
+  for (const auto & topic : topics) {
+    std::cout << "Waiting for messages on topic '" << topic.first << "' with type " <<
+      topic.second.first << '/' << topic.second.second << '\n';
+    try {
+      echoed.push_back(
+        EchoTopic{
+        topic.first, TypeRegistry::shared().get(topic.second),
+        rcl_get_zero_initialized_subscription()});
+    } catch (const std::runtime_error & e) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "%s", e.what());
+      return 1;
+    }
+    rcl_subscription_options_t sub_options = rcl_subscription_get_default_options();
+    auto ret = rcl_subscription_init(
+      &echoed.back().sub, node, echoed.back().type.type_support, topic.first.c_str(),
+      &sub_options);
+    if (ret != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "subscription init failed");
+      echoed.pop_back();
+      return 1;
+    }
+  }
+  auto ret = rcl_wait_set_init(
+    &wait_set, echoed.size(), 1, 0, 0, 0, 0, node->context, rcl_get_default_allocator());
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait set init failed");
+    return 1;
+  }
+
+  // Either the pipeline's buffers or one message buffer per type are reused for all messages
+  std::unique_ptr<EchoPipeline> pipeline;
+  std::unordered_map<const TypeInfo *, dynmsg::c::DynamicMessage> messages;
+  if (0 != options.threads) {
+    pipeline.reset(new EchoPipeline(options.format, options.threads, ECHO_BUFFER_COUNT, std::cout));
+  }
+  const std::string no_tag;
+  if (options.profile) {
+    start_profiling();
+  }
+  // Stop the worker threads and print the profile also when rendering a message throws
+  ScopeExit profile_on_exit(
+    [&]() {
+      if (pipeline) {
+        pipeline->finish();
+      }
+      if (options.profile) {
+        print_profile(std::cerr);
+      }
+    });
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::duration<double>(options.timeout));
+  const size_t max_count = options.count;
+  size_t count = 0;
+  int result = 0;
+  while (0 == max_count || count < max_count) {
+    // Block until a message arrives, or until the deadline
+    int64_t wait_timeout = -1;
+    if (options.timeout > 0.0) {
+      wait_timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+      if (wait_timeout <= 0) {
+        break;
+      }
+    }
+    ret = rcl_wait_set_clear(&wait_set);
+    for (size_t ii = 0; ret == RCL_RET_OK && ii < echoed.size(); ++ii) {
+      ret = rcl_wait_set_add_subscription(&wait_set, &echoed[ii].sub, nullptr);
+    }
+    if (ret == RCL_RET_OK) {
+      ret = rcl_wait_set_add_guard_condition(&wait_set, interrupt.get(), nullptr);
+    }
+    if (ret != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to prepare wait set");
+      result = 1;
+      break;
+    }
+    ret = rcl_wait(&wait_set, wait_timeout);
+    if (ret == RCL_RET_TIMEOUT) {
+      continue;
+    }
+    if (ret != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait failed");
+      result = 1;
+      break;
+    }
+    if (interrupt.triggered()) {
+      break;
+    }
+
+    // Drain all the messages that are available on the topics that are ready
+    for (size_t ii = 0; ii < echoed.size() && 0 == result; ++ii) {
+      if (nullptr == wait_set.subscriptions[ii]) {
+        continue;
+      }
+      const EchoTopic & topic = echoed[ii];
+      const std::string & tag = options.tag_topics ? topic.name : no_tag;
+      auto message = messages.end();
+      if (!pipeline) {
+        message = messages.find(topic.type.type_info);
+        if (message == messages.end()) {
+          message = messages.emplace(
+            topic.type.type_info, dynmsg::c::DynamicMessage(topic.type.type_info)).first;
+        }
+      }
+      while (0 == max_count || count < max_count) {
+        if (pipeline) {
+          ret = rcl_take_serialized_message(&topic.sub, pipeline->next_buffer(), nullptr, nullptr);
+        } else {
+          ret = rcl_take(&topic.sub, message->second.data(), nullptr, nullptr);
+        }
+        if (ret == RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+          break;
+        }
+        if (ret != RCL_RET_OK) {
+          RCUTILS_LOG_ERROR_NAMED("cli-tool", "take failed");
+          result = 1;
+          break;
+        }
+        RCUTILS_LOG_DEBUG_NAMED("cli-tool", "Received data");
+        ++count;
+        if (pipeline) {
+          pipeline->commit(topic.type, tag);
+        } else {
+          std::cout << render_message(message->second.get(), options.format, tag) <<
+            message_separator(options.format);
+        }
+      }
+    }
+    if (!pipeline) {
+      std::cout << std::flush;
+    }
+  }
+  if (pipeline) {
+    pipeline->finish();
+    if (0 != pipeline->dropped()) {
+      RCUTILS_LOG_WARN_NAMED(
+        "cli-tool", "dropped %zu messages because conversion could not keep up",
+        pipeline->dropped());
+    }
+  }
+  if (0 == result && 0 != max_count && count < max_count && !interrupt.triggered()) {
+    RCUTILS_LOG_ERROR_NAMED(
+      "cli-tool", "timed out after receiving %zu of %zu messages", count, max_count);
+    result = 1;
+  }
+  if (options.profile) {
+    print_profile(std::cerr);
+  }
+  profile_on_exit.dismiss();
+  cleanup_on_exit.dismiss();
+  return cleanup() || result;
+}
+
+
+// Format a number of bytes for printing, with a decimal unit prefix
+std::string format_bytes(double bytes)
+{
+  static const char * const units[] = {"B", "KB", "MB", "GB"};
+  size_t unit = 0;
+  while (bytes >= 1000.0 && unit < 3) {
+    bytes /= 1000.0;
+    ++unit;
+  }
+  std::ostringstream formatted;
+  formatted << std::fixed << std::setprecision(2) << bytes << ' ' << units[unit];
+  return formatted.str();
+}
+
+// Print the rate or the bandwidth of a topic
+void print_topic_statistics(
   const std::string & topic,
-  const InterfaceTypeName & interface_type)
+  const TopicStatistics & stats,
+  bool bandwidth)
 {
-  std::cout << "Waiting for message on topic '" << topic << "' with type " <<
-    interface_type.first << '/' << interface_type.second << '\n';
+  const WindowSummary summary = stats.summarize();
+  std::ostringstream output;
+  output << std::fixed;
+  if (bandwidth) {
+    output << topic << ": " << format_bytes(summary.bytes_per_second) << "/s from " <<
+      summary.count << " messages\n" <<
+      "\tMessage size mean: " << format_bytes(summary.mean_size) <<
+      " min: " << format_bytes(summary.min_size) <<
+      " max: " << format_bytes(summary.max_size) << '\n';
+  } else {
+    output << topic << ": average rate: " << std::setprecision(3) << summary.rate << '\n' <<
+      std::setprecision(6) << "\tmin: " << summary.min_interval << "s max: " <<
+      summary.max_interval << "s std dev: " << summary.stddev_interval << "s window: " <<
+      summary.count << '\n';
+  }
+  std::cout << output.str();
+}
 
-  RosMessage message;
-  if (DYNMSG_RET_OK != dynmsg::c::ros_message_init(interface_type, &message)) {
-    RCUTILS_LOG_ERROR_NAMED("cli-tool", "Message init failed");
+// Measure the rate or the bandwidth of one or more topics, and print it every second.
+//
+// The interface type of each topic must be given, and only its type support is loaded. Messages
+// are taken in their serialized form and never deserialized, so that topics with high rates can be
+// measured with little overhead. All the topics are subscribed to in the same wait set.
+//
+// The statistics are computed over the last window messages of each topic, so the memory used
+// does not grow over time. Measuring stops once timeout seconds have elapsed, if timeout is
+// greater than 0. Otherwise it continues until the process is interrupted.
+int monitor_topics(
+  rcl_node_t * node,
+  const std::vector<TopicAndType> & topics,
+  bool bandwidth,
+  size_t window,
+  double timeout)
+{
+  struct MonitoredTopic
+  {
+    std::string name;
+    rcl_subscription_t sub;
+    TopicStatistics stats;
+    uint64_t reported_count;
+  };
+  std::vector<MonitoredTopic> monitored;
+  monitored.reserve(topics.size());
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  rcl_serialized_message_t buffer = rmw_get_zero_initialized_serialized_message();
+  auto allocator = rcl_get_default_allocator();
+  auto cleanup = [&]() {
+      int result = 0;
+      if (RMW_RET_OK != rmw_serialized_message_fini(&buffer)) {
+        RCUTILS_LOG_ERROR_NAMED("cli-tool", "serialized message fini failed");
+        result = 1;
+      }
+      if (RCL_RET_OK != rcl_wait_set_fini(&wait_set)) {
+        RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait set fini failed");
+        result = 1;
+      }
+      for (auto & topic : monitored) {
+        if (RCL_RET_OK != rcl_subscription_fini(&topic.sub, node)) {
+          RCUTILS_LOG_ERROR_NAMED("cli-tool", "subscription fini failed");
+          result = 1;
+        }
+      }
+      return result;
+    };
+
+  // The buffer is reused for all messages of all topics, and grows to fit the largest one
+  if (RMW_RET_OK != rmw_serialized_message_init(&buffer, 0, &allocator)) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "serialized message init failed");
+    return 1;
+  }
+  for (const auto & topic : topics) {
+    const TypeSupport * type_support = nullptr;
+    try {
+      type_support = TypeRegistry::shared().get(topic.second).type_support;
+    } catch (const std::runtime_error & e) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "%s", e.what());
+      cleanup();
+      return 1;
+    }
+    monitored.push_back(
+      MonitoredTopic{
+      topic.first, rcl_get_zero_initialized_subscription(), TopicStatistics(window), 0});
+    rcl_subscription_options_t sub_options = rcl_subscription_get_default_options();
+    auto ret = rcl_subscription_init(
+      &monitored.back().sub, node, type_support, topic.first.c_str(), &sub_options);
+    if (ret != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "subscription init failed");
+      monitored.pop_back();
+      cleanup();
+      return 1;
+    }
+  }
+  auto ret = rcl_wait_set_init(
+    &wait_set, monitored.size(), 0, 0, 0, 0, 0, node->context, rcl_get_default_allocator());
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait set init failed");
+    cleanup();
     return 1;
   }
 
-  RCUTILS_LOG_DEBUG_NAMED("cli-tool", "Creating subscription");
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  const auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(timeout));
+  auto next_report = start + std::chrono::seconds(1);
+  int result = 0;
+  while (0 == result) {
+    // Block until a message arrives, or until the next report is due
+    auto now = Clock::now();
+    auto wake_time = next_report;
+    if (timeout > 0.0) {
+      if (now >= deadline) {
+        break;
+      }
+      wake_time = std::min(wake_time, deadline);
+    }
+    const int64_t wait_timeout = std::max<int64_t>(
+      0, std::chrono::duration_cast<std::chrono::nanoseconds>(wake_time - now).count());
+    ret = rcl_wait_set_clear(&wait_set);
+    for (size_t ii = 0; ret == RCL_RET_OK && ii < monitored.size(); ++ii) {
+      ret = rcl_wait_set_add_subscription(&wait_set, &monitored[ii].sub, nullptr);
+    }
+    if (ret != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to prepare wait set");
+      result = 1;
+      break;
+    }
+    ret = rcl_wait(&wait_set, wait_timeout);
+    if (ret != RCL_RET_OK && ret != RCL_RET_TIMEOUT) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait failed");
+      result = 1;
+      break;
+    }
+
+    // Drain all the messages that are available on the topics that are ready
+    for (size_t ii = 0; ret == RCL_RET_OK && ii < monitored.size(); ++ii) {
+      if (nullptr == wait_set.subscriptions[ii]) {
+        continue;
+      }
+      while (true) {
+        const auto take_ret = rcl_take_serialized_message(
+          &monitored[ii].sub, &buffer, nullptr, nullptr);
+        if (take_ret == RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+          break;
+        }
+        if (take_ret != RCL_RET_OK) {
+          RCUTILS_LOG_ERROR_NAMED("cli-tool", "take failed");
+          result = 1;
+          break;
+        }
+        monitored[ii].stats.add(Clock::now(), buffer.buffer_length);
+      }
+    }
+
+    now = Clock::now();
+    if (now >= next_report) {
+      for (auto & topic : monitored) {
+        if (topic.stats.total_count() == topic.reported_count) {
+          std::cout << topic.name << ": no new messages\n";
+        } else {
+          print_topic_statistics(topic.name, topic.stats, bandwidth);
+          topic.reported_count = topic.stats.total_count();
+        }
+      }
+      std::cout << std::flush;
+      next_report += std::chrono::seconds(1);
+      if (next_report < now) {
+        next_report = now + std::chrono::seconds(1);
+      }
+    }
+  }
+  return cleanup() || result;
+}
+
+// Get the current time for time stamps in messages, in nanoseconds since the epoch.
+// This is the system time, like the default ROS time, which all processes on a host share.
+int64_t stamp_now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Print a summary of the latencies recorded in a histogram, in microseconds
+void print_latency_summary(const LatencyHistogram & histogram)
+{
+  std::ostringstream output;
+  output << std::fixed << std::setprecision(1) << histogram.count() << " messages, latency p50 " <<
+    histogram.percentile(50.0) / 1000.0 << " us, p99 " << histogram.percentile(99.0) / 1000.0 <<
+    " us, p99.9 " << histogram.percentile(99.9) / 1000.0 << " us, max " <<
+    histogram.max() / 1000.0 << " us\n";
+  std::cout << output.str() << std::flush;
+}
+
+// Measure the latency of the messages on a topic, from the time stamps set by their publisher.
+//
+// The time stamp of each message is read from the given field using the introspection information,
+// so any message type with a time stamp, or a 64-bit integer holding one in nanoseconds, can be
+// used. publish_to_topic() sets such time stamps just before publishing each message. The latency
+// is the time at which the message was taken minus its time stamp, which is only meaningful when
+// the publisher is on the same host.
+//
+// A summary of the latencies is printed every second, and the distribution of all the latencies is
+// printed at the end. Measuring stops after the requested number of messages have been received or
+// the timeout has elapsed, if either was given. Otherwise it continues until the process is
+// interrupted.
+int measure_latency(
+  rcl_node_t * node,
+  const std::string & topic,
+  const InterfaceTypeName & interface_type,
+  const std::string & stamp_path,
+  size_t max_count,
+  double timeout)
+{
+  std::cout << "Measuring latency on topic '" << topic << "' with type " <<
+    interface_type.first << '/' << interface_type.second << '\n';
+
+  const MessageType & type = TypeRegistry::shared().get(interface_type);
+  dynmsg::c::DynamicMessage message(type.type_info);
+  const StampField stamp_field = find_stamp_field(message.get(), stamp_path);
+
   rcl_subscription_t sub = rcl_get_zero_initialized_subscription();
   rcl_subscription_options_t sub_options = rcl_subscription_get_default_options();
-  const auto * type_support = get_type_support(interface_type);
-  if (type_support == nullptr) {
+  auto ret = rcl_subscription_init(&sub, node, type.type_support, topic.c_str(), &sub_options);
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "subscription init failed");
     return 1;
   }
-  auto ret = rcl_subscription_init(&sub, node, type_support, topic.c_str(), &sub_options);
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(
+    &wait_set, 1, 0, 0, 0, 0, 0, node->context, rcl_get_default_allocator());
   if (ret != RCL_RET_OK) {
-    RCUTILS_LOG_ERROR_NAMED("cli-tool", "subscription init failed");
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait set init failed");
+    rcl_subscription_fini(&sub, node);
     return 1;
   }
 
-  while (true) {
-    size_t count{0};
-    ret = rmw_subscription_count_matched_publishers(rcl_subscription_get_rmw_handle(&sub), &count);
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  const auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(timeout));
+  auto next_report = start + std::chrono::seconds(1);
+  LatencyHistogram period_latencies;
+  LatencyHistogram all_latencies;
+  size_t negative_count = 0;
+  int result = 0;
+  while (0 == max_count || all_latencies.count() + period_latencies.count() < max_count) {
+    // Block until a message arrives, or until the next report is due
+    auto now = Clock::now();
+    auto wake_time = next_report;
+    if (timeout > 0.0) {
+      if (now >= deadline) {
+        break;
+      }
+      wake_time = std::min(wake_time, deadline);
+    }
+    const int64_t wait_timeout = std::max<int64_t>(
+      0, std::chrono::duration_cast<std::chrono::nanoseconds>(wake_time - now).count());
+    ret = rcl_wait_set_clear(&wait_set);
+    if (ret == RCL_RET_OK) {
+      ret = rcl_wait_set_add_subscription(&wait_set, &sub, nullptr);
+    }
     if (ret != RCL_RET_OK) {
-      RCUTILS_LOG_ERROR_NAMED("cli-tool", "publisher count failed");
-      return 1;
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to prepare wait set");
+      result = 1;
+      break;
     }
-    RCUTILS_LOG_DEBUG_NAMED("cli-tool", "There are %ld matched publishers", count);
-    if (count > 0) {
+    ret = rcl_wait(&wait_set, wait_timeout);
+    if (ret != RCL_RET_OK && ret != RCL_RET_TIMEOUT) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait failed");
+      result = 1;
       break;
     }
-    sleep(0.25);
-  }
 
-  bool taken = false;
-  while (!taken) {
-    taken = false;
-    ret = rmw_take(rcl_subscription_get_rmw_handle(&sub), message.data, &taken, nullptr);
-    if (ret != RCL_RET_OK) {
-      RCUTILS_LOG_ERROR_NAMED("cli-tool", "take failed");
-      return 1;
+    // Drain all the messages that are available
+    while (ret == RCL_RET_OK &&
+      (0 == max_count || all_latencies.count() + period_latencies.count() < max_count))
+    {
+      const auto take_ret = rcl_take(&sub, message.data(), nullptr, nullptr);
+      const int64_t received = stamp_now();
+      if (take_ret == RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+        break;
+      }
+      if (take_ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR_NAMED("cli-tool", "take failed");
+        result = 1;
+        break;
+      }
+      // The system time may be adjusted between publishing and receiving
+      const int64_t latency = received - get_stamp_field(stamp_field);
+      if (latency < 0) {
+        ++negative_count;
+      }
+      period_latencies.record(static_cast<uint64_t>(std::max<int64_t>(0, latency)));
     }
-    if (taken) {
-      RCUTILS_LOG_DEBUG_NAMED("cli-tool", "Received data");
+    if (0 != result) {
       break;
     }
+
+    now = Clock::now();
+    if (now >= next_report) {
+      if (0 == period_latencies.count()) {
+        std::cout << "no new messages\n" << std::flush;
+      } else {
+        print_latency_summary(period_latencies);
+      }
+      all_latencies.add(period_latencies);
+      period_latencies.reset();
+      next_report += std::chrono::seconds(1);
+      if (next_report < now) {
+        next_report = now + std::chrono::seconds(1);
+      }
+    }
   }
+  all_latencies.add(period_latencies);
 
-  std::cout << dynmsg::c::message_to_yaml(message) << '\n';
+  std::cout << "Latency distribution (us):\n";
+  all_latencies.print_distribution(std::cout, 1000.0);
+  if (0 != negative_count) {
+    RCUTILS_LOG_WARN_NAMED(
+      "cli-tool", "%zu messages had time stamps in the future, which were counted as 0",
+      negative_count);
+  }
+  if (0 == result && 0 != max_count && all_latencies.count() < max_count) {
+    RCUTILS_LOG_ERROR_NAMED(
+      "cli-tool", "timed out after receiving %zu of %zu messages",
+      static_cast<size_t>(all_latencies.count()), max_count);
+    result = 1;
+  }
 
+  ret = rcl_wait_set_fini(&wait_set);
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait set fini failed");
+    result = 1;
+  }
   ret = rcl_subscription_fini(&sub, node);
   if (ret != RCL_RET_OK) {
     RCUTILS_LOG_ERROR_NAMED("cli-tool", "subscription fini failed");
-    return 1;
+    result = 1;
+  }
+  return result;
+}
+
+// Sleep until the given time.
+// Sleeping is only accurate to within tens of microseconds, so this sleeps until shortly before the
+// deadline and spins for the remaining time, which allows publishing at rates of tens of kHz.
+void wait_until(const std::chrono::steady_clock::time_point & deadline)
+{
+  constexpr auto spin_time = std::chrono::microseconds(100);
+  if (deadline - std::chrono::steady_clock::now() > spin_time) {
+    std::this_thread::sleep_until(deadline - spin_time);
+  }
+  while (std::chrono::steady_clock::now() < deadline) {
   }
-  return 0;
 }
 
+// Statistics about the messages published during one reporting period
+class PublishStats
+{
+public:
+  explicit PublishStats(const std::chrono::steady_clock::time_point & start)
+  : start_(start), count_(0), late_count_(0), lateness_sum_(0.0), lateness_square_sum_(0.0),
+    lateness_max_(0.0)
+  {}
+
+  void add_messages(size_t count)
+  {
+    count_ += count;
+  }
+
+  // Record how long after its deadline a message (or burst of messages) was published
+  void add_lateness(const std::chrono::steady_clock::duration & lateness)
+  {
+    const double lateness_us = std::chrono::duration<double, std::micro>(lateness).count();
+    ++late_count_;
+    lateness_sum_ += lateness_us;
+    lateness_square_sum_ += lateness_us * lateness_us;
+    lateness_max_ = std::max(lateness_max_, lateness_us);
+  }
+
+  // Print the statistics for the period ending now, and start a new period
+  void print_and_reset(const std::chrono::steady_clock::time_point & now)
+  {
+    const double elapsed = std::chrono::duration<double>(now - start_).count();
+    std::cout << "Published " << count_ << " messages at " << count_ / elapsed << " Hz";
+    if (0 != late_count_) {
+      const double mean = lateness_sum_ / late_count_;
+      const double variance = std::max(0.0, lateness_square_sum_ / late_count_ - mean * mean);
+      std::cout << ", lateness mean " << mean << " us, stddev " << std::sqrt(variance) <<
+        " us, max " << lateness_max_ << " us";
+    }
+    std::cout << std::endl;
+    *this = PublishStats(now);
+  }
+
+private:
+  std::chrono::steady_clock::time_point start_;
+  size_t count_;
+  size_t late_count_;
+  double lateness_sum_;
+  double lateness_square_sum_;
+  double lateness_max_;
+};
+
+struct PublishOptions
+{
+  // Number of times to publish per second, or 0 to publish as fast as possible
+  double rate;
+  // Number of messages to publish, or 0 for no limit
+  size_t count;
+  // Time to publish for in seconds, or 0 for no limit
+  double duration;
+  // Number of messages to publish back-to-back each time
+  size_t burst;
+  // Path of an integer member to set to the message's sequence number, or empty for none
+  std::string sequence_field;
+  // Path of a time stamp member to set to the time each message is published, or empty for none
+  std::string stamp_field;
+};
 
 // Write the given ROS message (in YAML representation) to the specified topic.
 //
@@ -126,49 +940,472 @@ echo_topic(
 // This function will load the type support and introspection information for the provided
 // interface type. It then converts the given YAML representation into a binary ROS message and
 // stores it in a byte buffer. The type support is used to create a publisher to the given topic
-// with the correct type, and then the ROS message is published to that topic ten times.
+// with the correct type, and then the ROS message is published to that topic repeatedly.
+//
+// The message is only converted once. If a sequence number field or a time stamp field is given,
+// it is set before each message is published, and otherwise the same message is published every
+// time. Time stamps can be used to measure latency with measure_latency().
+//
+// Messages are published at the requested rate, in bursts if requested. Each publishing deadline is
+// computed from the start time, so that the rate does not drift over time. The achieved rate and
+// how late messages were published relative to their deadlines are printed every second.
 int publish_to_topic(
   rcl_node_t * node,
   const std::string & topic,
   const InterfaceTypeName & interface_type,
-  const std::string & message_yaml)
+  const std::string & message_yaml,
+  const PublishOptions & options)
 {
   std::cout << "Publishing message on topic '" << topic << "' with type " <<
     interface_type.first << '/' << interface_type.second << '\n';
 
-  RosMessage message = dynmsg::c::yaml_to_rosmsg(interface_type, message_yaml);
+  const MessageType & type = TypeRegistry::shared().get(interface_type);
+  auto message = dynmsg::c::DynamicMessage::adopt(
+    dynmsg::c::yaml_and_typeinfo_to_rosmsg(type.type_info, message_yaml, nullptr));
+  NumericField sequence_field{0, nullptr};
+  if (!options.sequence_field.empty()) {
+    sequence_field = find_numeric_field(message.get(), options.sequence_field);
+  }
+  StampField stamp_field{NumericField{0, nullptr}, NumericField{0, nullptr}};
+  if (!options.stamp_field.empty()) {
+    stamp_field = find_stamp_field(message.get(), options.stamp_field);
+  }
 
   RCUTILS_LOG_DEBUG_NAMED("cli-tool", "Creating publisher");
   rcl_publisher_t pub = rcl_get_zero_initialized_publisher();
   rcl_publisher_options_t pub_options = rcl_publisher_get_default_options();
-  const auto * type_support = get_type_support(interface_type);
-  if (type_support == nullptr) {
-    return 1;
-  }
-  auto ret = rcl_publisher_init(&pub, node, type_support, topic.c_str(), &pub_options);
+  auto ret = rcl_publisher_init(&pub, node, type.type_support, topic.c_str(), &pub_options);
   if (ret != RCL_RET_OK) {
     RCUTILS_LOG_ERROR_NAMED("cli-tool", "subscription init failed");
     return 1;
   }
 
-  for (auto ii = 0; ii < 10; ++ii) {
-    std::cout << "Publishing\n";
-    ret = rcl_publish(&pub, message.data, nullptr);
-    if (ret != RCL_RET_OK) {
-      RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to publish message");
-      return 1;
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  const auto end = start + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(options.duration));
+  auto next_report = start + std::chrono::seconds(1);
+  PublishStats stats(start);
+  size_t published = 0;
+  int result = 0;
+  for (uint64_t tick = 0; 0 == options.count || published < options.count; ++tick) {
+    auto now = Clock::now();
+    if (options.rate > 0.0) {
+      const auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(tick / options.rate));
+      wait_until(deadline);
+      now = Clock::now();
+      stats.add_lateness(now - deadline);
+    }
+    if (options.duration > 0.0 && now >= end) {
+      break;
+    }
+
+    size_t burst_count = 0;
+    for (; burst_count < options.burst; ++burst_count) {
+      if (0 != options.count && published + burst_count == options.count) {
+        break;
+      }
+      if (nullptr != sequence_field.data) {
+        set_numeric_field(sequence_field, static_cast<int64_t>(published + burst_count));
+      }
+      if (nullptr != stamp_field.nanosec.data) {
+        set_stamp_field(stamp_field, stamp_now());
+      }
+      ret = rcl_publish(&pub, message.data(), nullptr);
+      if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to publish message");
+        result = 1;
+        break;
+      }
+    }
+    published += burst_count;
+    stats.add_messages(burst_count);
+    if (0 != result) {
+      break;
+    }
+
+    if (now >= next_report) {
+      stats.print_and_reset(now);
+      next_report += std::chrono::seconds(1);
+      if (next_report < now) {
+        next_report = now + std::chrono::seconds(1);
+      }
     }
-    sleep(1);
   }
+  const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << "Published " << published << " messages in " << elapsed << " s" << std::endl;
 
   ret = rcl_publisher_fini(&pub, node);
   if (ret != RCL_RET_OK) {
     RCUTILS_LOG_ERROR_NAMED("cli-tool", "publisher fini failed");
     return 1;
   }
-  return 0;
+  return result;
+}
+
+
+// Wait for a service server to become available.
+// Returns false if it does not become available before the timeout (if any) elapses.
+bool wait_for_server(const rcl_node_t * node, const rcl_client_t * client, double timeout)
+{
+  return wait_for_graph(
+    node, [node, client]() {
+      bool available = false;
+      if (rcl_service_server_is_available(node, client, &available) != RCL_RET_OK) {
+        throw std::runtime_error(rcl_get_error_string().str);
+      }
+      return available;
+    }, timeout);
+}
+
+struct CallOptions
+{
+  // Number of calls to start per second, or 0 to make each call once the previous one returns
+  double rate;
+  // Number of calls to make, or 0 for no limit
+  size_t count;
+  // Time to wait for the server and the responses in seconds, or 0 for no limit
+  double timeout;
+};
+
+// Call the given service with the given request (in YAML representation).
+//
+// This function requires the service type be specified, like publish_to_topic(). The request is
+// only converted once and the same request is sent for every call, and every response is taken
+// into the same message, so no memory is allocated per call beyond what the middleware needs.
+//
+// Without a rate, each call is made once the response to the previous one has been received. With
+// a rate, calls are started at that rate whether or not earlier calls have returned, to load test
+// the server. A single response is printed; when making several calls, the round trip times are
+// printed every second instead, and their distribution is printed at the end.
+int call_service(
+  rcl_node_t * node,
+  const std::string & service,
+  const InterfaceTypeName & interface_type,
+  const std::string & request_yaml,
+  const CallOptions & options)
+{
+  std::cout << "Calling service '" << service << "' with type " <<
+    interface_type.first << '/' << interface_type.second << '\n';
+
+  const ServiceType & type = TypeRegistry::shared().get_service(interface_type);
+  auto request = dynmsg::c::DynamicMessage::adopt(
+    dynmsg::c::yaml_and_typeinfo_to_rosmsg(type.request_type_info, request_yaml, nullptr));
+  dynmsg::c::DynamicMessage response(type.response_type_info);
+
+  rcl_client_t client = rcl_get_zero_initialized_client();
+  rcl_client_options_t client_options = rcl_client_get_default_options();
+  auto ret = rcl_client_init(&client, node, type.type_support, service.c_str(), &client_options);
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "client init failed");
+    return 1;
+  }
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(
+    &wait_set, 0, 0, 0, 1, 0, 0, node->context, rcl_get_default_allocator());
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait set init failed");
+    rcl_client_fini(&client, node);
+    return 1;
+  }
+
+  using Clock = std::chrono::steady_clock;
+  int result = 0;
+  size_t sent = 0;
+  size_t received = 0;
+  LatencyHistogram period_latencies;
+  LatencyHistogram all_latencies;
+  // Start times of the calls that have not returned yet, by sequence number
+  std::unordered_map<int64_t, Clock::time_point> pending;
+  if (!wait_for_server(node, &client, options.timeout)) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "service '%s' is not available", service.c_str());
+    result = 1;
+  }
+  const auto start = Clock::now();
+  const auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(options.timeout));
+  auto next_call = start;
+  auto next_report = start + std::chrono::seconds(1);
+  while (0 == result && (0 == options.count || received < options.count)) {
+    auto now = Clock::now();
+    const bool calls_left = 0 == options.count || sent < options.count;
+    if (calls_left &&
+      (options.rate > 0.0 ? now >= next_call : pending.empty()))
+    {
+      int64_t sequence_number = 0;
+      ret = rcl_send_request(&client, request.data(), &sequence_number);
+      if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to send request");
+        result = 1;
+        break;
+      }
+      pending.emplace(sequence_number, now);
+      ++sent;
+      if (options.rate > 0.0) {
+        // Each call's start time is computed from the start time, so that the rate does not drift
+        next_call = start + std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(sent / options.rate));
+      }
+      continue;
+    }
+
+    // Block until a response arrives, the next call is due, or the next report is due
+    auto wake_time = next_report;
+    if (calls_left && options.rate > 0.0) {
+      wake_time = std::min(wake_time, next_call);
+    }
+    if (options.timeout > 0.0) {
+      if (now >= deadline) {
+        RCUTILS_LOG_ERROR_NAMED(
+          "cli-tool", "timed out with %zu calls not returned", pending.size());
+        result = 1;
+        break;
+      }
+      wake_time = std::min(wake_time, deadline);
+    }
+    const int64_t wait_timeout = std::max<int64_t>(
+      0, std::chrono::duration_cast<std::chrono::nanoseconds>(wake_time - now).count());
+    ret = rcl_wait_set_clear(&wait_set);
+    if (ret == RCL_RET_OK) {
+      ret = rcl_wait_set_add_client(&wait_set, &client, nullptr);
+    }
+    if (ret != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to prepare wait set");
+      result = 1;
+      break;
+    }
+    ret = rcl_wait(&wait_set, wait_timeout);
+    if (ret != RCL_RET_OK && ret != RCL_RET_TIMEOUT) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait failed");
+      result = 1;
+      break;
+    }
+
+    // Take all the responses that are available
+    while (ret == RCL_RET_OK) {
+      rmw_request_id_t request_id;
+      const auto take_ret = rcl_take_response(&client, &request_id, response.data());
+      now = Clock::now();
+      if (take_ret == RCL_RET_CLIENT_TAKE_FAILED) {
+        break;
+      }
+      if (take_ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to take response");
+        result = 1;
+        break;
+      }
+      const auto call = pending.find(request_id.sequence_number);
+      if (call == pending.end()) {
+        // A response to a request from a previous client with the same name
+        continue;
+      }
+      period_latencies.record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - call->second).count());
+      pending.erase(call);
+      ++received;
+      if (1 == options.count) {
+        std::cout << render_message(response.get(), OutputFormat::Yaml) << std::endl;
+      }
+    }
+
+    if (now >= next_report && 1 != options.count) {
+      if (0 == period_latencies.count()) {
+        std::cout << "no new responses\n" << std::flush;
+      } else {
+        print_latency_summary(period_latencies);
+      }
+      all_latencies.add(period_latencies);
+      period_latencies.reset();
+      next_report += std::chrono::seconds(1);
+      if (next_report < now) {
+        next_report = now + std::chrono::seconds(1);
+      }
+    }
+  }
+  all_latencies.add(period_latencies);
+
+  if (1 != options.count && 0 != all_latencies.count()) {
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "Received " << received << " responses in " << elapsed <<
+      " s\nRound trip time distribution (us):\n";
+    all_latencies.print_distribution(std::cout, 1000.0);
+  }
+
+  ret = rcl_wait_set_fini(&wait_set);
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait set fini failed");
+    result = 1;
+  }
+  ret = rcl_client_fini(&client, node);
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "client fini failed");
+    result = 1;
+  }
+  return result;
 }
 
+// Provide the given service, responding to every request with the given response (in YAML
+// representation).
+//
+// This function requires the service type be specified, because the service does not exist until
+// it is provided. The response is only converted once, and every request is taken into the same
+// message, so requests can be served at a high rate. All the requests that are waiting are served
+// each time the service becomes ready, and the number of requests served is printed every second.
+//
+// Serving stops after the requested number of requests have been served or the timeout has
+// elapsed, if either was given. Otherwise it continues until the process is interrupted.
+int host_service(
+  rcl_node_t * node,
+  const std::string & service_name,
+  const InterfaceTypeName & interface_type,
+  const std::string & response_yaml,
+  size_t max_count,
+  double timeout)
+{
+  std::cout << "Providing service '" << service_name << "' with type " <<
+    interface_type.first << '/' << interface_type.second << '\n';
+
+  const ServiceType & type = TypeRegistry::shared().get_service(interface_type);
+  dynmsg::c::DynamicMessage request(type.request_type_info);
+  auto response = dynmsg::c::DynamicMessage::adopt(
+    dynmsg::c::yaml_and_typeinfo_to_rosmsg(type.response_type_info, response_yaml, nullptr));
+
+  rcl_service_t service = rcl_get_zero_initialized_service();
+  rcl_service_options_t service_options = rcl_service_get_default_options();
+  auto ret = rcl_service_init(
+    &service, node, type.type_support, service_name.c_str(), &service_options);
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "service init failed");
+    return 1;
+  }
+  rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+  ret = rcl_wait_set_init(
+    &wait_set, 0, 0, 0, 0, 1, 0, node->context, rcl_get_default_allocator());
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait set init failed");
+    rcl_service_fini(&service, node);
+    return 1;
+  }
+
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  const auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(timeout));
+  auto next_report = start + std::chrono::seconds(1);
+  auto period_start = start;
+  size_t served = 0;
+  size_t period_served = 0;
+  int result = 0;
+  while (0 == max_count || served < max_count) {
+    // Block until a request arrives, or until the next report is due
+    auto now = Clock::now();
+    auto wake_time = next_report;
+    if (timeout > 0.0) {
+      if (now >= deadline) {
+        break;
+      }
+      wake_time = std::min(wake_time, deadline);
+    }
+    const int64_t wait_timeout = std::max<int64_t>(
+      0, std::chrono::duration_cast<std::chrono::nanoseconds>(wake_time - now).count());
+    ret = rcl_wait_set_clear(&wait_set);
+    if (ret == RCL_RET_OK) {
+      ret = rcl_wait_set_add_service(&wait_set, &service, nullptr);
+    }
+    if (ret != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to prepare wait set");
+      result = 1;
+      break;
+    }
+    ret = rcl_wait(&wait_set, wait_timeout);
+    if (ret != RCL_RET_OK && ret != RCL_RET_TIMEOUT) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait failed");
+      result = 1;
+      break;
+    }
+
+    // Serve all the requests that are waiting
+    while (ret == RCL_RET_OK && (0 == max_count || served < max_count)) {
+      rmw_request_id_t request_id;
+      const auto take_ret = rcl_take_request(&service, &request_id, request.data());
+      if (take_ret == RCL_RET_SERVICE_TAKE_FAILED) {
+        break;
+      }
+      if (take_ret != RCL_RET_OK ||
+        rcl_send_response(&service, &request_id, response.data()) != RCL_RET_OK)
+      {
+        RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to serve request");
+        result = 1;
+        break;
+      }
+      ++served;
+      ++period_served;
+    }
+    if (0 != result) {
+      break;
+    }
+
+    now = Clock::now();
+    if (now >= next_report) {
+      const double elapsed = std::chrono::duration<double>(now - period_start).count();
+      std::cout << "Served " << period_served << " requests at " << period_served / elapsed <<
+        " Hz" << std::endl;
+      period_served = 0;
+      period_start = now;
+      next_report += std::chrono::seconds(1);
+      if (next_report < now) {
+        next_report = now + std::chrono::seconds(1);
+      }
+    }
+  }
+  const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  std::cout << "Served " << served << " requests in " << elapsed << " s" << std::endl;
+
+  ret = rcl_wait_set_fini(&wait_set);
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "wait set fini failed");
+    result = 1;
+  }
+  ret = rcl_service_fini(&service, node);
+  if (ret != RCL_RET_OK) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "service fini failed");
+    result = 1;
+  }
+  return result;
+}
+
+
+// Measure how fast messages of the given type are converted by dynmsg on this machine, and print
+// the results.
+//
+// The message is given in YAML representation, or has the default values of its type if it is
+// empty. No middleware communication is involved, so no other ROS processes are needed.
+//
+// If profiling is requested, the conversions are profiled while they are benchmarked, and the costs
+// of each field are printed after the results; the results then include the profiling overhead.
+int benchmark_conversions(
+  const InterfaceTypeName & interface_type,
+  const std::string & message_yaml,
+  double duration,
+  bool profile)
+{
+  std::cout << "Benchmarking conversions of type " << interface_type.first << '/' <<
+    interface_type.second << '\n';
+  BenchmarkOptions options;
+  options.duration = duration;
+  options.count_allocations = &get_allocation_counts;
+  if (profile) {
+    start_profiling();
+  }
+  print_benchmark_results(
+    run_conversion_benchmarks(
+      TypeRegistry::shared().get(interface_type), message_yaml, options), std::cout);
+  if (profile) {
+    print_profile(std::cout);
+  }
+  return 0;
+}
 
 // Print all known nodes from the ROS graph to the terminal.
 //
@@ -293,6 +1530,20 @@ main(int argc, char ** argv)
 {
   auto args = parse_arguments(argc, argv);
 
+  if (args.cmd == Command::Bench) {
+    // Benchmarking conversions does not need ROS to be initialized
+    try {
+      return benchmark_conversions(
+        get_topic_type_from_string_type(args.params["type"]),
+        args.params.count("msg") ? args.params["msg"] : std::string(),
+        get_seconds_param(args, "duration", 1.0),
+        0 != args.params.count("profile"));
+    } catch (const std::runtime_error & e) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", e.what());
+      return 1;
+    }
+  }
+
   // Initialise the options for ROS
   rcl_init_options_t options = rcl_get_zero_initialized_init_options();
   rcl_ret_t ret = rcl_init_options_init(&options, rcl_get_default_allocator());
@@ -326,19 +1577,38 @@ main(int argc, char ** argv)
 
   try {
     InterfaceTypeName interface_type;
+    const double discovery_timeout =
+      get_seconds_param(args, "discovery-timeout", DEFAULT_DISCOVERY_TIMEOUT);
     switch (args.cmd) {
-      case Command::TopicEcho:
-        // Need to sleep for abit for discovery to populate the ROS graph information so we can get
-        // the topic type automatically
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+      case Command::TopicEcho: {
+          // Wait for discovery to populate the ROS graph information so we can get the topic
+          // types automatically
+          std::vector<TopicAndType> topics = wait_for_topics(&node, args.topics, discovery_timeout);
+          if (args.params.count("regex")) {
+            const std::regex pattern(args.params["regex"]);
+            std::vector<TopicAndType> matching;
+            wait_for_graph(
+              &node, [&]() {
+                matching = find_topics(&node, pattern);
+                return !matching.empty();
+              }, discovery_timeout);
+            if (matching.empty()) {
+              std::cout << "No topics match '" << args.params["regex"] << "'\n";
+              return 1;
+            }
+            topics.insert(topics.end(), matching.begin(), matching.end());
+          }
 
-        interface_type = get_topic_type(&node, args.params["topic"]);
-        if (interface_type.first == "" || interface_type.second == "") {
-          std::cout << "Unknown topic type '" << interface_type.first << '/' <<
-            interface_type.second << "'\n";
-          return 1;
+          EchoOptions options;
+          options.count = get_count_param(args, "count", 0);
+          options.timeout = get_seconds_param(args, "timeout", 0.0);
+          options.threads = get_count_param(args, "threads", 0);
+          options.format = parse_output_format(
+            args.params.count("format") ? args.params["format"] : "yaml");
+          options.tag_topics = topics.size() > 1 || args.params.count("regex");
+          options.profile = 0 != args.params.count("profile");
+          return echo_topics(&node, topics, options);
         }
-        return echo_topic(&node, args.params["topic"], interface_type);
       case Command::TopicPublish:
         interface_type = get_topic_type_from_string_type(args.params["type"]);
         if (interface_type.first == "" || interface_type.second == "") {
@@ -346,19 +1616,70 @@ main(int argc, char ** argv)
             interface_type.second << "'\n";
           return 1;
         }
-        return publish_to_topic(&node, args.params["topic"], interface_type, args.params["msg"]);
-      case Command::ServiceCall:
-        throw NotImplemented();
+        {
+          PublishOptions options;
+          options.rate = get_seconds_param(args, "rate", 1.0);
+          // Without a count or a duration, publish ten messages
+          const size_t default_count = args.params.count("duration") ? 0 : 10;
+          options.count = get_count_param(args, "count", default_count);
+          options.duration = get_seconds_param(args, "duration", 0.0);
+          options.burst = get_count_param(args, "burst", 1);
+          if (0 == options.burst) {
+            throw std::runtime_error("invalid value for --burst: 0");
+          }
+          if (args.params.count("sequence-field")) {
+            options.sequence_field = args.params["sequence-field"];
+          }
+          if (args.params.count("stamp-field")) {
+            options.stamp_field = args.params["stamp-field"];
+          }
+          return publish_to_topic(
+            &node, args.params["topic"], interface_type, args.params["msg"], options);
+        }
+      case Command::TopicHz:
+      case Command::TopicBandwidth: {
+          // Wait for discovery to populate the ROS graph information so we can get the topic
+          // types automatically
+          const std::vector<TopicAndType> topics =
+            wait_for_topics(&node, args.topics, discovery_timeout);
+          return monitor_topics(
+            &node, topics, args.cmd == Command::TopicBandwidth,
+            get_count_param(args, "window", 10000), get_seconds_param(args, "timeout", 0.0));
+        }
+      case Command::TopicLatency: {
+          // Wait for discovery to populate the ROS graph information so we can get the topic
+          // type automatically
+          const std::vector<TopicAndType> topics =
+            wait_for_topics(&node, {args.params["topic"]}, discovery_timeout);
+          return measure_latency(
+            &node, topics[0].first, topics[0].second, args.params["stamp-field"],
+            get_count_param(args, "count", 0), get_seconds_param(args, "timeout", 0.0));
+        }
+      case Command::ServiceCall: {
+          CallOptions options;
+          options.rate = get_seconds_param(args, "rate", 0.0);
+          options.count = get_count_param(args, "count", 1);
+          options.timeout = get_seconds_param(args, "timeout", 0.0);
+          return call_service(
+            &node, args.params["service"], get_topic_type_from_string_type(args.params["type"]),
+            args.params["req"], options);
+        }
       case Command::ServiceHost:
-        throw NotImplemented();
+        return host_service(
+          &node, args.params["service"], get_topic_type_from_string_type(args.params["type"]),
+          args.params["resp"], get_count_param(args, "count", 0),
+          get_seconds_param(args, "timeout", 0.0));
       case Command::Discover: {
-          // Need to sleep for abit for discovery to populate the ROS graph information
-          std::this_thread::sleep_for(std::chrono::seconds(1));
+          // Give discovery time to populate the ROS graph information. There is nothing specific
+          // to wait for, so wait until the graph stops changing, for at most a second by default.
+          wait_for_graph_to_settle(
+            &node, GRAPH_QUIET_PERIOD, get_seconds_param(args, "discovery-timeout", 1.0));
           return print_nodes(&node) ||
                  print_topics(&node) ||
                  print_services(&node) ||
                  print_actions(&node);
         }
+      case Command::Bench:
       case Command::Unknown:
         std::cout << "Unknown command\n";
         return 1;
@@ -0,0 +1,245 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "dynmsg/config.hpp"
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/message_conversion.hpp"
+#include "dynmsg/message_reading.hpp"
+#include "dynmsg/msg_parser.hpp"
+#include "dynmsg/yaml_utils.hpp"
+#include "dynmsg_demo/conversion_benchmark.hpp"
+#include "dynmsg_demo/echo_pipeline.hpp"
+
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Run an operation repeatedly for about the requested time.
+// The operation is run in batches that grow until each takes about a millisecond, so that reading
+// the clock does not add to the time of fast operations.
+template<typename Operation>
+BenchmarkResult run_benchmark(
+  const std::string & name,
+  size_t bytes_per_message,
+  const BenchmarkOptions & options,
+  Operation operation)
+{
+  // Warm up, e.g. so that buffers reused by the operation have grown to their final size
+  operation();
+
+  double allocations_per_message = -1.0;
+  if (nullptr != options.count_allocations) {
+    // The operations are deterministic, so a single run gives the allocations of every run
+    const AllocationCounts before = options.count_allocations();
+    operation();
+    allocations_per_message =
+      static_cast<double>(options.count_allocations().allocations - before.allocations);
+  }
+
+  const auto duration = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(options.duration));
+  size_t batch_size = 1;
+  size_t iterations = 0;
+  Clock::duration elapsed(0);
+  while (elapsed < duration) {
+    const auto start = Clock::now();
+    for (size_t ii = 0; ii < batch_size; ++ii) {
+      operation();
+    }
+    const auto batch_time = Clock::now() - start;
+    elapsed += batch_time;
+    iterations += batch_size;
+    if (batch_time < std::chrono::milliseconds(1)) {
+      batch_size *= 2;
+    }
+  }
+
+  const double ns_per_message =
+    std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+  return BenchmarkResult{
+    name, iterations, ns_per_message, bytes_per_message, allocations_per_message};
+}
+
+}  // namespace
+
+std::vector<BenchmarkResult> run_conversion_benchmarks(
+  const MessageType & type,
+  const std::string & message_yaml,
+  const BenchmarkOptions & options)
+{
+  std::vector<BenchmarkResult> results;
+  const TypeInfo * type_info = type.type_info;
+
+  dynmsg::c::DynamicMessage message(type_info);
+  if (!message_yaml.empty()) {
+    const RosMessage parsed =
+      dynmsg::c::yaml_and_typeinfo_to_rosmsg(type_info, message_yaml, nullptr);
+    if (nullptr == parsed.data) {
+      throw std::runtime_error("failed to create a message from the given YAML");
+    }
+    message = dynmsg::c::DynamicMessage::adopt(parsed);
+  }
+  const std::string yaml_text = dynmsg::yaml_to_string(dynmsg::c::message_to_yaml(message.get()));
+  // The YAML produced from a message can only be parsed back when it holds values only
+#ifdef DYNMSG_VALUE_ONLY
+  const std::string & parsed_yaml = message_yaml.empty() ? yaml_text : message_yaml;
+#else
+  const std::string & parsed_yaml = message_yaml;
+#endif
+
+  // Layout of C messages
+  results.push_back(
+    run_benchmark(
+      "c.init+destroy", 0, options, [type_info]() {
+        dynmsg::c::DynamicMessage initialized(type_info);
+      }));
+  results.push_back(
+    run_benchmark(
+      "c.to_yaml", yaml_text.size(), options, [&message]() {
+        dynmsg::c::message_to_yaml(message.get());
+      }));
+  results.push_back(
+    run_benchmark(
+      "c.to_yaml_text", yaml_text.size(), options, [&message]() {
+        dynmsg::yaml_to_string(dynmsg::c::message_to_yaml(message.get()));
+      }));
+  const std::string json_text = render_message(message.get(), OutputFormat::Json);
+  results.push_back(
+    run_benchmark(
+      "c.to_json_text", json_text.size(), options, [&message]() {
+        render_message(message.get(), OutputFormat::Json);
+      }));
+  if (!parsed_yaml.empty()) {
+    // Parsing always creates a new message, which has to be destroyed
+    results.push_back(
+      run_benchmark(
+        "c.from_yaml+destroy", parsed_yaml.size(), options, [type_info, &parsed_yaml]() {
+          dynmsg::c::DynamicMessage::adopt(
+            dynmsg::c::yaml_and_typeinfo_to_rosmsg(type_info, parsed_yaml, nullptr));
+        }));
+  }
+
+  // Serialization to CDR uses the type support of the middleware, but does not communicate
+  rcl_serialized_message_t buffer = rmw_get_zero_initialized_serialized_message();
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  if (RMW_RET_OK != rmw_serialized_message_init(&buffer, 0, &allocator)) {
+    throw std::runtime_error("failed to allocate serialized message buffer");
+  }
+  try {
+    // The timed runs do not check the results, so check them once before
+    if (RMW_RET_OK != rmw_serialize(message.data(), type.type_support, &buffer)) {
+      throw std::runtime_error("failed to serialize message");
+    }
+    results.push_back(
+      run_benchmark(
+        "c.serialize_cdr", buffer.buffer_length, options, [&message, &type, &buffer]() {
+          rmw_serialize(message.data(), type.type_support, &buffer);
+        }));
+    dynmsg::c::DynamicMessage deserialized(type_info);
+    if (RMW_RET_OK != rmw_deserialize(&buffer, type.type_support, deserialized.data())) {
+      throw std::runtime_error("failed to deserialize message");
+    }
+    results.push_back(
+      run_benchmark(
+        "c.deserialize_cdr", buffer.buffer_length, options, [&deserialized, &type, &buffer]() {
+          rmw_deserialize(&buffer, type.type_support, deserialized.data());
+        }));
+  } catch (...) {
+    rmw_serialized_message_fini(&buffer);
+    throw;
+  }
+  if (RMW_RET_OK != rmw_serialized_message_fini(&buffer)) {
+    throw std::runtime_error("failed to free serialized message buffer");
+  }
+
+  // Layout of C++ messages, if the type has C++ introspection information
+  const TypeInfo_Cpp * type_info_cpp = dynmsg::cpp::get_type_info(type.name);
+  if (nullptr == type_info_cpp) {
+    return results;
+  }
+  const dynmsg::MessageConverter converter(type_info, type_info_cpp);
+  dynmsg::cpp::DynamicMessage message_cpp(type_info_cpp);
+  RosMessage_Cpp message_cpp_view = message_cpp.get();
+  converter.c_to_cpp(message.get(), message_cpp_view);
+
+  results.push_back(
+    run_benchmark(
+      "cpp.init+destroy", 0, options, [type_info_cpp]() {
+        dynmsg::cpp::DynamicMessage initialized(type_info_cpp);
+      }));
+  results.push_back(
+    run_benchmark(
+      "cpp.to_yaml", yaml_text.size(), options, [&message_cpp]() {
+        dynmsg::cpp::message_to_yaml(message_cpp.get());
+      }));
+  if (!parsed_yaml.empty()) {
+    // Parsing into an existing message appends to its sequences, so each run needs a new message
+    results.push_back(
+      run_benchmark(
+        "cpp.from_yaml+destroy", parsed_yaml.size(), options, [type_info_cpp, &parsed_yaml]() {
+          dynmsg::cpp::DynamicMessage parsed(type_info_cpp);
+          dynmsg::cpp::yaml_and_typeinfo_to_rosmsg(type_info_cpp, parsed_yaml, parsed.data());
+        }));
+  }
+  dynmsg::c::DynamicMessage converted(type_info);
+  RosMessage converted_view = converted.get();
+  results.push_back(
+    run_benchmark(
+      "c.to_cpp", 0, options, [&converter, &message, &message_cpp_view]() {
+        converter.c_to_cpp(message.get(), message_cpp_view);
+      }));
+  results.push_back(
+    run_benchmark(
+      "cpp.to_c", 0, options, [&converter, &message_cpp, &converted_view]() {
+        converter.cpp_to_c(message_cpp.get(), converted_view);
+      }));
+  return results;
+}
+
+void print_benchmark_results(const std::vector<BenchmarkResult> & results, std::ostream & out)
+{
+  std::ostringstream table;
+  table << std::left << std::setw(22) << "benchmark" << std::right << std::setw(12) <<
+    "iterations" << std::setw(12) << "ns/msg" << std::setw(12) << "MB/s" << std::setw(12) <<
+    "allocs/msg" << '\n';
+  table << std::fixed;
+  for (const auto & result : results) {
+    table << std::left << std::setw(22) << result.name << std::right << std::setw(12) <<
+      result.iterations << std::setw(12) << std::setprecision(1) << result.ns_per_message;
+    // A byte per nanosecond is a thousand megabytes per second
+    if (0 != result.bytes_per_message) {
+      table << std::setw(12) << result.bytes_per_message / result.ns_per_message * 1000.0;
+    } else {
+      table << std::setw(12) << '-';
+    }
+    if (result.allocations_per_message >= 0.0) {
+      table << std::setw(12) << result.allocations_per_message;
+    } else {
+      table << std::setw(12) << '-';
+    }
+    table << '\n';
+  }
+  out << table.str();
+}
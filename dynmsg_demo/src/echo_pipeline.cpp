@@ -0,0 +1,411 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cctype>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "dynmsg/config.hpp"
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/message_reading.hpp"
+#include "dynmsg/yaml_utils.hpp"
+#include "dynmsg_demo/echo_pipeline.hpp"
+
+#include "rcutils/logging_macros.h"
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rosidl_typesupport_introspection_c/field_types.h"
+
+OutputFormat parse_output_format(const std::string & name)
+{
+  if (name == "yaml") {
+    return OutputFormat::Yaml;
+  } else if (name == "json") {
+    return OutputFormat::Json;
+  }
+  throw std::runtime_error("unknown output format: " + name);
+}
+
+namespace
+{
+
+void write_json_string(const std::string & value, std::string & json)
+{
+  static const char hex_digits[] = "0123456789abcdef";
+  json += '"';
+  for (const char c : value) {
+    switch (c) {
+      case '"':
+        json += "\\\"";
+        break;
+      case '\\':
+        json += "\\\\";
+        break;
+      case '\n':
+        json += "\\n";
+        break;
+      case '\t':
+        json += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          json += "\\u00";
+          json += hex_digits[(c >> 4) & 0xf];
+          json += hex_digits[c & 0xf];
+        } else {
+          json += c;
+        }
+    }
+  }
+  json += '"';
+}
+
+// Check if a number written by yaml-cpp is also a JSON number, i.e. if it is finite
+bool is_json_number(const std::string & value)
+{
+  const size_t digit = (!value.empty() && '-' == value[0]) ? 1u : 0u;
+  return digit < value.size() && std::isdigit(static_cast<unsigned char>(value[digit]));
+}
+
+// Write a scalar of the YAML representation of a message as a JSON value, typed after the member
+// it comes from
+void write_json_scalar(
+  const MemberInfo & member_info,
+  const std::string & value,
+  std::string & json)
+{
+  switch (member_info.type_id_) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_STRING:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WSTRING:
+      write_json_string(value, json);
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+      json += value;
+      break;
+    default:
+      // Numbers, including chars and octets; JSON has no NaN or infinity, which are written as
+      // strings in their YAML form (e.g. ".nan")
+      if (is_json_number(value)) {
+        json += value;
+      } else {
+        write_json_string(value, json);
+      }
+      break;
+  }
+}
+
+void write_json_message(const TypeInfo & type_info, const YAML::Node & yaml, std::string & json);
+
+// Write one value of a member, i.e. the member itself or one of its elements if it is an array
+void write_json_element(const MemberInfo & member_info, const YAML::Node & yaml, std::string & json)
+{
+  if (rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE == member_info.type_id_) {
+    write_json_message(
+      *reinterpret_cast<const TypeInfo *>(member_info.members_->data), yaml, json);
+  } else {
+    write_json_scalar(member_info, yaml.Scalar(), json);
+  }
+}
+
+void write_json_value(const MemberInfo & member_info, const YAML::Node & yaml, std::string & json)
+{
+  if (!member_info.is_array_) {
+    write_json_element(member_info, yaml, json);
+    return;
+  }
+  // Empty sequences are null nodes in the YAML representation
+  json += '[';
+  if (yaml.IsSequence()) {
+    bool first = true;
+    for (const auto & item : yaml) {
+      if (!first) {
+        json += ", ";
+      }
+      first = false;
+      write_json_element(member_info, item, json);
+    }
+  }
+  json += ']';
+}
+
+// Write the YAML representation of a message as JSON. The scalars of the YAML representation carry
+// no type, so the members of the message type tell which ones are numbers, booleans, or strings.
+void write_json_message(const TypeInfo & type_info, const YAML::Node & yaml, std::string & json)
+{
+  json += '{';
+  for (uint32_t ii = 0; ii < type_info.member_count_; ++ii) {
+    const MemberInfo & member_info = type_info.members_[ii];
+    if (ii > 0u) {
+      json += ", ";
+    }
+    write_json_string(member_info.name_, json);
+    json += ": ";
+    const YAML::Node member = yaml[member_info.name_];
+#ifdef DYNMSG_VALUE_ONLY
+    write_json_value(member_info, member, json);
+#else
+    // Each member is a map of its type, default value, and value
+    json += '{';
+    bool first = true;
+    for (const auto & item : member) {
+      if (!first) {
+        json += ", ";
+      }
+      first = false;
+      const std::string & key = item.first.Scalar();
+      write_json_string(key, json);
+      json += ": ";
+      if ("value" == key) {
+        write_json_value(member_info, item.second, json);
+      } else {
+        write_json_string(item.second.Scalar(), json);
+      }
+    }
+    json += '}';
+#endif
+  }
+  json += '}';
+}
+
+void fini_buffer(rcl_serialized_message_t * buffer)
+{
+  if (RMW_RET_OK != rmw_serialized_message_fini(buffer)) {
+    RCUTILS_LOG_ERROR_NAMED("cli-tool", "serialized message fini failed");
+  }
+}
+
+}  // namespace
+
+std::string render_message(
+  const RosMessage & message,
+  OutputFormat format,
+  const std::string & topic)
+{
+  const YAML::Node yaml = dynmsg::c::message_to_yaml(message);
+  if (format == OutputFormat::Json) {
+    std::string json;
+    if (!topic.empty()) {
+      json += "{\"topic\": ";
+      write_json_string(topic, json);
+      json += ", \"message\": ";
+    }
+    write_json_message(*message.type_info, yaml, json);
+    if (!topic.empty()) {
+      json += '}';
+    }
+    return json;
+  }
+  if (!topic.empty()) {
+    // A comment keeps each document valid YAML
+    return "# " + topic + '\n' + dynmsg::yaml_to_string(yaml);
+  }
+  return dynmsg::yaml_to_string(yaml);
+}
+
+const char * message_separator(OutputFormat format)
+{
+  // JSON messages are printed one per line
+  return format == OutputFormat::Json ? "\n" : "\n---\n";
+}
+
+EchoPipeline::EchoPipeline(
+  OutputFormat format,
+  size_t threads,
+  size_t capacity,
+  std::ostream & out)
+: format_(format),
+  out_(out),
+  slots_(new Slot[capacity]),
+  capacity_(capacity),
+  overflow_buffer_(rmw_get_zero_initialized_serialized_message()),
+  overflowing_(false),
+  dropped_(0),
+  write_index_(0),
+  committed_(0),
+  claim_index_(0),
+  print_index_(0),
+  stopping_(false)
+{
+  if (0u == threads || 0u == capacity) {
+    throw std::runtime_error("the echo pipeline needs at least one thread and one buffer");
+  }
+  // The buffers start empty, and grow to fit the messages taken into them
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  for (size_t ii = 0; ii < capacity_; ++ii) {
+    slots_[ii].buffer = rmw_get_zero_initialized_serialized_message();
+    slots_[ii].type = nullptr;
+    slots_[ii].topic = nullptr;
+    slots_[ii].state.store(SlotFree);
+    if (RMW_RET_OK != rmw_serialized_message_init(&slots_[ii].buffer, 0, &allocator)) {
+      for (size_t jj = 0; jj < ii; ++jj) {
+        fini_buffer(&slots_[jj].buffer);
+      }
+      throw std::runtime_error("failed to allocate serialized message buffers");
+    }
+  }
+  if (RMW_RET_OK != rmw_serialized_message_init(&overflow_buffer_, 0, &allocator)) {
+    for (size_t ii = 0; ii < capacity_; ++ii) {
+      fini_buffer(&slots_[ii].buffer);
+    }
+    throw std::runtime_error("failed to allocate serialized message buffers");
+  }
+
+  try {
+    workers_.reserve(threads);
+    for (size_t ii = 0; ii < threads; ++ii) {
+      workers_.emplace_back(&EchoPipeline::run_worker, this);
+    }
+  } catch (...) {
+    // The destructor is not called, so stop and join the threads which were started, which have no
+    // messages to convert yet, and release the buffers
+    finish();
+    for (size_t ii = 0; ii < capacity_; ++ii) {
+      fini_buffer(&slots_[ii].buffer);
+    }
+    fini_buffer(&overflow_buffer_);
+    throw;
+  }
+}
+
+EchoPipeline::~EchoPipeline()
+{
+  finish();
+  for (size_t ii = 0; ii < capacity_; ++ii) {
+    fini_buffer(&slots_[ii].buffer);
+  }
+  fini_buffer(&overflow_buffer_);
+}
+
+rcl_serialized_message_t * EchoPipeline::next_buffer()
+{
+  Slot & slot = slots_[write_index_ % capacity_];
+  // The slot is free once its previous message has been printed
+  overflowing_ = slot.state.load(std::memory_order_acquire) != SlotFree;
+  if (overflowing_) {
+    return &overflow_buffer_;
+  }
+  return &slot.buffer;
+}
+
+void EchoPipeline::commit(const MessageType & type, const std::string & topic)
+{
+  if (overflowing_) {
+    ++dropped_;
+    overflowing_ = false;
+    return;
+  }
+  Slot & slot = slots_[write_index_ % capacity_];
+  slot.type = &type;
+  slot.topic = &topic;
+  slot.state.store(SlotFilled, std::memory_order_release);
+  ++write_index_;
+  committed_.store(write_index_, std::memory_order_release);
+  {
+    // Synchronize with a worker thread that is about to go to sleep, so the wake-up is not lost
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+  }
+  work_available_.notify_one();
+}
+
+void EchoPipeline::finish()
+{
+  if (workers_.empty()) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(print_mutex_);
+    printed_.wait(lock, [this]() {return print_index_ == write_index_;});
+  }
+  {
+    std::lock_guard<std::mutex> lock(idle_mutex_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (auto & worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void EchoPipeline::run_worker()
+{
+  // Each worker thread deserializes into its own message of each type, which is reused for every
+  // message of that type
+  std::unordered_map<const TypeInfo *, dynmsg::c::DynamicMessage> messages;
+  while (true) {
+    size_t index = claim_index_.load();
+    if (index >= committed_.load(std::memory_order_acquire)) {
+      std::unique_lock<std::mutex> lock(idle_mutex_);
+      work_available_.wait(
+        lock, [this]() {
+          return stopping_ || claim_index_.load() < committed_.load(std::memory_order_acquire);
+        });
+      if (stopping_) {
+        // finish() only stops the workers once every message has been printed
+        return;
+      }
+      continue;
+    }
+    if (!claim_index_.compare_exchange_weak(index, index + 1)) {
+      continue;
+    }
+
+    Slot & slot = slots_[index % capacity_];
+    try {
+      auto message = messages.find(slot.type->type_info);
+      if (message == messages.end()) {
+        message = messages.emplace(
+          slot.type->type_info, dynmsg::c::DynamicMessage(slot.type->type_info)).first;
+      }
+      if (RMW_RET_OK !=
+        rmw_deserialize(&slot.buffer, slot.type->type_support, message->second.data()))
+      {
+        RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to deserialize message");
+      } else {
+        slot.text = render_message(message->second.get(), format_, *slot.topic);
+      }
+    } catch (const std::exception & e) {
+      RCUTILS_LOG_ERROR_NAMED("cli-tool", "failed to convert message: %s", e.what());
+    }
+    slot.state.store(SlotRendered, std::memory_order_release);
+    print_rendered();
+  }
+}
+
+void EchoPipeline::print_rendered()
+{
+  // Whichever worker thread renders the next message to print also prints any messages following
+  // it that were rendered before it
+  std::lock_guard<std::mutex> lock(print_mutex_);
+  const size_t first = print_index_;
+  while (true) {
+    Slot & slot = slots_[print_index_ % capacity_];
+    if (slot.state.load(std::memory_order_acquire) != SlotRendered) {
+      break;
+    }
+    if (!slot.text.empty()) {
+      out_ << slot.text << message_separator(format_);
+      // Keep the string's capacity for the next message in this slot
+      slot.text.clear();
+    }
+    slot.state.store(SlotFree, std::memory_order_release);
+    ++print_index_;
+  }
+  if (print_index_ != first) {
+    out_ << std::flush;
+    printed_.notify_all();
+  }
+}
@@ -0,0 +1,157 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+#include "dynmsg_demo/latency_histogram.hpp"
+
+namespace
+{
+
+// Each power of two from 2^SUB_BUCKET_BITS to 2^63 has its own group of buckets, and the values
+// below 2^SUB_BUCKET_BITS have one bucket each
+constexpr size_t BUCKET_GROUP_COUNT = 64 - LatencyHistogram::SUB_BUCKET_BITS + 1;
+
+// Position of the highest bit set, for values greater than 0
+size_t highest_bit(uint64_t value)
+{
+  size_t bit = 0;
+  while (value >>= 1) {
+    ++bit;
+  }
+  return bit;
+}
+
+}  // namespace
+
+constexpr size_t LatencyHistogram::SUB_BUCKET_BITS;
+constexpr size_t LatencyHistogram::SUB_BUCKET_COUNT;
+
+LatencyHistogram::LatencyHistogram()
+: counts_(BUCKET_GROUP_COUNT * SUB_BUCKET_COUNT, 0u),
+  count_(0),
+  min_(std::numeric_limits<uint64_t>::max()),
+  max_(0),
+  sum_(0.0)
+{}
+
+size_t LatencyHistogram::bucket_index(uint64_t value)
+{
+  if (value < SUB_BUCKET_COUNT) {
+    return static_cast<size_t>(value);
+  }
+  // Keep the SUB_BUCKET_BITS bits below the highest bit set
+  const size_t shift = highest_bit(value) - SUB_BUCKET_BITS;
+  const size_t group = shift + 1;
+  return group * SUB_BUCKET_COUNT + static_cast<size_t>((value >> shift) - SUB_BUCKET_COUNT);
+}
+
+uint64_t LatencyHistogram::bucket_highest_value(size_t index)
+{
+  if (index < SUB_BUCKET_COUNT) {
+    return index;
+  }
+  const size_t shift = index / SUB_BUCKET_COUNT - 1;
+  const uint64_t lowest = static_cast<uint64_t>(SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT) <<
+    shift;
+  return lowest + ((uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+  ++counts_[bucket_index(value)];
+  ++count_;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  sum_ += static_cast<double>(value);
+}
+
+void LatencyHistogram::add(const LatencyHistogram & other)
+{
+  for (size_t ii = 0; ii < counts_.size(); ++ii) {
+    counts_[ii] += other.counts_[ii];
+  }
+  count_ += other.count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  sum_ += other.sum_;
+}
+
+void LatencyHistogram::reset()
+{
+  std::fill(counts_.begin(), counts_.end(), 0u);
+  count_ = 0;
+  min_ = std::numeric_limits<uint64_t>::max();
+  max_ = 0;
+  sum_ = 0.0;
+}
+
+uint64_t LatencyHistogram::min() const
+{
+  return 0 == count_ ? 0 : min_;
+}
+
+double LatencyHistogram::mean() const
+{
+  return 0 == count_ ? 0.0 : sum_ / static_cast<double>(count_);
+}
+
+uint64_t LatencyHistogram::percentile(double percentage) const
+{
+  if (0 == count_) {
+    return 0;
+  }
+  if (percentage <= 0.0) {
+    return min_;
+  }
+  const double exact_rank = std::ceil(std::min(percentage, 100.0) / 100.0 * count_);
+  const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(exact_rank));
+  uint64_t seen = 0;
+  for (size_t ii = 0; ii < counts_.size(); ++ii) {
+    seen += counts_[ii];
+    if (seen >= rank) {
+      return std::min(bucket_highest_value(ii), max_);
+    }
+  }
+  return max_;
+}
+
+void LatencyHistogram::print_distribution(std::ostream & out, double unit_scale) const
+{
+  static const double percentages[] = {
+    0.0, 50.0, 75.0, 90.0, 95.0, 99.0, 99.9, 99.99, 99.999, 100.0};
+  const auto flags = out.flags();
+  const auto precision = out.precision();
+  out << std::fixed << std::setw(12) << "Value" << std::setw(14) << "Percentile" <<
+    std::setw(12) << "TotalCount" << '\n';
+  for (const double percentage : percentages) {
+    const uint64_t value = percentile(percentage);
+    // Count the values in all the buckets up to the one holding this value
+    uint64_t total = 0;
+    const size_t last_bucket = bucket_index(value);
+    for (size_t ii = 0; ii <= last_bucket; ++ii) {
+      total += counts_[ii];
+    }
+    out << std::setw(12) << std::setprecision(3) << value / unit_scale <<
+      std::setw(14) << std::setprecision(6) << percentage / 100.0 <<
+      std::setw(12) << total << '\n';
+  }
+  out << "#[Mean = " << std::setprecision(3) << mean() / unit_scale <<
+    ", Max = " << max_ / unit_scale << ", Count = " << count_ << "]\n";
+  out.flags(flags);
+  out.precision(precision);
+}
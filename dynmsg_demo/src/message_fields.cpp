@@ -0,0 +1,219 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "dynmsg/member_utils.hpp"
+#include "dynmsg_demo/message_fields.hpp"
+
+#include "rosidl_typesupport_introspection_c/field_types.h"
+
+namespace
+{
+
+template<typename T>
+void store(uint8_t * data, int64_t value)
+{
+  const T typed_value = static_cast<T>(value);
+  std::memcpy(data, &typed_value, sizeof(T));
+}
+
+template<typename T>
+int64_t load(const uint8_t * data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return static_cast<int64_t>(value);
+}
+
+// Find a member of a message by its path, and get a pointer to its data
+const MemberInfo & find_member(
+  const RosMessage & message,
+  const std::string & path,
+  uint8_t *& data)
+{
+  const TypeInfo * type_info = message.type_info;
+  data = message.data;
+  size_t name_start = 0;
+  while (true) {
+    const size_t name_end = path.find('.', name_start);
+    const std::string name = path.substr(name_start, name_end - name_start);
+    const MemberInfo * member = nullptr;
+    for (uint32_t ii = 0; ii < type_info->member_count_; ++ii) {
+      if (name == type_info->members_[ii].name_) {
+        member = &type_info->members_[ii];
+        break;
+      }
+    }
+    if (nullptr == member) {
+      throw std::runtime_error("no member '" + name + "' in field path '" + path + "'");
+    }
+    if (member->is_array_) {
+      throw std::runtime_error(
+        "member '" + name + "' in field path '" + path + "' is an array");
+    }
+    data += member->offset_;
+
+    if (std::string::npos == name_end) {
+      return *member;
+    }
+    if (member->type_id_ != rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE) {
+      throw std::runtime_error(
+        "member '" + name + "' in field path '" + path + "' is not a message");
+    }
+    type_info = dynmsg::c::get_nested_type_info(*member);
+    name_start = name_end + 1;
+  }
+}
+
+bool is_integer_type(uint8_t type_id)
+{
+  switch (type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+NumericField find_numeric_field(const RosMessage & message, const std::string & path)
+{
+  uint8_t * data = nullptr;
+  const MemberInfo & member = find_member(message, path, data);
+  if (!dynmsg::is_primitive_type(member.type_id_)) {
+    throw std::runtime_error("field '" + path + "' is not numeric");
+  }
+  return NumericField{member.type_id_, data};
+}
+
+void set_numeric_field(const NumericField & field, int64_t value)
+{
+  switch (field.type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+      store<float>(field.data, value);
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+      store<double>(field.data, value);
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      store<long double>(field.data, value);
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+      store<bool>(field.data, value);
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_CHAR:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT8:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT8:
+      store<uint8_t>(field.data, value);
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WCHAR:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+      store<uint16_t>(field.data, value);
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+      store<uint32_t>(field.data, value);
+      break;
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      store<uint64_t>(field.data, value);
+      break;
+  }
+}
+
+int64_t get_numeric_field(const NumericField & field)
+{
+  switch (field.type_id) {
+    case rosidl_typesupport_introspection_c__ROS_TYPE_FLOAT:
+      return load<float>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_DOUBLE:
+      return load<double>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_LONG_DOUBLE:
+      return load<long double>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_BOOLEAN:
+      return load<bool>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_CHAR:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_OCTET:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT8:
+      return load<uint8_t>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT8:
+      return load<int8_t>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_WCHAR:
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT16:
+      return load<uint16_t>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT16:
+      return load<int16_t>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT32:
+      return load<uint32_t>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT32:
+      return load<int32_t>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_UINT64:
+      return load<uint64_t>(field.data);
+    case rosidl_typesupport_introspection_c__ROS_TYPE_INT64:
+      return load<int64_t>(field.data);
+  }
+  return 0;
+}
+
+StampField find_stamp_field(const RosMessage & message, const std::string & path)
+{
+  uint8_t * data = nullptr;
+  const MemberInfo & member = find_member(message, path, data);
+  // A number of nanoseconds since the epoch needs 64 bits
+  if (member.type_id_ == rosidl_typesupport_introspection_c__ROS_TYPE_INT64 ||
+    member.type_id_ == rosidl_typesupport_introspection_c__ROS_TYPE_UINT64)
+  {
+    return StampField{NumericField{0, nullptr}, NumericField{member.type_id_, data}};
+  }
+  if (member.type_id_ == rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE) {
+    // Any message with integer sec and nanosec members, like builtin_interfaces/Time
+    const RosMessage stamp{dynmsg::c::get_nested_type_info(member), data};
+    try {
+      StampField field{find_numeric_field(stamp, "sec"), find_numeric_field(stamp, "nanosec")};
+      if (is_integer_type(field.sec.type_id) && is_integer_type(field.nanosec.type_id)) {
+        return field;
+      }
+    } catch (const std::runtime_error &) {
+    }
+  }
+  throw std::runtime_error(
+    "field '" + path + "' is neither a time stamp nor a 64-bit integer number of nanoseconds");
+}
+
+void set_stamp_field(const StampField & field, int64_t nanoseconds)
+{
+  if (nullptr == field.sec.data) {
+    set_numeric_field(field.nanosec, nanoseconds);
+    return;
+  }
+  set_numeric_field(field.sec, nanoseconds / 1000000000);
+  set_numeric_field(field.nanosec, nanoseconds % 1000000000);
+}
+
+int64_t get_stamp_field(const StampField & field)
+{
+  if (nullptr == field.sec.data) {
+    return get_numeric_field(field.nanosec);
+  }
+  return get_numeric_field(field.sec) * 1000000000 + get_numeric_field(field.nanosec);
+}
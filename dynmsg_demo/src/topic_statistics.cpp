@@ -0,0 +1,88 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "dynmsg_demo/topic_statistics.hpp"
+
+TopicStatistics::TopicStatistics(size_t window)
+: window_(window), next_(0), total_count_(0)
+{
+  if (window < 2) {
+    throw std::runtime_error("the statistics window must hold at least 2 messages");
+  }
+  samples_.reserve(window);
+}
+
+void TopicStatistics::add(const Clock::time_point & arrival, size_t size)
+{
+  if (samples_.size() < window_) {
+    samples_.push_back(Sample{arrival, size});
+  } else {
+    samples_[next_] = Sample{arrival, size};
+  }
+  next_ = (next_ + 1) % window_;
+  ++total_count_;
+}
+
+WindowSummary TopicStatistics::summarize() const
+{
+  WindowSummary summary{};
+  summary.count = samples_.size();
+  if (samples_.empty()) {
+    return summary;
+  }
+
+  // Once the ring is full, the oldest sample is the next one to be overwritten
+  const size_t oldest = samples_.size() < window_ ? 0 : next_;
+  size_t total_size = 0;
+  summary.min_size = std::numeric_limits<size_t>::max();
+  for (const auto & sample : samples_) {
+    total_size += sample.size;
+    summary.min_size = std::min(summary.min_size, sample.size);
+    summary.max_size = std::max(summary.max_size, sample.size);
+  }
+  summary.mean_size = static_cast<double>(total_size) / summary.count;
+  if (summary.count < 2) {
+    return summary;
+  }
+
+  // Intervals are computed in two passes, for a numerically stable standard deviation
+  const auto & first = samples_[oldest];
+  const auto & last = samples_[(oldest + summary.count - 1) % summary.count];
+  const double span = std::chrono::duration<double>(last.arrival - first.arrival).count();
+  const size_t interval_count = summary.count - 1;
+  summary.mean_interval = span / interval_count;
+  summary.min_interval = std::numeric_limits<double>::max();
+  double square_sum = 0.0;
+  for (size_t ii = 1; ii < summary.count; ++ii) {
+    const auto & previous = samples_[(oldest + ii - 1) % summary.count];
+    const auto & current = samples_[(oldest + ii) % summary.count];
+    const double interval =
+      std::chrono::duration<double>(current.arrival - previous.arrival).count();
+    summary.min_interval = std::min(summary.min_interval, interval);
+    summary.max_interval = std::max(summary.max_interval, interval);
+    square_sum += (interval - summary.mean_interval) * (interval - summary.mean_interval);
+  }
+  summary.stddev_interval = std::sqrt(square_sum / interval_count);
+  if (span > 0.0) {
+    summary.rate = interval_count / span;
+    // The first message in the window arrived at the start of the span, so its bytes are excluded
+    summary.bytes_per_second = (total_size - first.size) / span;
+  }
+  return summary;
+}
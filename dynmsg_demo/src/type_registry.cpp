@@ -0,0 +1,68 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdexcept>
+#include <string>
+
+#include "dynmsg_demo/type_registry.hpp"
+#include "dynmsg_demo/typesupport_utils.hpp"
+
+TypeRegistry & TypeRegistry::shared()
+{
+  static TypeRegistry registry;
+  return registry;
+}
+
+const MessageType & TypeRegistry::get(const InterfaceTypeName & interface_type)
+{
+  // Types are loaded with the lock held, so that each type is only loaded once
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto existing = types_.find(interface_type);
+  if (existing != types_.end()) {
+    return existing->second;
+  }
+
+  const std::string type_name = interface_type.first + '/' + interface_type.second;
+  MessageType type{interface_type, dynmsg::c::get_type_info(interface_type), nullptr};
+  if (nullptr == type.type_info) {
+    throw std::runtime_error("failed to load introspection information of " + type_name);
+  }
+  type.type_support = get_type_support(interface_type);
+  if (nullptr == type.type_support) {
+    throw std::runtime_error("failed to load type support of " + type_name);
+  }
+  return types_.emplace(interface_type, type).first->second;
+}
+
+const ServiceType & TypeRegistry::get_service(const InterfaceTypeName & interface_type)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto existing = services_.find(interface_type);
+  if (existing != services_.end()) {
+    return existing->second;
+  }
+
+  const std::string type_name = interface_type.first + '/' + interface_type.second;
+  const ServiceTypeInfo * service_info = dynmsg::c::get_service_type_info(interface_type);
+  if (nullptr == service_info) {
+    throw std::runtime_error("failed to load introspection information of " + type_name);
+  }
+  ServiceType type{
+    interface_type, service_info->request_members_, service_info->response_members_,
+    get_service_type_support(interface_type)};
+  if (nullptr == type.type_support) {
+    throw std::runtime_error("failed to load type support of " + type_name);
+  }
+  return services_.emplace(interface_type, type).first->second;
+}
@@ -14,16 +14,30 @@
 
 #include <dlfcn.h>
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "dynmsg_demo/typesupport_utils.hpp"
 
 #include "rcl/error_handling.h"
 #include "rcl/graph.h"
+#include "rcl/wait.h"
 #include "rcutils/logging_macros.h"
 
-InterfaceTypeName get_topic_type(const rcl_node_t * node, const std::string & topic)
+namespace
+{
+
+// Look up the type of a topic from the publishers of it known to the node.
+// Returns false if no publishers of the topic are known.
+bool lookup_topic_type(
+  const rcl_node_t * node,
+  const std::string & topic,
+  InterfaceTypeName & interface_type)
 {
   auto pubs = rcl_get_zero_initialized_topic_endpoint_info_array();
   auto allocator = rcl_get_default_allocator();
@@ -32,23 +46,167 @@ InterfaceTypeName get_topic_type(const rcl_node_t * node, const std::string & to
   if (ret != RCL_RET_OK) {
     throw std::runtime_error(rcl_get_error_string().str);
   }
-  if (pubs.size == 0) {
-    throw std::runtime_error("unable to determine topic type");
+  const bool found = pubs.size != 0;
+  if (found) {
+    // Get the topic type from the graph information
+    std::string topic_type(pubs.info_array->topic_type);
+    std::string pkg = topic_type.substr(0, topic_type.find('/'));
+    std::string name = topic_type.substr(topic_type.rfind('/') + 1);
+    interface_type = InterfaceTypeName{pkg, name};
   }
-  // Get the topic type from the graph information
-  std::string topic_type(pubs.info_array->topic_type);
-  std::string pkg = topic_type.substr(0, topic_type.find('/'));
-  std::string name = topic_type.substr(topic_type.rfind('/') + 1);
-  InterfaceTypeName int_type_name{pkg, name};
 
   // Clean up
   ret = rcl_topic_endpoint_info_array_fini(&pubs, &allocator);
   if (ret != RCL_RET_OK) {
     throw std::runtime_error(rcl_get_error_string().str);
   }
-  return int_type_name;
+  return found;
+}
+
+// A wait set containing only the graph guard condition of a node, which is triggered whenever the
+// node's view of the ROS graph changes
+class GraphWaitSet
+{
+public:
+  explicit GraphWaitSet(const rcl_node_t * node)
+  : guard_condition_(rcl_node_get_graph_guard_condition(node)),
+    wait_set_(rcl_get_zero_initialized_wait_set())
+  {
+    if (nullptr == guard_condition_) {
+      throw std::runtime_error(rcl_get_error_string().str);
+    }
+    auto ret = rcl_wait_set_init(
+      &wait_set_, 0, 1, 0, 0, 0, 0, node->context, rcl_get_default_allocator());
+    if (ret != RCL_RET_OK) {
+      throw std::runtime_error(rcl_get_error_string().str);
+    }
+  }
+
+  ~GraphWaitSet()
+  {
+    if (rcl_wait_set_fini(&wait_set_) != RCL_RET_OK) {
+      RCUTILS_LOG_ERROR_NAMED("dynmsg_demo", "wait set fini failed");
+    }
+  }
+
+  GraphWaitSet(const GraphWaitSet &) = delete;
+  GraphWaitSet & operator=(const GraphWaitSet &) = delete;
+
+  // Wait for the graph to change, for at most the given time in nanoseconds, or forever if it is
+  // negative. Returns false if the graph did not change before the timeout.
+  bool wait(int64_t timeout)
+  {
+    auto ret = rcl_wait_set_clear(&wait_set_);
+    if (ret == RCL_RET_OK) {
+      ret = rcl_wait_set_add_guard_condition(&wait_set_, guard_condition_, nullptr);
+    }
+    if (ret == RCL_RET_OK) {
+      ret = rcl_wait(&wait_set_, timeout);
+    }
+    if (ret == RCL_RET_TIMEOUT) {
+      return false;
+    }
+    if (ret != RCL_RET_OK) {
+      throw std::runtime_error(rcl_get_error_string().str);
+    }
+    return true;
+  }
+
+private:
+  const rcl_guard_condition_t * guard_condition_;
+  rcl_wait_set_t wait_set_;
+};
+
+using Clock = std::chrono::steady_clock;
+
+Clock::time_point get_deadline(double timeout)
+{
+  return Clock::now() + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(timeout));
+}
+
+// Get the time left until a deadline in nanoseconds, for passing to rcl_wait()
+int64_t get_time_left(const Clock::time_point & deadline)
+{
+  return std::max<int64_t>(
+    0, std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now()).count());
+}
+
+}  // namespace
+
+InterfaceTypeName get_topic_type(const rcl_node_t * node, const std::string & topic)
+{
+  InterfaceTypeName interface_type;
+  if (!lookup_topic_type(node, topic, interface_type)) {
+    throw std::runtime_error("unable to determine topic type");
+  }
+  return interface_type;
+}
+
+std::vector<InterfaceTypeName> wait_for_topic_types(
+  const rcl_node_t * node,
+  const std::vector<std::string> & topics,
+  double timeout)
+{
+  std::vector<InterfaceTypeName> types(topics.size());
+  std::vector<bool> found(topics.size(), false);
+  size_t found_count = 0;
+  const bool all_found = wait_for_graph(
+    node, [&]() {
+      for (size_t ii = 0; ii < topics.size(); ++ii) {
+        if (!found[ii] && lookup_topic_type(node, topics[ii], types[ii])) {
+          found[ii] = true;
+          ++found_count;
+        }
+      }
+      return found_count == topics.size();
+    }, timeout);
+  if (!all_found) {
+    const size_t missing = std::find(found.begin(), found.end(), false) - found.begin();
+    throw std::runtime_error(
+      "timed out waiting for a publisher of topic '" + topics[missing] + "'");
+  }
+  return types;
 }
 
+bool wait_for_graph(
+  const rcl_node_t * node,
+  const std::function<bool()> & condition,
+  double timeout)
+{
+  // Discovery may already have found what is needed
+  if (condition()) {
+    return true;
+  }
+  GraphWaitSet wait_set(node);
+  const auto deadline = get_deadline(timeout);
+  while (wait_set.wait(timeout > 0.0 ? get_time_left(deadline) : -1)) {
+    if (condition()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void wait_for_graph_to_settle(const rcl_node_t * node, double quiet_period, double timeout)
+{
+  GraphWaitSet wait_set(node);
+  const auto deadline = get_deadline(timeout);
+  const int64_t quiet_period_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::duration<double>(quiet_period)).count();
+  while (true) {
+    int64_t wait_time = quiet_period_ns;
+    if (timeout > 0.0) {
+      wait_time = std::min(wait_time, get_time_left(deadline));
+      if (0 == wait_time) {
+        return;
+      }
+    }
+    if (!wait_set.wait(wait_time)) {
+      return;
+    }
+  }
+}
 
 InterfaceTypeName get_topic_type_from_string_type(const std::string & type)
 {
@@ -59,7 +217,14 @@ InterfaceTypeName get_topic_type_from_string_type(const std::string & type)
   return InterfaceTypeName(type.substr(0, split_at), type.substr(split_at + 1));
 }
 
-const TypeSupport * get_type_support(const InterfaceTypeName & interface_type)
+namespace
+{
+
+// Load a function from the type support library of the package containing an interface type.
+// Returns nullptr if the library or the function cannot be loaded.
+void * load_type_support_function(
+  const InterfaceTypeName & interface_type,
+  const std::string & function_name)
 {
   // Load the type support library for the package containing the requested type
   std::string ts_lib_name;
@@ -75,15 +240,24 @@ const TypeSupport * get_type_support(const InterfaceTypeName & interface_type)
   }
   // Load the function that, when called, will give us the type support for the interface type we
   // are interested in
-  std::string ts_func_name;
-  ts_func_name = "rosidl_typesupport_c__get_message_type_support_handle__" + interface_type.first +
-    "__msg__" + interface_type.second;
-  RCUTILS_LOG_DEBUG_NAMED("dynmsg_demo", "Loading type support function %s", ts_func_name.c_str());
+  RCUTILS_LOG_DEBUG_NAMED("dynmsg_demo", "Loading type support function %s", function_name.c_str());
+  void * function = dlsym(type_support_lib, function_name.c_str());
+  if (function == nullptr) {
+    RCUTILS_LOG_ERROR_NAMED("dynmsg_demo", "failed to load type support function: %s", dlerror());
+  }
+  return function;
+}
 
+}  // namespace
+
+const TypeSupport * get_type_support(const InterfaceTypeName & interface_type)
+{
   get_message_ts_func type_support_handle_func =
-    reinterpret_cast<get_message_ts_func>(dlsym(type_support_lib, ts_func_name.c_str()));
+    reinterpret_cast<get_message_ts_func>(load_type_support_function(
+      interface_type,
+      "rosidl_typesupport_c__get_message_type_support_handle__" + interface_type.first +
+      "__msg__" + interface_type.second));
   if (type_support_handle_func == nullptr) {
-    RCUTILS_LOG_ERROR_NAMED("dynmsg_demo", "failed to load type support function: %s", dlerror());
     return nullptr;
   }
 
@@ -93,3 +267,22 @@ const TypeSupport * get_type_support(const InterfaceTypeName & interface_type)
 
   return ts;
 }
+
+const ServiceTypeSupport * get_service_type_support(const InterfaceTypeName & interface_type)
+{
+  get_service_ts_func type_support_handle_func =
+    reinterpret_cast<get_service_ts_func>(load_type_support_function(
+      interface_type,
+      "rosidl_typesupport_c__get_service_type_support_handle__" + interface_type.first +
+      "__srv__" + interface_type.second));
+  if (type_support_handle_func == nullptr) {
+    return nullptr;
+  }
+
+  // Call the function to get the type support we want
+  const rosidl_service_type_support_t * ts = type_support_handle_func();
+  RCUTILS_LOG_DEBUG_NAMED(
+    "dynmsg_demo", "Loaded service type support %s", ts->typesupport_identifier);
+
+  return ts;
+}
@@ -0,0 +1,151 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <yaml-cpp/yaml.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "dynmsg/config.hpp"
+#include "dynmsg/typesupport.hpp"
+#include "dynmsg_demo/echo_pipeline.hpp"
+#include "dynmsg_demo/typesupport_utils.hpp"
+
+#include "example_interfaces/msg/bool.h"
+#include "example_interfaces/msg/int32.h"
+#include "example_interfaces/msg/string.h"
+
+#include "rmw/rmw.h"
+#include "rosidl_runtime_c/string_functions.h"
+
+TEST(EchoPipeline, ParseOutputFormat)
+{
+  EXPECT_EQ(parse_output_format("yaml"), OutputFormat::Yaml);
+  EXPECT_EQ(parse_output_format("json"), OutputFormat::Json);
+  EXPECT_THROW(parse_output_format("xml"), std::runtime_error);
+}
+
+TEST(EchoPipeline, RenderJson)
+{
+  example_interfaces__msg__String * msg = example_interfaces__msg__String__create();
+  ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg->data, "say \"hi\"\n"));
+
+  RosMessage message;
+  message.type_info = dynmsg::c::get_type_info(InterfaceTypeName{"example_interfaces", "String"});
+  message.data = reinterpret_cast<uint8_t *>(msg);
+  const std::string json = render_message(message, OutputFormat::Json);
+#ifdef DYNMSG_VALUE_ONLY
+  EXPECT_EQ(json, "{\"data\": \"say \\\"hi\\\"\\n\"}");
+#else
+  EXPECT_EQ(json, "{\"data\": {\"type\": \"string\", \"value\": \"say \\\"hi\\\"\\n\"}}");
+#endif
+
+  const std::string tagged = render_message(message, OutputFormat::Json, "/chatter");
+  EXPECT_EQ(tagged, "{\"topic\": \"/chatter\", \"message\": " + json + "}");
+
+  example_interfaces__msg__String__destroy(msg);
+}
+
+TEST(EchoPipeline, RenderJsonTypedValues)
+{
+  // Numbers and booleans are not quoted
+  example_interfaces__msg__Int32 int32_msg;
+  int32_msg.data = -42;
+  RosMessage message;
+  message.type_info = dynmsg::c::get_type_info(InterfaceTypeName{"example_interfaces", "Int32"});
+  message.data = reinterpret_cast<uint8_t *>(&int32_msg);
+#ifdef DYNMSG_VALUE_ONLY
+  EXPECT_EQ(render_message(message, OutputFormat::Json), "{\"data\": -42}");
+#else
+  EXPECT_EQ(
+    render_message(message, OutputFormat::Json),
+    "{\"data\": {\"type\": \"int32\", \"value\": -42}}");
+#endif
+
+  example_interfaces__msg__Bool bool_msg;
+  bool_msg.data = true;
+  message.type_info = dynmsg::c::get_type_info(InterfaceTypeName{"example_interfaces", "Bool"});
+  message.data = reinterpret_cast<uint8_t *>(&bool_msg);
+#ifdef DYNMSG_VALUE_ONLY
+  EXPECT_EQ(render_message(message, OutputFormat::Json), "{\"data\": true}");
+#else
+  EXPECT_EQ(
+    render_message(message, OutputFormat::Json),
+    "{\"data\": {\"type\": \"boolean\", \"value\": true}}");
+#endif
+}
+
+TEST(EchoPipeline, PrintsInOrder)
+{
+  const InterfaceTypeName interface_type{"example_interfaces", "Int32"};
+  const TypeInfo * type_info = dynmsg::c::get_type_info(interface_type);
+  ASSERT_NE(type_info, nullptr);
+  const TypeSupport * type_support = get_type_support(interface_type);
+  ASSERT_NE(type_support, nullptr);
+  const MessageType type{interface_type, type_info, type_support};
+  const std::string topic;
+
+  constexpr int32_t message_count = 200;
+  std::ostringstream out;
+  {
+    // Enough buffers that none of the messages are dropped
+    EchoPipeline pipeline(OutputFormat::Yaml, 4, 256, out);
+    example_interfaces__msg__Int32 msg;
+    for (int32_t ii = 0; ii < message_count; ++ii) {
+      msg.data = ii;
+      ASSERT_EQ(RMW_RET_OK, rmw_serialize(&msg, type_support, pipeline.next_buffer()));
+      pipeline.commit(type, topic);
+    }
+    pipeline.finish();
+    EXPECT_EQ(pipeline.dropped(), 0u);
+  }
+
+  const std::vector<YAML::Node> documents = YAML::LoadAll(out.str());
+  ASSERT_EQ(documents.size(), static_cast<size_t>(message_count));
+  for (int32_t ii = 0; ii < message_count; ++ii) {
+#ifdef DYNMSG_VALUE_ONLY
+    EXPECT_EQ(documents[ii]["data"].as<int32_t>(), ii);
+#else
+    EXPECT_EQ(documents[ii]["data"]["value"].as<int32_t>(), ii);
+#endif
+  }
+}
+
+TEST(EchoPipeline, DropsWhenFull)
+{
+  const InterfaceTypeName interface_type{"example_interfaces", "Int32"};
+  const TypeInfo * type_info = dynmsg::c::get_type_info(interface_type);
+  ASSERT_NE(type_info, nullptr);
+  const TypeSupport * type_support = get_type_support(interface_type);
+  ASSERT_NE(type_support, nullptr);
+  const MessageType type{interface_type, type_info, type_support};
+  const std::string topic;
+
+  std::ostringstream out;
+  EchoPipeline pipeline(OutputFormat::Yaml, 1, 1, out);
+  example_interfaces__msg__Int32 msg;
+  msg.data = 0;
+  size_t committed = 0;
+  // With a single buffer, messages must be dropped unless each is printed before the next one
+  for (; committed < 1000u && 0u == pipeline.dropped(); ++committed) {
+    ASSERT_EQ(RMW_RET_OK, rmw_serialize(&msg, type_support, pipeline.next_buffer()));
+    pipeline.commit(type, topic);
+  }
+  pipeline.finish();
+  const size_t printed = YAML::LoadAll(out.str()).size();
+  EXPECT_EQ(printed + pipeline.dropped(), committed);
+}
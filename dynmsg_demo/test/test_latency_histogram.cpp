@@ -0,0 +1,105 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "dynmsg_demo/latency_histogram.hpp"
+
+TEST(LatencyHistogram, Empty)
+{
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.min(), 0u);
+  EXPECT_EQ(histogram.max(), 0u);
+  EXPECT_EQ(histogram.mean(), 0.0);
+  EXPECT_EQ(histogram.percentile(50.0), 0u);
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact)
+{
+  LatencyHistogram histogram;
+  for (uint64_t value = 0; value < LatencyHistogram::SUB_BUCKET_COUNT * 2; ++value) {
+    histogram.record(value);
+  }
+  EXPECT_EQ(histogram.count(), 256u);
+  EXPECT_EQ(histogram.min(), 0u);
+  EXPECT_EQ(histogram.max(), 255u);
+  EXPECT_DOUBLE_EQ(histogram.mean(), 127.5);
+  EXPECT_EQ(histogram.percentile(0.0), 0u);
+  EXPECT_EQ(histogram.percentile(50.0), 127u);
+  EXPECT_EQ(histogram.percentile(100.0), 255u);
+}
+
+TEST(LatencyHistogram, BoundedRelativeError)
+{
+  LatencyHistogram histogram;
+  for (uint64_t value = 1; value <= 100000; ++value) {
+    histogram.record(value * 1000);
+  }
+  const double percentages[] = {1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 99.99};
+  for (const double percentage : percentages) {
+    const double exact = percentage * 1000.0 * 1000.0;
+    const double value = static_cast<double>(histogram.percentile(percentage));
+    EXPECT_GE(value, exact) << percentage;
+    EXPECT_LE(value, exact * (1.0 + 1.0 / LatencyHistogram::SUB_BUCKET_COUNT)) << percentage;
+  }
+  EXPECT_EQ(histogram.percentile(100.0), 100000000u);
+  EXPECT_EQ(histogram.min(), 1000u);
+}
+
+TEST(LatencyHistogram, LargestValues)
+{
+  LatencyHistogram histogram;
+  histogram.record(std::numeric_limits<uint64_t>::max());
+  histogram.record(uint64_t{1} << 63);
+  EXPECT_EQ(histogram.max(), std::numeric_limits<uint64_t>::max());
+  EXPECT_EQ(histogram.percentile(100.0), std::numeric_limits<uint64_t>::max());
+  EXPECT_GE(histogram.percentile(50.0), uint64_t{1} << 63);
+}
+
+TEST(LatencyHistogram, AddAndReset)
+{
+  LatencyHistogram first;
+  LatencyHistogram second;
+  first.record(10);
+  second.record(1000);
+  second.record(20);
+  first.add(second);
+  EXPECT_EQ(first.count(), 3u);
+  EXPECT_EQ(first.min(), 10u);
+  EXPECT_EQ(first.max(), 1000u);
+  EXPECT_EQ(first.percentile(50.0), 20u);
+
+  first.reset();
+  EXPECT_EQ(first.count(), 0u);
+  EXPECT_EQ(first.percentile(99.0), 0u);
+}
+
+TEST(LatencyHistogram, PrintDistribution)
+{
+  LatencyHistogram histogram;
+  for (uint64_t value = 1; value <= 100; ++value) {
+    histogram.record(value * 1000);
+  }
+  std::ostringstream out;
+  histogram.print_distribution(out, 1000.0);
+  const std::string distribution = out.str();
+  EXPECT_NE(distribution.find("Percentile"), std::string::npos);
+  EXPECT_NE(distribution.find("#[Mean = 50.500, Max = 100.000, Count = 100]"), std::string::npos);
+}
@@ -0,0 +1,99 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "dynmsg/typesupport.hpp"
+#include "dynmsg_demo/message_fields.hpp"
+
+#include "std_msgs/msg/header.h"
+#include "test_msgs/msg/arrays.h"
+#include "test_msgs/msg/nested.h"
+
+#include "rosidl_typesupport_introspection_c/field_types.h"
+
+TEST(MessageFields, SetNestedField)
+{
+  test_msgs__msg__Nested * msg = test_msgs__msg__Nested__create();
+  RosMessage message;
+  message.type_info = dynmsg::c::get_type_info(InterfaceTypeName{"test_msgs", "Nested"});
+  message.data = reinterpret_cast<uint8_t *>(msg);
+
+  NumericField field = find_numeric_field(message, "basic_types_value.int32_value");
+  EXPECT_EQ(field.type_id, rosidl_typesupport_introspection_c__ROS_TYPE_INT32);
+  EXPECT_EQ(field.data, reinterpret_cast<uint8_t *>(&msg->basic_types_value.int32_value));
+  set_numeric_field(field, -42);
+  EXPECT_EQ(msg->basic_types_value.int32_value, -42);
+
+  set_numeric_field(find_numeric_field(message, "basic_types_value.uint64_value"), 1234567890123);
+  EXPECT_EQ(msg->basic_types_value.uint64_value, 1234567890123u);
+  set_numeric_field(find_numeric_field(message, "basic_types_value.float64_value"), 7);
+  EXPECT_EQ(msg->basic_types_value.float64_value, 7.0);
+  set_numeric_field(find_numeric_field(message, "basic_types_value.uint8_value"), 200);
+  EXPECT_EQ(msg->basic_types_value.uint8_value, 200);
+
+  test_msgs__msg__Nested__destroy(msg);
+}
+
+TEST(MessageFields, InvalidPaths)
+{
+  test_msgs__msg__Nested * nested = test_msgs__msg__Nested__create();
+  RosMessage message;
+  message.type_info = dynmsg::c::get_type_info(InterfaceTypeName{"test_msgs", "Nested"});
+  message.data = reinterpret_cast<uint8_t *>(nested);
+  EXPECT_THROW(find_numeric_field(message, "no_such_member"), std::runtime_error);
+  EXPECT_THROW(find_numeric_field(message, "basic_types_value"), std::runtime_error);
+  EXPECT_THROW(find_numeric_field(message, "basic_types_value.missing"), std::runtime_error);
+  EXPECT_THROW(
+    find_numeric_field(message, "basic_types_value.int32_value.sec"), std::runtime_error);
+  test_msgs__msg__Nested__destroy(nested);
+
+  test_msgs__msg__Arrays * arrays = test_msgs__msg__Arrays__create();
+  message.type_info = dynmsg::c::get_type_info(InterfaceTypeName{"test_msgs", "Arrays"});
+  message.data = reinterpret_cast<uint8_t *>(arrays);
+  EXPECT_THROW(find_numeric_field(message, "int32_values"), std::runtime_error);
+  EXPECT_THROW(find_numeric_field(message, "string_values"), std::runtime_error);
+  test_msgs__msg__Arrays__destroy(arrays);
+}
+
+TEST(MessageFields, StampFields)
+{
+  std_msgs__msg__Header * header = std_msgs__msg__Header__create();
+  RosMessage message;
+  message.type_info = dynmsg::c::get_type_info(InterfaceTypeName{"std_msgs", "Header"});
+  message.data = reinterpret_cast<uint8_t *>(header);
+
+  const StampField stamp = find_stamp_field(message, "stamp");
+  set_stamp_field(stamp, 1234567890123456789);
+  EXPECT_EQ(header->stamp.sec, 1234567890);
+  EXPECT_EQ(header->stamp.nanosec, 123456789u);
+  EXPECT_EQ(get_stamp_field(stamp), 1234567890123456789);
+  EXPECT_THROW(find_stamp_field(message, "frame_id"), std::runtime_error);
+  std_msgs__msg__Header__destroy(header);
+
+  // A 64-bit integer holds a number of nanoseconds
+  test_msgs__msg__Nested * nested = test_msgs__msg__Nested__create();
+  message.type_info = dynmsg::c::get_type_info(InterfaceTypeName{"test_msgs", "Nested"});
+  message.data = reinterpret_cast<uint8_t *>(nested);
+  const StampField nanoseconds = find_stamp_field(message, "basic_types_value.int64_value");
+  set_stamp_field(nanoseconds, 1234567890123456789);
+  EXPECT_EQ(nested->basic_types_value.int64_value, 1234567890123456789);
+  EXPECT_EQ(get_stamp_field(nanoseconds), 1234567890123456789);
+  EXPECT_THROW(
+    find_stamp_field(message, "basic_types_value.int32_value"), std::runtime_error);
+  EXPECT_THROW(find_stamp_field(message, "basic_types_value"), std::runtime_error);
+  test_msgs__msg__Nested__destroy(nested);
+}
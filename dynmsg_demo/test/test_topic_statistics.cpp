@@ -0,0 +1,91 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+
+#include "dynmsg_demo/topic_statistics.hpp"
+
+using std::chrono::milliseconds;
+
+TEST(TopicStatistics, Empty)
+{
+  EXPECT_THROW(TopicStatistics(1), std::runtime_error);
+
+  TopicStatistics stats(10);
+  const WindowSummary summary = stats.summarize();
+  EXPECT_EQ(summary.count, 0u);
+  EXPECT_EQ(summary.rate, 0.0);
+  EXPECT_EQ(summary.bytes_per_second, 0.0);
+  EXPECT_EQ(stats.total_count(), 0u);
+}
+
+TEST(TopicStatistics, SingleMessage)
+{
+  TopicStatistics stats(10);
+  stats.add(TopicStatistics::Clock::time_point(), 100);
+  const WindowSummary summary = stats.summarize();
+  EXPECT_EQ(summary.count, 1u);
+  EXPECT_EQ(summary.rate, 0.0);
+  EXPECT_EQ(summary.mean_size, 100.0);
+  EXPECT_EQ(summary.min_size, 100u);
+  EXPECT_EQ(summary.max_size, 100u);
+}
+
+TEST(TopicStatistics, RateAndBandwidth)
+{
+  TopicStatistics stats(10);
+  TopicStatistics::Clock::time_point arrival;
+  // Alternate intervals of 10 ms and 30 ms, i.e. 50 messages per second on average
+  for (int ii = 0; ii < 5; ++ii) {
+    stats.add(arrival, 100);
+    arrival += milliseconds(ii % 2 == 0 ? 10 : 30);
+  }
+  WindowSummary summary = stats.summarize();
+  EXPECT_EQ(summary.count, 5u);
+  EXPECT_DOUBLE_EQ(summary.rate, 50.0);
+  EXPECT_DOUBLE_EQ(summary.mean_interval, 0.02);
+  EXPECT_DOUBLE_EQ(summary.min_interval, 0.01);
+  EXPECT_DOUBLE_EQ(summary.max_interval, 0.03);
+  EXPECT_DOUBLE_EQ(summary.stddev_interval, 0.01);
+  // 4 messages of 100 bytes over 80 ms
+  EXPECT_DOUBLE_EQ(summary.bytes_per_second, 5000.0);
+}
+
+TEST(TopicStatistics, WindowOnlyKeepsRecentMessages)
+{
+  TopicStatistics stats(4);
+  TopicStatistics::Clock::time_point arrival;
+  // Slow, large messages that fall out of the window
+  for (int ii = 0; ii < 10; ++ii) {
+    stats.add(arrival, 1000);
+    arrival += milliseconds(100);
+  }
+  // Fast, small messages
+  for (int ii = 0; ii < 6; ++ii) {
+    stats.add(arrival, 10 + ii);
+    arrival += milliseconds(1);
+  }
+  const WindowSummary summary = stats.summarize();
+  EXPECT_EQ(summary.count, 4u);
+  EXPECT_EQ(stats.total_count(), 16u);
+  EXPECT_NEAR(summary.rate, 1000.0, 1e-6);
+  EXPECT_NEAR(summary.min_interval, 0.001, 1e-9);
+  EXPECT_NEAR(summary.max_interval, 0.001, 1e-9);
+  EXPECT_EQ(summary.min_size, 12u);
+  EXPECT_EQ(summary.max_size, 15u);
+  EXPECT_DOUBLE_EQ(summary.mean_size, 13.5);
+}
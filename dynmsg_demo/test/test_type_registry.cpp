@@ -0,0 +1,89 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "dynmsg_demo/type_registry.hpp"
+
+TEST(TypeRegistry, LoadsEachTypeOnce)
+{
+  TypeRegistry registry;
+  const MessageType & int32 = registry.get(InterfaceTypeName{"example_interfaces", "Int32"});
+  EXPECT_NE(int32.type_info, nullptr);
+  EXPECT_NE(int32.type_support, nullptr);
+  EXPECT_EQ(int32.name, (InterfaceTypeName{"example_interfaces", "Int32"}));
+
+  const MessageType & string = registry.get(InterfaceTypeName{"example_interfaces", "String"});
+  EXPECT_NE(string.type_info, int32.type_info);
+  EXPECT_EQ(registry.size(), 2u);
+
+  EXPECT_EQ(&registry.get(InterfaceTypeName{"example_interfaces", "Int32"}), &int32);
+  EXPECT_EQ(registry.size(), 2u);
+}
+
+TEST(TypeRegistry, UnknownType)
+{
+  TypeRegistry registry;
+  EXPECT_THROW(
+    registry.get(InterfaceTypeName{"example_interfaces", "NoSuchType"}), std::runtime_error);
+  EXPECT_THROW(registry.get(InterfaceTypeName{"no_such_package", "Int32"}), std::runtime_error);
+  EXPECT_EQ(registry.size(), 0u);
+}
+
+TEST(TypeRegistry, LoadsServiceTypes)
+{
+  TypeRegistry registry;
+  const ServiceType & add_two_ints =
+    registry.get_service(InterfaceTypeName{"example_interfaces", "AddTwoInts"});
+  EXPECT_NE(add_two_ints.type_support, nullptr);
+  ASSERT_NE(add_two_ints.request_type_info, nullptr);
+  ASSERT_NE(add_two_ints.response_type_info, nullptr);
+  EXPECT_STREQ(add_two_ints.request_type_info->message_name_, "AddTwoInts_Request");
+  EXPECT_STREQ(add_two_ints.response_type_info->message_name_, "AddTwoInts_Response");
+  EXPECT_EQ(registry.size(), 1u);
+
+  EXPECT_EQ(
+    &registry.get_service(InterfaceTypeName{"example_interfaces", "AddTwoInts"}), &add_two_ints);
+  EXPECT_EQ(registry.size(), 1u);
+  EXPECT_THROW(
+    registry.get_service(InterfaceTypeName{"example_interfaces", "Int32"}), std::runtime_error);
+}
+
+TEST(TypeRegistry, SharedBetweenThreads)
+{
+  TypeRegistry & registry = TypeRegistry::shared();
+  EXPECT_EQ(&registry, &TypeRegistry::shared());
+
+  // Every thread gets the same type, which is only loaded once
+  const InterfaceTypeName interface_type{"example_interfaces", "Float64"};
+  std::vector<const MessageType *> types(8, nullptr);
+  std::vector<std::thread> threads;
+  for (size_t ii = 0; ii < types.size(); ++ii) {
+    threads.emplace_back(
+      [&registry, &interface_type, &types, ii]() {
+        types[ii] = &registry.get(interface_type);
+      });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  for (const MessageType * type : types) {
+    EXPECT_EQ(type, types[0]);
+  }
+  EXPECT_NE(types[0]->type_support, nullptr);
+}
@@ -0,0 +1,261 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef __GLIBC__
+# include <malloc.h>
+#endif
+
+#include "dynmsg/memory_tracking.hpp"
+
+#include "allocation_counting.hpp"
+
+namespace
+{
+
+std::atomic<size_t> allocation_count(0);
+std::atomic<size_t> allocated_bytes(0);
+
+void count_allocation(size_t size) noexcept
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+AllocationCounts operator-(const AllocationCounts & lhs, const AllocationCounts & rhs)
+{
+  return AllocationCounts{lhs.allocations - rhs.allocations, lhs.bytes - rhs.bytes};
+}
+
+AllocationCounts get_heap_allocation_counts()
+{
+  return AllocationCounts{
+    allocation_count.load(std::memory_order_relaxed),
+    allocated_bytes.load(std::memory_order_relaxed)};
+}
+
+#ifdef __GLIBC__
+
+// glibc lets programs replace malloc() and friends, and exports its own implementations under
+// other names. The default operator new calls malloc(), and the aligned operator new calls
+// aligned_alloc(), so they are counted too.
+// The usable sizes of the blocks are reported to dynmsg, to track the memory used by conversions.
+// Every function that allocates blocks is replaced, since free() reports every block it frees.
+
+extern "C"
+{
+
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t number_of_elements, size_t size_of_element);
+void * __libc_realloc(void * pointer, size_t size);
+void __libc_free(void * pointer);
+void * __libc_memalign(size_t alignment, size_t size);
+void * __libc_valloc(size_t size);
+void * __libc_pvalloc(size_t size);
+
+void * malloc(size_t size)
+{
+  count_allocation(size);
+  void * pointer = __libc_malloc(size);
+  dynmsg::memory_tracking::record_allocation(malloc_usable_size(pointer));
+  return pointer;
+}
+
+void * calloc(size_t number_of_elements, size_t size_of_element)
+{
+  count_allocation(number_of_elements * size_of_element);
+  void * pointer = __libc_calloc(number_of_elements, size_of_element);
+  dynmsg::memory_tracking::record_allocation(malloc_usable_size(pointer));
+  return pointer;
+}
+
+void * realloc(void * pointer, size_t size)
+{
+  count_allocation(size);
+  const size_t previous_size = malloc_usable_size(pointer);
+  void * new_pointer = __libc_realloc(pointer, size);
+  // The previous block is only freed if the new one could be allocated
+  if (nullptr != new_pointer || 0 == size) {
+    dynmsg::memory_tracking::record_deallocation(previous_size);
+    dynmsg::memory_tracking::record_allocation(malloc_usable_size(new_pointer));
+  }
+  return new_pointer;
+}
+
+void * memalign(size_t alignment, size_t size)
+{
+  count_allocation(size);
+  void * pointer = __libc_memalign(alignment, size);
+  dynmsg::memory_tracking::record_allocation(malloc_usable_size(pointer));
+  return pointer;
+}
+
+void * aligned_alloc(size_t alignment, size_t size)
+{
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void ** pointer, size_t alignment, size_t size)
+{
+  // The alignment must be a power of two multiple of sizeof(void *)
+  if (0u != alignment % sizeof(void *) || 0u != (alignment & (alignment - 1u))) {
+    return EINVAL;
+  }
+  void * new_pointer = memalign(alignment, size);
+  if (nullptr == new_pointer) {
+    return ENOMEM;
+  }
+  *pointer = new_pointer;
+  return 0;
+}
+
+void * valloc(size_t size)
+{
+  count_allocation(size);
+  void * pointer = __libc_valloc(size);
+  dynmsg::memory_tracking::record_allocation(malloc_usable_size(pointer));
+  return pointer;
+}
+
+void * pvalloc(size_t size)
+{
+  count_allocation(size);
+  void * pointer = __libc_pvalloc(size);
+  dynmsg::memory_tracking::record_allocation(malloc_usable_size(pointer));
+  return pointer;
+}
+
+void free(void * pointer)
+{
+  dynmsg::memory_tracking::record_deallocation(malloc_usable_size(pointer));
+  __libc_free(pointer);
+}
+
+}  // extern "C"
+
+#else
+
+// Without glibc, only the allocations made with operator new are counted. Their sizes are stored
+// before the allocated blocks, to report them to dynmsg when they are freed.
+
+namespace
+{
+
+constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+}  // namespace
+
+void * operator new(size_t size)
+{
+  count_allocation(size);
+  void * block = std::malloc(HEADER_SIZE + size);
+  if (nullptr == block) {
+    throw std::bad_alloc();
+  }
+  *static_cast<size_t *>(block) = size;
+  dynmsg::memory_tracking::record_allocation(size);
+  return static_cast<char *>(block) + HEADER_SIZE;
+}
+
+void * operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void * ptr) noexcept
+{
+  if (nullptr == ptr) {
+    return;
+  }
+  void * block = static_cast<char *>(ptr) - HEADER_SIZE;
+  dynmsg::memory_tracking::record_deallocation(*static_cast<size_t *>(block));
+  std::free(block);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+  operator delete(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept
+{
+  operator delete(ptr);
+}
+
+void operator delete[](void * ptr, size_t) noexcept
+{
+  operator delete(ptr);
+}
+
+#endif  // __GLIBC__
+
+CountingAllocator::CountingAllocator()
+: base_(rcutils_get_default_allocator()),
+  counts_{0, 0}
+{
+}
+
+rcutils_allocator_t CountingAllocator::get()
+{
+  rcutils_allocator_t allocator = rcutils_get_zero_initialized_allocator();
+  allocator.allocate = &CountingAllocator::allocate;
+  allocator.deallocate = &CountingAllocator::deallocate;
+  allocator.reallocate = &CountingAllocator::reallocate;
+  allocator.zero_allocate = &CountingAllocator::zero_allocate;
+  allocator.state = this;
+  return allocator;
+}
+
+AllocationCounts CountingAllocator::counts() const
+{
+  return counts_;
+}
+
+void * CountingAllocator::allocate(size_t size, void * state)
+{
+  auto * self = static_cast<CountingAllocator *>(state);
+  ++self->counts_.allocations;
+  self->counts_.bytes += size;
+  return self->base_.allocate(size, self->base_.state);
+}
+
+void CountingAllocator::deallocate(void * pointer, void * state)
+{
+  auto * self = static_cast<CountingAllocator *>(state);
+  self->base_.deallocate(pointer, self->base_.state);
+}
+
+void * CountingAllocator::reallocate(void * pointer, size_t size, void * state)
+{
+  auto * self = static_cast<CountingAllocator *>(state);
+  ++self->counts_.allocations;
+  self->counts_.bytes += size;
+  return self->base_.reallocate(pointer, size, self->base_.state);
+}
+
+void * CountingAllocator::zero_allocate(
+  size_t number_of_elements, size_t size_of_element, void * state)
+{
+  auto * self = static_cast<CountingAllocator *>(state);
+  ++self->counts_.allocations;
+  self->counts_.bytes += number_of_elements * size_of_element;
+  return self->base_.zero_allocate(number_of_elements, size_of_element, self->base_.state);
+}
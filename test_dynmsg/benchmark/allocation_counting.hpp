@@ -0,0 +1,75 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLOCATION_COUNTING_HPP_
+#define ALLOCATION_COUNTING_HPP_
+
+#include <cstddef>
+
+#include "rcutils/allocator.h"
+
+// Counting of the allocations made by the conversions, for benchmarks and tests.
+//
+// Linking the dynmsg_allocation_counting library into a program replaces the allocation functions
+// of the process with ones that count every call, and report the allocated and freed blocks to
+// dynmsg::memory_tracking, so it should only be linked into programs that measure allocations.
+//
+// dynmsg_demo has a counter of its own for the CLI tool, which only counts operator new. It cannot
+// be shared through the dynmsg package: every program depending on dynmsg would link the exported
+// replacements of the allocation functions. This one also counts the allocations of the rosidl
+// runtime, which the benchmarks compare against those made through the rcutils allocator.
+
+// Number of allocations, and the bytes requested by them
+struct AllocationCounts
+{
+  size_t allocations;
+  size_t bytes;
+};
+
+AllocationCounts operator-(const AllocationCounts & lhs, const AllocationCounts & rhs);
+
+// Get the number of heap allocations made by the process so far.
+//
+// With glibc, this counts calls to malloc(), calloc() and realloc(), which operator new and the
+// rosidl runtime use. Otherwise, it only counts calls to operator new.
+AllocationCounts get_heap_allocation_counts();
+
+// An rcutils allocator that counts the allocations made with it, and forwards them to the default
+// allocator.
+//
+// The allocator returned by get() refers to this object, which must outlive it. Allocations are
+// not counted atomically, so the allocator must only be used by one thread at a time.
+class CountingAllocator
+{
+public:
+  CountingAllocator();
+
+  CountingAllocator(const CountingAllocator &) = delete;
+  CountingAllocator & operator=(const CountingAllocator &) = delete;
+
+  rcutils_allocator_t get();
+
+  AllocationCounts counts() const;
+
+private:
+  static void * allocate(size_t size, void * state);
+  static void deallocate(void * pointer, void * state);
+  static void * reallocate(void * pointer, size_t size, void * state);
+  static void * zero_allocate(size_t number_of_elements, size_t size_of_element, void * state);
+
+  rcutils_allocator_t base_;
+  AllocationCounts counts_;
+};
+
+#endif  // ALLOCATION_COUNTING_HPP_
@@ -0,0 +1,320 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the conversions between ROS messages and YAML, over messages of a few
+// representative shapes in both the C and C++ layouts.
+//
+// Each benchmark is named <layout>/<operation>/<shape>, followed by the number of elements for
+// shapes built around a sequence, e.g. "cpp/to_yaml/string_sequence/256". Bytes processed are the
+// bytes of YAML text produced or consumed, so they can be compared between shapes.
+//
+// Each benchmark also reports the heap allocations made for each message, and those made through
+// the rcutils allocator given to dynmsg, so that allocation budgets can be set for each shape, and
+// the peak of the heap memory used by the conversion of each message (0 for the operations that do
+// not convert messages).
+
+#include <benchmark/benchmark.h>
+#include <yaml-cpp/yaml.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "dynmsg/config.hpp"
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/memory_tracking.hpp"
+#include "dynmsg/message_reading.hpp"
+#include "dynmsg/msg_parser.hpp"
+#include "dynmsg/typesupport.hpp"
+#include "dynmsg/yaml_utils.hpp"
+
+#include "allocation_counting.hpp"
+
+#include "test_msgs/msg/basic_types.hpp"
+#include "test_msgs/msg/multi_nested.hpp"
+#include "test_msgs/msg/unbounded_sequences.hpp"
+
+#ifndef DYNMSG_VALUE_ONLY
+# error "the benchmarks parse the YAML produced from messages, which needs DYNMSG_VALUE_ONLY"
+#endif
+
+namespace
+{
+
+// A message in both layouts, and its YAML representation
+struct Sample
+{
+  template<typename MessageT>
+  Sample(const InterfaceTypeName & interface_type, const MessageT & message)
+  : type_info(dynmsg::c::get_type_info(interface_type)),
+    type_info_cpp(dynmsg::cpp::get_type_info(interface_type))
+  {
+    if (nullptr == type_info || nullptr == type_info_cpp) {
+      throw std::runtime_error(
+        "failed to load introspection information of " + interface_type.first + "/" +
+        interface_type.second);
+    }
+    message_cpp = dynmsg::cpp::DynamicMessage(type_info_cpp);
+    *reinterpret_cast<MessageT *>(message_cpp.data()) = message;
+    yaml = dynmsg::yaml_to_string(dynmsg::cpp::message_to_yaml(message_cpp.get()));
+    message_c = dynmsg::c::DynamicMessage::adopt(
+      dynmsg::c::yaml_and_typeinfo_to_rosmsg(type_info, yaml, nullptr));
+  }
+
+  const TypeInfo * type_info;
+  const TypeInfo_Cpp * type_info_cpp;
+  dynmsg::c::DynamicMessage message_c;
+  dynmsg::cpp::DynamicMessage message_cpp;
+  std::string yaml;
+};
+
+void populate_basic_types(test_msgs::msg::BasicTypes & msg, size_t seed)
+{
+  msg.bool_value = 0 != seed % 2;
+  msg.byte_value = static_cast<uint8_t>(seed);
+  msg.char_value = static_cast<uint8_t>('a' + seed % 26);
+  msg.float32_value = 0.5f + static_cast<float>(seed);
+  msg.float64_value = 0.25 + static_cast<double>(seed);
+  msg.int8_value = -static_cast<int8_t>(seed % 128);
+  msg.uint8_value = static_cast<uint8_t>(seed);
+  msg.int16_value = -static_cast<int16_t>(seed % 32768);
+  msg.uint16_value = static_cast<uint16_t>(seed);
+  msg.int32_value = -static_cast<int32_t>(seed);
+  msg.uint32_value = static_cast<uint32_t>(seed);
+  msg.int64_value = -static_cast<int64_t>(seed) * 1000000007;
+  msg.uint64_value = static_cast<uint64_t>(seed) * 1000000007u;
+}
+
+// A message made of scalars only
+Sample make_flat_scalars(size_t)
+{
+  test_msgs::msg::BasicTypes msg;
+  populate_basic_types(msg, 42);
+  return Sample({"test_msgs", "BasicTypes"}, msg);
+}
+
+// A message with three levels of nested messages, held in arrays and sequences
+Sample make_deep_nesting(size_t)
+{
+  test_msgs::msg::MultiNested msg;
+  for (auto & arrays : msg.array_of_arrays) {
+    for (size_t ii = 0; ii < arrays.basic_types_values.size(); ++ii) {
+      populate_basic_types(arrays.basic_types_values[ii], ii);
+    }
+  }
+  for (auto & sequences : msg.array_of_unbounded_sequences) {
+    sequences.basic_types_values.resize(3);
+    for (size_t ii = 0; ii < sequences.basic_types_values.size(); ++ii) {
+      populate_basic_types(sequences.basic_types_values[ii], ii);
+    }
+  }
+  return Sample({"test_msgs", "MultiNested"}, msg);
+}
+
+// A message with long sequences of integers and floating point numbers
+Sample make_primitive_sequence(size_t size)
+{
+  test_msgs::msg::UnboundedSequences msg;
+  for (size_t ii = 0; ii < size; ++ii) {
+    msg.int32_values.push_back(static_cast<int32_t>(ii) - 1000);
+    msg.float64_values.push_back(static_cast<double>(ii) * 0.125);
+  }
+  return Sample({"test_msgs", "UnboundedSequences"}, msg);
+}
+
+// A message with a long sequence of strings
+Sample make_string_sequence(size_t size)
+{
+  test_msgs::msg::UnboundedSequences msg;
+  for (size_t ii = 0; ii < size; ++ii) {
+    msg.string_values.push_back("a string of about forty characters, #" + std::to_string(ii));
+  }
+  return Sample({"test_msgs", "UnboundedSequences"}, msg);
+}
+
+// A message with a long sequence of nested messages
+Sample make_nested_sequence(size_t size)
+{
+  test_msgs::msg::UnboundedSequences msg;
+  msg.basic_types_values.resize(size);
+  for (size_t ii = 0; ii < size; ++ii) {
+    populate_basic_types(msg.basic_types_values[ii], ii);
+  }
+  return Sample({"test_msgs", "UnboundedSequences"}, msg);
+}
+
+struct Shape
+{
+  const char * name;
+  Sample (* make)(size_t size);
+  // Whether the shape is built around a sequence, whose size is a benchmark argument
+  bool is_sized;
+};
+
+const Shape SHAPES[] = {
+  {"flat_scalars", make_flat_scalars, false},
+  {"deep_nesting", make_deep_nesting, false},
+  {"primitive_sequence", make_primitive_sequence, true},
+  {"string_sequence", make_string_sequence, true},
+  {"nested_sequence", make_nested_sequence, true},
+};
+
+// Run an operation in the timed loop of a benchmark, and report its throughput and allocations.
+//
+// The operations are deterministic, so the allocations of a single run, made outside of the timed
+// loop, are the allocations of every run. Allocations made through the rcutils allocator given to
+// dynmsg are also counted separately.
+template<typename Operation>
+void run_operation(
+  benchmark::State & state,
+  const CountingAllocator & allocator,
+  size_t bytes_per_message,
+  Operation operation)
+{
+  // Warm up, e.g. so that lazily loaded information does not count as allocations
+  operation();
+  dynmsg::memory_tracking::reset_last_conversion_memory();
+  dynmsg::memory_tracking::set_enabled(true);
+  const AllocationCounts heap_before = get_heap_allocation_counts();
+  const AllocationCounts rcutils_before = allocator.counts();
+  operation();
+  const AllocationCounts heap = get_heap_allocation_counts() - heap_before;
+  const AllocationCounts rcutils = allocator.counts() - rcutils_before;
+  dynmsg::memory_tracking::set_enabled(false);
+  const auto memory = dynmsg::memory_tracking::get_last_conversion_memory();
+
+  for (auto _ : state) {
+    operation();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes_per_message));
+  state.counters["allocs"] = static_cast<double>(heap.allocations);
+  state.counters["alloc_bytes"] = static_cast<double>(heap.bytes);
+  state.counters["rcutils_allocs"] = static_cast<double>(rcutils.allocations);
+  state.counters["rcutils_alloc_bytes"] = static_cast<double>(rcutils.bytes);
+  state.counters["peak_bytes"] = static_cast<double>(memory.peak_bytes);
+}
+
+void c_init_destroy(benchmark::State & state, const Sample & sample)
+{
+  CountingAllocator allocator;
+  run_operation(
+    state, allocator, 0, [&sample, &allocator]() {
+      dynmsg::c::DynamicMessage message(sample.type_info, allocator.get());
+      benchmark::DoNotOptimize(message.data());
+    });
+}
+
+void c_to_yaml(benchmark::State & state, const Sample & sample)
+{
+  CountingAllocator allocator;
+  run_operation(
+    state, allocator, sample.yaml.size(), [&sample]() {
+      YAML::Node yaml = dynmsg::c::message_to_yaml(sample.message_c.get());
+      benchmark::DoNotOptimize(yaml);
+    });
+}
+
+void c_from_yaml(benchmark::State & state, const Sample & sample)
+{
+  // Parsing always creates a new message, which has to be destroyed
+  CountingAllocator allocator;
+  run_operation(
+    state, allocator, sample.yaml.size(), [&sample, &allocator]() {
+      rcutils_allocator_t message_allocator = allocator.get();
+      auto message = dynmsg::c::DynamicMessage::adopt(
+        dynmsg::c::yaml_and_typeinfo_to_rosmsg(
+          sample.type_info, sample.yaml, &message_allocator), message_allocator);
+      benchmark::DoNotOptimize(message.data());
+    });
+}
+
+void cpp_init_destroy(benchmark::State & state, const Sample & sample)
+{
+  CountingAllocator allocator;
+  run_operation(
+    state, allocator, 0, [&sample, &allocator]() {
+      dynmsg::cpp::DynamicMessage message(sample.type_info_cpp, allocator.get());
+      benchmark::DoNotOptimize(message.data());
+    });
+}
+
+void cpp_to_yaml(benchmark::State & state, const Sample & sample)
+{
+  CountingAllocator allocator;
+  run_operation(
+    state, allocator, sample.yaml.size(), [&sample]() {
+      YAML::Node yaml = dynmsg::cpp::message_to_yaml(sample.message_cpp.get());
+      benchmark::DoNotOptimize(yaml);
+    });
+}
+
+void cpp_from_yaml(benchmark::State & state, const Sample & sample)
+{
+  // Parsing into an existing message appends to its sequences, so each run needs a new message
+  CountingAllocator allocator;
+  run_operation(
+    state, allocator, sample.yaml.size(), [&sample, &allocator]() {
+      dynmsg::cpp::DynamicMessage message(sample.type_info_cpp, allocator.get());
+      dynmsg::cpp::yaml_and_typeinfo_to_rosmsg(sample.type_info_cpp, sample.yaml, message.data());
+      benchmark::DoNotOptimize(message.data());
+    });
+}
+
+struct Operation
+{
+  const char * name;
+  void (* run)(benchmark::State & state, const Sample & sample);
+};
+
+const Operation OPERATIONS[] = {
+  {"c/init+destroy", c_init_destroy},
+  {"c/to_yaml", c_to_yaml},
+  {"c/from_yaml+destroy", c_from_yaml},
+  {"cpp/init+destroy", cpp_init_destroy},
+  {"cpp/to_yaml", cpp_to_yaml},
+  {"cpp/from_yaml+destroy", cpp_from_yaml},
+};
+
+void register_benchmarks()
+{
+  for (const Operation & operation : OPERATIONS) {
+    for (const Shape & shape : SHAPES) {
+      const std::string name = std::string(operation.name) + "/" + shape.name;
+      auto * registered = benchmark::RegisterBenchmark(
+        name.c_str(), [operation, shape](benchmark::State & state) {
+          // Built outside of the timed loop of the operation
+          const Sample sample = shape.make(shape.is_sized ? state.range(0) : 0);
+          operation.run(state, sample);
+        });
+      if (shape.is_sized) {
+        registered->RangeMultiplier(16)->Range(16, 4096);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  register_benchmarks();
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,221 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the startup costs of dynmsg, for each of the given types:
+// - loading the introspection information of the type, in C and C++, cold (the first time in the
+//   process, which opens the type support library of its package if no type of that package was
+//   loaded before) and warm
+// - converting a message of the type to YAML, the first time and in the steady state
+// and the total time to prepare all the types, i.e. to load them and convert a first message of
+// each, which is what a program pays before its first conversion of each type.
+//
+// Cold costs can only be measured once per process, so this is a program rather than part of the
+// Google Benchmark suite; run it a few times to compare results. The first conversion of the first
+// type also includes the first-time costs of the process, e.g. of yaml-cpp.
+//
+// Usage: dynmsg_startup_benchmark [--repetitions N] [package/Type ...]
+
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/message_reading.hpp"
+#include "dynmsg/typesupport.hpp"
+
+namespace
+{
+
+// Types of a few packages, from flat to deeply nested
+const char * const DEFAULT_TYPES[] = {
+  "builtin_interfaces/Time",
+  "std_msgs/String",
+  "std_msgs/Header",
+  "test_msgs/BasicTypes",
+  "test_msgs/UnboundedSequences",
+  "test_msgs/MultiNested",
+  "rcl_interfaces/ParameterEvent",
+};
+
+// Time a function, in microseconds
+template<typename Function>
+double time_us(Function function)
+{
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  const auto duration = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// Parse "package/Type" or "package/msg/Type"
+bool parse_type(const std::string & name, InterfaceTypeName & interface_type)
+{
+  const size_t first = name.find('/');
+  const size_t last = name.rfind('/');
+  if (std::string::npos == first || 0u == first || name.size() - 1u == last ||
+    (first != last && name.substr(first, last - first + 1u) != "/msg/"))
+  {
+    return false;
+  }
+  interface_type = InterfaceTypeName(name.substr(0, first), name.substr(last + 1u));
+  return true;
+}
+
+// A type, with a message of it in both layouts, and its startup costs
+struct PreparedType
+{
+  std::string name;
+  InterfaceTypeName interface_type;
+  dynmsg::c::DynamicMessage message;
+  dynmsg::cpp::DynamicMessage message_cpp;
+  double cold_us;
+  double cold_cpp_us;
+  double first_to_yaml_us;
+  double first_to_yaml_cpp_us;
+  double warm_us;
+  double warm_cpp_us;
+  double steady_to_yaml_us;
+  double steady_to_yaml_cpp_us;
+};
+
+// Load a type and convert a first message of it
+bool prepare(PreparedType & type)
+{
+  const TypeInfo * type_info = nullptr;
+  const TypeInfo_Cpp * type_info_cpp = nullptr;
+  type.cold_us = time_us([&]() {type_info = dynmsg::c::get_type_info(type.interface_type);});
+  type.cold_cpp_us = time_us(
+    [&]() {type_info_cpp = dynmsg::cpp::get_type_info(type.interface_type);});
+  if (nullptr == type_info || nullptr == type_info_cpp) {
+    std::cerr << "failed to load the introspection information of " << type.name << std::endl;
+    return false;
+  }
+  type.message = dynmsg::c::DynamicMessage(type_info);
+  type.message_cpp = dynmsg::cpp::DynamicMessage(type_info_cpp);
+  type.first_to_yaml_us = time_us(
+    [&]() {YAML::Node yaml = dynmsg::c::message_to_yaml(type.message.get());});
+  type.first_to_yaml_cpp_us = time_us(
+    [&]() {YAML::Node yaml = dynmsg::cpp::message_to_yaml(type.message_cpp.get());});
+  return true;
+}
+
+// Measure the costs of a type that was already prepared, as the mean of some repetitions
+void measure_steady_state(PreparedType & type, size_t repetitions)
+{
+  const double count = static_cast<double>(repetitions);
+  type.warm_us = time_us(
+    [&]() {
+      for (size_t ii = 0; ii < repetitions; ++ii) {
+        dynmsg::c::get_type_info(type.interface_type);
+      }
+    }) / count;
+  type.warm_cpp_us = time_us(
+    [&]() {
+      for (size_t ii = 0; ii < repetitions; ++ii) {
+        dynmsg::cpp::get_type_info(type.interface_type);
+      }
+    }) / count;
+  type.steady_to_yaml_us = time_us(
+    [&]() {
+      for (size_t ii = 0; ii < repetitions; ++ii) {
+        YAML::Node yaml = dynmsg::c::message_to_yaml(type.message.get());
+      }
+    }) / count;
+  type.steady_to_yaml_cpp_us = time_us(
+    [&]() {
+      for (size_t ii = 0; ii < repetitions; ++ii) {
+        YAML::Node yaml = dynmsg::cpp::message_to_yaml(type.message_cpp.get());
+      }
+    }) / count;
+}
+
+void print_results(const std::vector<PreparedType> & types, double prepare_us)
+{
+  size_t name_width = 4u;
+  for (const auto & type : types) {
+    name_width = std::max(name_width, type.name.size());
+  }
+  std::cout << "times in microseconds\n" << std::left << std::setw(name_width + 2u) << "type" <<
+    std::right << std::setw(10) << "c cold" << std::setw(10) << "c warm" << std::setw(10) <<
+    "cpp cold" << std::setw(10) << "cpp warm" << std::setw(12) << "c 1st yaml" <<
+    std::setw(12) << "c yaml" << std::setw(14) << "cpp 1st yaml" << std::setw(12) << "cpp yaml" <<
+    '\n' << std::fixed << std::setprecision(2);
+  for (const auto & type : types) {
+    std::cout << std::left << std::setw(name_width + 2u) << type.name << std::right <<
+      std::setw(10) << type.cold_us << std::setw(10) << type.warm_us << std::setw(10) <<
+      type.cold_cpp_us << std::setw(10) << type.warm_cpp_us << std::setw(12) <<
+      type.first_to_yaml_us << std::setw(12) << type.steady_to_yaml_us << std::setw(14) <<
+      type.first_to_yaml_cpp_us << std::setw(12) << type.steady_to_yaml_cpp_us << '\n';
+  }
+  std::cout << "prepared " << types.size() << " types in " << prepare_us << " us\n";
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t repetitions = 1000u;
+  std::vector<std::string> names;
+  for (int ii = 1; ii < argc; ++ii) {
+    const std::string arg = argv[ii];
+    if ("--repetitions" == arg && ii + 1 < argc) {
+      repetitions = std::strtoul(argv[++ii], nullptr, 10);
+    } else if ("-h" == arg || "--help" == arg) {
+      std::cout << "usage: " << argv[0] << " [--repetitions N] [package/Type ...]\n";
+      return 0;
+    } else {
+      names.push_back(arg);
+    }
+  }
+  if (names.empty()) {
+    names.assign(std::begin(DEFAULT_TYPES), std::end(DEFAULT_TYPES));
+  }
+  if (0u == repetitions) {
+    std::cerr << "the number of repetitions must be positive" << std::endl;
+    return 1;
+  }
+
+  std::vector<PreparedType> types(names.size());
+  for (size_t ii = 0; ii < names.size(); ++ii) {
+    types[ii].name = names[ii];
+    if (!parse_type(names[ii], types[ii].interface_type)) {
+      std::cerr << "invalid type: " << names[ii] << " (expected package/Type)" << std::endl;
+      return 1;
+    }
+  }
+
+  // Cold costs first, before anything is loaded
+  bool prepared = true;
+  const double prepare_us = time_us(
+    [&]() {
+      for (auto & type : types) {
+        prepared = prepare(type) && prepared;
+      }
+    });
+  if (!prepared) {
+    return 1;
+  }
+  for (auto & type : types) {
+    measure_steady_state(type, repetitions);
+  }
+  print_results(types, prepare_us);
+  return 0;
+}
@@ -0,0 +1,119 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the ways of getting the size and the elements of the sequences of C++ messages:
+// - "layout": reading the std::vector directly, see vector_utils.hpp
+// - "introspection": calling the size_function and get_const_function of the members
+// - "member_utils": the functions of member_utils.hpp, which read the std::vector directly if its
+//   layout was verified, and call the introspection functions otherwise
+//
+// Each iteration gets the size and the first element of every sequence of a
+// test_msgs/UnboundedSequences message, except its std::vector<bool>.
+
+#include <benchmark/benchmark.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/member_utils.hpp"
+#include "dynmsg/message_generation.hpp"
+#include "dynmsg/typesupport.hpp"
+#include "dynmsg/vector_utils.hpp"
+
+#include "rosidl_typesupport_introspection_cpp/field_types.hpp"
+
+namespace
+{
+
+// A generated message whose sequences are not empty, with the sequences of its type
+struct Sequences
+{
+  Sequences()
+  : message({"test_msgs", "UnboundedSequences"})
+  {
+    dynmsg::GenerationOptions options;
+    options.min_sequence_length = options.max_sequence_length;
+    RosMessage_Cpp view = message.get();
+    dynmsg::cpp::generate_message(view, options);
+    const TypeInfo_Cpp * type_info = message.type_info();
+    for (uint32_t ii = 0; ii < type_info->member_count_; ++ii) {
+      const MemberInfo_Cpp & member = type_info->members_[ii];
+      if (dynmsg::cpp::is_sequence(member) &&
+        rosidl_typesupport_introspection_cpp::ROS_TYPE_BOOLEAN != member.type_id_)
+      {
+        members.push_back(&member);
+      }
+    }
+    if (members.empty()) {
+      throw std::runtime_error("no sequences to benchmark");
+    }
+  }
+
+  dynmsg::cpp::DynamicMessage message;
+  std::vector<const MemberInfo_Cpp *> members;
+};
+
+void layout(benchmark::State & state)
+{
+  const Sequences sequences;
+  if (!dynmsg::is_vector_layout_supported()) {
+    state.SkipWithError("the std::vector layout is not supported");
+    return;
+  }
+  for (auto _ : state) {
+    for (const MemberInfo_Cpp * member : sequences.members) {
+      const uint8_t * member_data = sequences.message.data() + member->offset_;
+      benchmark::DoNotOptimize(
+        dynmsg::get_vector_size(member_data, dynmsg::cpp::get_element_size(*member)));
+      benchmark::DoNotOptimize(dynmsg::get_vector_data(member_data));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(sequences.members.size()));
+}
+
+void introspection(benchmark::State & state)
+{
+  const Sequences sequences;
+  for (auto _ : state) {
+    for (const MemberInfo_Cpp * member : sequences.members) {
+      const uint8_t * member_data = sequences.message.data() + member->offset_;
+      const size_t size = member->size_function(member_data);
+      benchmark::DoNotOptimize(size);
+      if (0u != size) {
+        benchmark::DoNotOptimize(member->get_const_function(member_data, 0u));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(sequences.members.size()));
+}
+
+void member_utils(benchmark::State & state)
+{
+  const Sequences sequences;
+  for (auto _ : state) {
+    for (const MemberInfo_Cpp * member : sequences.members) {
+      const uint8_t * member_data = sequences.message.data() + member->offset_;
+      benchmark::DoNotOptimize(dynmsg::cpp::get_element_count(*member, member_data));
+      benchmark::DoNotOptimize(dynmsg::cpp::get_element_data(*member, member_data));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(sequences.members.size()));
+}
+
+}  // namespace
+
+BENCHMARK(layout)->Name("cpp/sequence_access/layout");
+BENCHMARK(introspection)->Name("cpp/sequence_access/introspection");
+BENCHMARK(member_utils)->Name("cpp/sequence_access/member_utils");
@@ -0,0 +1,109 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/typesupport.hpp"
+
+#include "test_msgs/msg/strings.h"
+#include "test_msgs/msg/strings.hpp"
+
+#include "rosidl_runtime_c/string_functions.h"
+
+namespace
+{
+
+// Allocator that counts the number of live allocations in its state
+void * counting_allocate(size_t size, void * state)
+{
+  ++*static_cast<int *>(state);
+  return std::malloc(size);
+}
+
+void counting_deallocate(void * pointer, void * state)
+{
+  --*static_cast<int *>(state);
+  std::free(pointer);
+}
+
+rcutils_allocator_t get_counting_allocator(int * live_allocations)
+{
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  allocator.allocate = counting_allocate;
+  allocator.deallocate = counting_deallocate;
+  allocator.state = live_allocations;
+  return allocator;
+}
+
+}  // namespace
+
+TEST(TestDynamicMessage, c_ownership)
+{
+  int live_allocations = 0;
+  const rcutils_allocator_t allocator = get_counting_allocator(&live_allocations);
+  {
+    std::vector<dynmsg::c::DynamicMessage> messages;
+    for (int i = 0; i < 3; ++i) {
+      messages.emplace_back(InterfaceTypeName{"test_msgs", "Strings"}, allocator);
+    }
+    EXPECT_EQ(3, live_allocations);
+    auto msg = reinterpret_cast<test_msgs__msg__Strings *>(messages[1].data());
+    ASSERT_TRUE(rosidl_runtime_c__String__assign(&msg->string_value, "hello"));
+
+    dynmsg::c::DynamicMessage moved = std::move(messages[1]);
+    EXPECT_FALSE(messages[1]);
+    ASSERT_TRUE(moved);
+    EXPECT_EQ(reinterpret_cast<uint8_t *>(msg), moved.data());
+    EXPECT_EQ(msg, reinterpret_cast<test_msgs__msg__Strings *>(moved.get().data));
+
+    messages[0] = std::move(moved);
+    EXPECT_EQ(2, live_allocations);
+  }
+  EXPECT_EQ(0, live_allocations);
+}
+
+TEST(TestDynamicMessage, cpp_release_adopt)
+{
+  int live_allocations = 0;
+  const rcutils_allocator_t allocator = get_counting_allocator(&live_allocations);
+  const TypeInfo_Cpp * type_info = dynmsg::cpp::get_type_info({"test_msgs", "Strings"});
+  ASSERT_NE(nullptr, type_info);
+
+  dynmsg::cpp::DynamicMessage message(type_info, allocator);
+  EXPECT_EQ(type_info, message.type_info());
+  reinterpret_cast<test_msgs::msg::Strings *>(message.data())->string_value = "hello";
+
+  RosMessage_Cpp released = message.release();
+  EXPECT_FALSE(message);
+  EXPECT_EQ(1, live_allocations);
+
+  auto adopted = dynmsg::cpp::DynamicMessage::adopt(released, allocator);
+  EXPECT_EQ("hello", reinterpret_cast<test_msgs::msg::Strings *>(adopted.data())->string_value);
+  adopted.reset();
+  EXPECT_FALSE(adopted);
+  EXPECT_EQ(0, live_allocations);
+}
+
+TEST(TestDynamicMessage, errors)
+{
+  EXPECT_THROW(
+    dynmsg::c::DynamicMessage(static_cast<const TypeInfo *>(nullptr)), std::runtime_error);
+  EXPECT_FALSE(dynmsg::cpp::DynamicMessage());
+}
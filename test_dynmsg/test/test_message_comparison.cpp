@@ -0,0 +1,173 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "dynmsg/message_comparison.hpp"
+#include "dynmsg/typesupport.hpp"
+
+#include "test_msgs/msg/nested.h"
+#include "test_msgs/msg/nested.hpp"
+#include "test_msgs/msg/unbounded_sequences.h"
+#include "test_msgs/msg/unbounded_sequences.hpp"
+
+#include "rosidl_runtime_c/primitives_sequence_functions.h"
+#include "rosidl_runtime_c/string_functions.h"
+
+TEST(TestMessageComparison, nested_c)
+{
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "Nested"});
+  ASSERT_NE(nullptr, type_info);
+  test_msgs__msg__Nested * msg_a = test_msgs__msg__Nested__create();
+  test_msgs__msg__Nested * msg_b = test_msgs__msg__Nested__create();
+  RosMessage a{type_info, reinterpret_cast<uint8_t *>(msg_a)};
+  RosMessage b{type_info, reinterpret_cast<uint8_t *>(msg_b)};
+
+  EXPECT_TRUE(dynmsg::c::equals(a, b));
+  EXPECT_TRUE(dynmsg::c::diff(a, b).empty());
+
+  msg_a->basic_types_value.int32_value = 42;
+  msg_b->basic_types_value.float64_value = 1.0;
+  msg_a->basic_types_value.float32_value = 1.0f;
+  msg_b->basic_types_value.float32_value = 1.0f + 1e-6f;
+  EXPECT_FALSE(dynmsg::c::equals(a, b));
+  const auto differences = dynmsg::c::diff(a, b);
+  ASSERT_EQ(3u, differences.size());
+  EXPECT_EQ("basic_types_value.float32_value", differences[0].path);
+  EXPECT_EQ("basic_types_value.float64_value", differences[1].path);
+  EXPECT_DOUBLE_EQ(0.0, differences[1].old_value.as<double>());
+  EXPECT_DOUBLE_EQ(1.0, differences[1].new_value.as<double>());
+  EXPECT_EQ("basic_types_value.int32_value", differences[2].path);
+  EXPECT_EQ(42, differences[2].old_value.as<int32_t>());
+  EXPECT_EQ(0, differences[2].new_value.as<int32_t>());
+
+  // Only the float32 difference is within tolerance
+  dynmsg::ComparisonOptions options;
+  options.float_tolerance = 1e-3;
+  EXPECT_EQ(2u, dynmsg::c::diff(a, b, options).size());
+  msg_a->basic_types_value.int32_value = 0;
+  msg_b->basic_types_value.float64_value = 0.0;
+  EXPECT_FALSE(dynmsg::c::equals(a, b));
+  EXPECT_TRUE(dynmsg::c::equals(a, b, options));
+
+  test_msgs__msg__Nested__destroy(msg_a);
+  test_msgs__msg__Nested__destroy(msg_b);
+}
+
+TEST(TestMessageComparison, nested_cpp)
+{
+  const TypeInfo_Cpp * type_info = dynmsg::cpp::get_type_info({"test_msgs", "Nested"});
+  ASSERT_NE(nullptr, type_info);
+  test_msgs::msg::Nested msg_a;
+  test_msgs::msg::Nested msg_b;
+  RosMessage_Cpp a{type_info, reinterpret_cast<uint8_t *>(&msg_a)};
+  RosMessage_Cpp b{type_info, reinterpret_cast<uint8_t *>(&msg_b)};
+
+  EXPECT_TRUE(dynmsg::cpp::equals(a, b));
+
+  msg_a.basic_types_value.uint64_value = 42u;
+  EXPECT_FALSE(dynmsg::cpp::equals(a, b));
+  const auto differences = dynmsg::cpp::diff(a, b);
+  ASSERT_EQ(1u, differences.size());
+  EXPECT_EQ("basic_types_value.uint64_value", differences[0].path);
+  EXPECT_EQ(42u, differences[0].old_value.as<uint64_t>());
+  EXPECT_EQ(0u, differences[0].new_value.as<uint64_t>());
+}
+
+TEST(TestMessageComparison, unbounded_sequences_c)
+{
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "UnboundedSequences"});
+  ASSERT_NE(nullptr, type_info);
+  test_msgs__msg__UnboundedSequences * msg_a = test_msgs__msg__UnboundedSequences__create();
+  test_msgs__msg__UnboundedSequences * msg_b = test_msgs__msg__UnboundedSequences__create();
+  RosMessage a{type_info, reinterpret_cast<uint8_t *>(msg_a)};
+  RosMessage b{type_info, reinterpret_cast<uint8_t *>(msg_b)};
+
+  rosidl_runtime_c__int32__Sequence__init(&msg_a->int32_values, 3);
+  rosidl_runtime_c__int32__Sequence__init(&msg_b->int32_values, 3);
+  rosidl_runtime_c__String__Sequence__init(&msg_a->string_values, 2);
+  rosidl_runtime_c__String__Sequence__init(&msg_b->string_values, 2);
+  rosidl_runtime_c__String__assign(&msg_a->string_values.data[1], "hello");
+  rosidl_runtime_c__String__assign(&msg_b->string_values.data[1], "hello");
+  EXPECT_TRUE(dynmsg::c::equals(a, b));
+
+  msg_b->int32_values.data[2] = 7;
+  rosidl_runtime_c__String__assign(&msg_b->string_values.data[0], "world");
+  rosidl_runtime_c__uint8__Sequence__init(&msg_a->uint8_values, 1);
+  EXPECT_FALSE(dynmsg::c::equals(a, b));
+  const auto differences = dynmsg::c::diff(a, b);
+  ASSERT_EQ(3u, differences.size());
+  EXPECT_EQ("uint8_values", differences[0].path);
+  EXPECT_EQ(1u, differences[0].old_value.size());
+  EXPECT_EQ(0u, differences[0].new_value.size());
+  EXPECT_EQ("int32_values[2]", differences[1].path);
+  EXPECT_EQ(7, differences[1].new_value.as<int32_t>());
+  EXPECT_EQ("string_values[0]", differences[2].path);
+  EXPECT_EQ("", differences[2].old_value.as<std::string>());
+  EXPECT_EQ("world", differences[2].new_value.as<std::string>());
+
+  test_msgs__msg__UnboundedSequences__destroy(msg_a);
+  test_msgs__msg__UnboundedSequences__destroy(msg_b);
+}
+
+TEST(TestMessageComparison, unbounded_sequences_cpp)
+{
+  const TypeInfo_Cpp * type_info =
+    dynmsg::cpp::get_type_info({"test_msgs", "UnboundedSequences"});
+  ASSERT_NE(nullptr, type_info);
+  test_msgs::msg::UnboundedSequences msg_a;
+  test_msgs::msg::UnboundedSequences msg_b;
+  RosMessage_Cpp a{type_info, reinterpret_cast<uint8_t *>(&msg_a)};
+  RosMessage_Cpp b{type_info, reinterpret_cast<uint8_t *>(&msg_b)};
+
+  msg_a.bool_values = {true, false, true};
+  msg_b.bool_values = {true, false, true};
+  msg_a.basic_types_values.resize(2);
+  msg_b.basic_types_values.resize(2);
+  EXPECT_TRUE(dynmsg::cpp::equals(a, b));
+
+  msg_b.bool_values[1] = true;
+  msg_b.basic_types_values[1].int16_value = -3;
+  msg_a.string_values = {"a", "b"};
+  EXPECT_FALSE(dynmsg::cpp::equals(a, b));
+  const auto differences = dynmsg::cpp::diff(a, b);
+  ASSERT_EQ(3u, differences.size());
+  EXPECT_EQ("bool_values[1]", differences[0].path);
+  EXPECT_FALSE(differences[0].old_value.as<bool>());
+  EXPECT_TRUE(differences[0].new_value.as<bool>());
+  EXPECT_EQ("string_values", differences[1].path);
+  EXPECT_EQ(2u, differences[1].old_value.size());
+  EXPECT_EQ("basic_types_values[1].int16_value", differences[2].path);
+  EXPECT_EQ(-3, differences[2].new_value.as<int16_t>());
+}
+
+TEST(TestMessageComparison, different_types)
+{
+  test_msgs__msg__Nested * msg_a = test_msgs__msg__Nested__create();
+  test_msgs__msg__UnboundedSequences * msg_b = test_msgs__msg__UnboundedSequences__create();
+  RosMessage a{
+    dynmsg::c::get_type_info({"test_msgs", "Nested"}), reinterpret_cast<uint8_t *>(msg_a)};
+  RosMessage b{
+    dynmsg::c::get_type_info({"test_msgs", "UnboundedSequences"}),
+    reinterpret_cast<uint8_t *>(msg_b)};
+
+  EXPECT_FALSE(dynmsg::c::equals(a, b));
+  EXPECT_THROW(dynmsg::c::diff(a, b), std::runtime_error);
+
+  test_msgs__msg__Nested__destroy(msg_a);
+  test_msgs__msg__UnboundedSequences__destroy(msg_b);
+}
@@ -0,0 +1,193 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "dynmsg/message_conversion.hpp"
+#include "dynmsg/typesupport.hpp"
+
+#include "test_msgs/msg/arrays.h"
+#include "test_msgs/msg/arrays.hpp"
+#include "test_msgs/msg/nested.h"
+#include "test_msgs/msg/nested.hpp"
+#include "test_msgs/msg/unbounded_sequences.h"
+#include "test_msgs/msg/unbounded_sequences.hpp"
+#include "test_msgs/msg/w_strings.h"
+#include "test_msgs/msg/w_strings.hpp"
+
+#include "rosidl_runtime_c/primitives_sequence_functions.h"
+#include "rosidl_runtime_c/string_functions.h"
+#include "rosidl_runtime_c/u16string_functions.h"
+
+TEST(TestMessageConversion, arrays)
+{
+  dynmsg::MessageConverter converter(
+    dynmsg::c::get_type_info({"test_msgs", "Arrays"}),
+    dynmsg::cpp::get_type_info({"test_msgs", "Arrays"}));
+  test_msgs__msg__Arrays * msg_c = test_msgs__msg__Arrays__create();
+  test_msgs::msg::Arrays msg_cpp;
+  RosMessage c{converter.type_info(), reinterpret_cast<uint8_t *>(msg_c)};
+  RosMessage_Cpp cpp{converter.type_info_cpp(), reinterpret_cast<uint8_t *>(&msg_cpp)};
+
+  msg_c->bool_values[1] = true;
+  msg_c->int32_values[2] = -42;
+  msg_c->float64_values[0] = 1.5;
+  rosidl_runtime_c__String__assign(&msg_c->string_values[1], "hello");
+  msg_c->basic_types_values[2].uint16_value = 7u;
+  converter.c_to_cpp(c, cpp);
+  EXPECT_TRUE(msg_cpp.bool_values[1]);
+  EXPECT_EQ(-42, msg_cpp.int32_values[2]);
+  EXPECT_DOUBLE_EQ(1.5, msg_cpp.float64_values[0]);
+  EXPECT_EQ("hello", msg_cpp.string_values[1]);
+  EXPECT_EQ(7u, msg_cpp.basic_types_values[2].uint16_value);
+
+  msg_cpp.string_values[0] = "world";
+  msg_cpp.uint8_values[1] = 3u;
+  converter.cpp_to_c(cpp, c);
+  EXPECT_STREQ("world", msg_c->string_values[0].data);
+  EXPECT_STREQ("hello", msg_c->string_values[1].data);
+  EXPECT_EQ(3u, msg_c->uint8_values[1]);
+  EXPECT_EQ(-42, msg_c->int32_values[2]);
+
+  test_msgs__msg__Arrays__destroy(msg_c);
+}
+
+TEST(TestMessageConversion, unbounded_sequences)
+{
+  dynmsg::MessageConverter converter(
+    dynmsg::c::get_type_info({"test_msgs", "UnboundedSequences"}),
+    dynmsg::cpp::get_type_info({"test_msgs", "UnboundedSequences"}));
+  test_msgs__msg__UnboundedSequences * msg_c = test_msgs__msg__UnboundedSequences__create();
+  test_msgs::msg::UnboundedSequences msg_cpp;
+  RosMessage c{converter.type_info(), reinterpret_cast<uint8_t *>(msg_c)};
+  RosMessage_Cpp cpp{converter.type_info_cpp(), reinterpret_cast<uint8_t *>(&msg_cpp)};
+
+  rosidl_runtime_c__boolean__Sequence__init(&msg_c->bool_values, 3);
+  msg_c->bool_values.data[2] = true;
+  rosidl_runtime_c__int64__Sequence__init(&msg_c->int64_values, 2);
+  msg_c->int64_values.data[1] = -5;
+  rosidl_runtime_c__String__Sequence__init(&msg_c->string_values, 1);
+  rosidl_runtime_c__String__assign(&msg_c->string_values.data[0], "hello");
+  msg_cpp.uint8_values = {1u, 2u, 3u};
+  msg_cpp.basic_types_values.resize(4);
+  dynmsg::c_to_cpp(c, cpp);
+  EXPECT_EQ((std::vector<bool>{false, false, true}), msg_cpp.bool_values);
+  EXPECT_EQ((std::vector<int64_t>{0, -5}), msg_cpp.int64_values);
+  EXPECT_EQ((std::vector<std::string>{"hello"}), msg_cpp.string_values);
+  EXPECT_TRUE(msg_cpp.uint8_values.empty());
+  EXPECT_TRUE(msg_cpp.basic_types_values.empty());
+
+  msg_cpp.bool_values = {true};
+  msg_cpp.basic_types_values.resize(2);
+  msg_cpp.basic_types_values[1].int8_value = -1;
+  msg_cpp.string_values.clear();
+  dynmsg::cpp_to_c(cpp, c);
+  ASSERT_EQ(1u, msg_c->bool_values.size);
+  EXPECT_TRUE(msg_c->bool_values.data[0]);
+  ASSERT_EQ(2u, msg_c->basic_types_values.size);
+  EXPECT_EQ(-1, msg_c->basic_types_values.data[1].int8_value);
+  EXPECT_EQ(0u, msg_c->string_values.size);
+  EXPECT_EQ(2u, msg_c->int64_values.size);
+
+  test_msgs__msg__UnboundedSequences__destroy(msg_c);
+}
+
+namespace
+{
+
+std::u16string to_u16string(const rosidl_runtime_c__U16String & string)
+{
+  return std::u16string(reinterpret_cast<const char16_t *>(string.data), string.size);
+}
+
+void assign(rosidl_runtime_c__U16String & string, const std::u16string & value)
+{
+  ASSERT_TRUE(
+    rosidl_runtime_c__U16String__assignn(
+      &string, reinterpret_cast<const uint16_t *>(value.data()), value.size()));
+}
+
+}  // namespace
+
+TEST(TestMessageConversion, wstrings)
+{
+  // The UTF-16 code units are copied as they are, including characters outside of ASCII and Latin-1
+  const std::u16string latin = u"Hell\u00f6 w\u00f6rld";
+  const std::u16string katakana = u"\u30cf\u30ed\u30fc\u30ef\u30fc\u30eb\u30c9";
+  const std::u16string symbols = u"\u2211 \u2260 \uffe5";
+  dynmsg::MessageConverter converter(
+    dynmsg::c::get_type_info({"test_msgs", "WStrings"}),
+    dynmsg::cpp::get_type_info({"test_msgs", "WStrings"}));
+  test_msgs__msg__WStrings * msg_c = test_msgs__msg__WStrings__create();
+  test_msgs::msg::WStrings msg_cpp;
+  RosMessage c{converter.type_info(), reinterpret_cast<uint8_t *>(msg_c)};
+  RosMessage_Cpp cpp{converter.type_info_cpp(), reinterpret_cast<uint8_t *>(&msg_cpp)};
+
+  assign(msg_c->wstring_value, katakana);
+  assign(msg_c->array_of_wstrings[1], latin);
+  ASSERT_TRUE(
+    rosidl_runtime_c__U16String__Sequence__init(&msg_c->bounded_sequence_of_wstrings, 2));
+  assign(msg_c->bounded_sequence_of_wstrings.data[1], symbols);
+  ASSERT_TRUE(
+    rosidl_runtime_c__U16String__Sequence__init(&msg_c->unbounded_sequence_of_wstrings, 3));
+  assign(msg_c->unbounded_sequence_of_wstrings.data[0], katakana);
+  assign(msg_c->unbounded_sequence_of_wstrings.data[2], latin);
+  converter.c_to_cpp(c, cpp);
+  EXPECT_EQ(katakana, msg_cpp.wstring_value);
+  EXPECT_EQ(u"", msg_cpp.array_of_wstrings[0]);
+  EXPECT_EQ(latin, msg_cpp.array_of_wstrings[1]);
+  ASSERT_EQ(2u, msg_cpp.bounded_sequence_of_wstrings.size());
+  EXPECT_EQ(u"", msg_cpp.bounded_sequence_of_wstrings[0]);
+  EXPECT_EQ(symbols, msg_cpp.bounded_sequence_of_wstrings[1]);
+  EXPECT_EQ(
+    (std::vector<std::u16string>{katakana, u"", latin}), msg_cpp.unbounded_sequence_of_wstrings);
+
+  msg_cpp.wstring_value = symbols;
+  msg_cpp.array_of_wstrings[2] = katakana;
+  msg_cpp.bounded_sequence_of_wstrings = {latin};
+  msg_cpp.unbounded_sequence_of_wstrings.clear();
+  converter.cpp_to_c(cpp, c);
+  EXPECT_EQ(symbols, to_u16string(msg_c->wstring_value));
+  EXPECT_EQ(latin, to_u16string(msg_c->array_of_wstrings[1]));
+  EXPECT_EQ(katakana, to_u16string(msg_c->array_of_wstrings[2]));
+  ASSERT_EQ(1u, msg_c->bounded_sequence_of_wstrings.size);
+  EXPECT_EQ(latin, to_u16string(msg_c->bounded_sequence_of_wstrings.data[0]));
+  EXPECT_EQ(0u, msg_c->unbounded_sequence_of_wstrings.size);
+
+  test_msgs__msg__WStrings__destroy(msg_c);
+}
+
+TEST(TestMessageConversion, mismatched_types)
+{
+  EXPECT_THROW(
+    dynmsg::MessageConverter(
+      dynmsg::c::get_type_info({"test_msgs", "Nested"}),
+      dynmsg::cpp::get_type_info({"test_msgs", "Arrays"})),
+    std::runtime_error);
+
+  dynmsg::MessageConverter converter(
+    dynmsg::c::get_type_info({"test_msgs", "Nested"}),
+    dynmsg::cpp::get_type_info({"test_msgs", "Nested"}));
+  test_msgs__msg__Arrays * msg_c = test_msgs__msg__Arrays__create();
+  test_msgs::msg::Nested msg_cpp;
+  RosMessage c{
+    dynmsg::c::get_type_info({"test_msgs", "Arrays"}), reinterpret_cast<uint8_t *>(msg_c)};
+  RosMessage_Cpp cpp{converter.type_info_cpp(), reinterpret_cast<uint8_t *>(&msg_cpp)};
+  EXPECT_THROW(converter.c_to_cpp(c, cpp), std::runtime_error);
+  test_msgs__msg__Arrays__destroy(msg_c);
+}
@@ -0,0 +1,161 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/member_utils.hpp"
+#include "dynmsg/message_comparison.hpp"
+#include "dynmsg/message_conversion.hpp"
+#include "dynmsg/message_generation.hpp"
+#include "dynmsg/typesupport.hpp"
+
+#include "test_msgs/msg/strings.h"
+#include "test_msgs/msg/unbounded_sequences.h"
+#include "test_msgs/msg/unbounded_sequences.hpp"
+
+#include "rosidl_typesupport_introspection_c/field_types.h"
+
+// Check that the sequences of a message and of its nested messages are within their bounds
+void expect_within_bounds(const TypeInfo * type_info, const uint8_t * data)
+{
+  for (uint32_t ii = 0; ii < type_info->member_count_; ++ii) {
+    const MemberInfo & member = type_info->members_[ii];
+    const uint8_t * member_data = data + member.offset_;
+    const size_t count = dynmsg::c::get_element_count(member, member_data);
+    if (member.is_upper_bound_) {
+      EXPECT_LE(count, member.array_size_) << member.name_;
+    }
+    if (rosidl_typesupport_introspection_c__ROS_TYPE_MESSAGE == member.type_id_) {
+      const TypeInfo * nested = dynmsg::c::get_nested_type_info(member);
+      const uint8_t * elements = dynmsg::c::get_element_data(member, member_data);
+      for (size_t jj = 0; jj < count; ++jj) {
+        expect_within_bounds(nested, elements + jj * nested->size_of_);
+      }
+    }
+  }
+}
+
+TEST(TestMessageGeneration, deterministic)
+{
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "UnboundedSequences"});
+  ASSERT_NE(nullptr, type_info);
+  dynmsg::c::DynamicMessage a(type_info);
+  dynmsg::c::DynamicMessage b(type_info);
+  dynmsg::c::DynamicMessage c(type_info);
+  RosMessage a_view = a.get();
+  RosMessage b_view = b.get();
+  RosMessage c_view = c.get();
+
+  dynmsg::GenerationOptions options;
+  options.seed = 42;
+  dynmsg::c::generate_message(a_view, options);
+  dynmsg::c::generate_message(b_view, options);
+  options.seed = 43;
+  dynmsg::c::generate_message(c_view, options);
+  EXPECT_TRUE(dynmsg::c::equals(a.get(), b.get()));
+  EXPECT_FALSE(dynmsg::c::equals(a.get(), c.get()));
+
+  // Generating again replaces the previous content
+  options.seed = 42;
+  dynmsg::c::generate_message(c_view, options);
+  EXPECT_TRUE(dynmsg::c::equals(a.get(), c.get()));
+}
+
+TEST(TestMessageGeneration, same_content_in_c_and_cpp)
+{
+  const InterfaceTypeName interface{"test_msgs", "MultiNested"};
+  const TypeInfo * type_info = dynmsg::c::get_type_info(interface);
+  const TypeInfo_Cpp * type_info_cpp = dynmsg::cpp::get_type_info(interface);
+  ASSERT_NE(nullptr, type_info);
+  ASSERT_NE(nullptr, type_info_cpp);
+  dynmsg::c::DynamicMessage message(type_info);
+  dynmsg::cpp::DynamicMessage message_cpp(type_info_cpp);
+  dynmsg::cpp::DynamicMessage converted(type_info_cpp);
+  RosMessage view = message.get();
+  RosMessage_Cpp view_cpp = message_cpp.get();
+  RosMessage_Cpp converted_view = converted.get();
+
+  dynmsg::GenerationOptions options;
+  options.seed = 7;
+  dynmsg::c::generate_message(view, options);
+  dynmsg::cpp::generate_message(view_cpp, options);
+  dynmsg::c_to_cpp(view, converted_view);
+  EXPECT_TRUE(dynmsg::cpp::equals(message_cpp.get(), converted.get()));
+}
+
+TEST(TestMessageGeneration, lengths)
+{
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "UnboundedSequences"});
+  const TypeInfo_Cpp * type_info_cpp =
+    dynmsg::cpp::get_type_info({"test_msgs", "UnboundedSequences"});
+  ASSERT_NE(nullptr, type_info);
+  ASSERT_NE(nullptr, type_info_cpp);
+  dynmsg::c::DynamicMessage message(type_info);
+  dynmsg::cpp::DynamicMessage message_cpp(type_info_cpp);
+  RosMessage view = message.get();
+  RosMessage_Cpp view_cpp = message_cpp.get();
+
+  dynmsg::GenerationOptions options;
+  options.min_sequence_length = 5;
+  options.max_sequence_length = 5;
+  options.min_string_length = 3;
+  options.max_string_length = 3;
+  dynmsg::c::generate_message(view, options);
+  dynmsg::cpp::generate_message(view_cpp, options);
+
+  const auto msg = reinterpret_cast<const test_msgs__msg__UnboundedSequences *>(message.data());
+  EXPECT_EQ(5u, msg->bool_values.size);
+  EXPECT_EQ(5u, msg->int64_values.size);
+  EXPECT_EQ(5u, msg->basic_types_values.size);
+  ASSERT_EQ(5u, msg->string_values.size);
+  for (size_t ii = 0; ii < msg->string_values.size; ++ii) {
+    EXPECT_EQ(3u, msg->string_values.data[ii].size);
+  }
+  const auto msg_cpp = reinterpret_cast<const test_msgs::msg::UnboundedSequences *>(
+    message_cpp.data());
+  EXPECT_EQ(5u, msg_cpp->bool_values.size());
+  EXPECT_EQ(5u, msg_cpp->float32_values.size());
+  EXPECT_EQ(5u, msg_cpp->defaults_values.size());
+  ASSERT_EQ(5u, msg_cpp->string_values.size());
+  EXPECT_EQ(3u, msg_cpp->string_values[0].size());
+}
+
+TEST(TestMessageGeneration, bounds)
+{
+  dynmsg::GenerationOptions options;
+  options.min_sequence_length = 100;
+  options.max_sequence_length = 100;
+  options.min_string_length = 100;
+  options.max_string_length = 100;
+
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "MultiNested"});
+  ASSERT_NE(nullptr, type_info);
+  dynmsg::c::DynamicMessage message(type_info);
+  RosMessage view = message.get();
+  for (uint64_t seed = 0; seed < 2; ++seed) {
+    options.seed = seed;
+    dynmsg::c::generate_message(view, options);
+    expect_within_bounds(type_info, message.data());
+  }
+
+  const TypeInfo * strings_type_info = dynmsg::c::get_type_info({"test_msgs", "Strings"});
+  ASSERT_NE(nullptr, strings_type_info);
+  dynmsg::c::DynamicMessage strings(strings_type_info);
+  RosMessage strings_view = strings.get();
+  dynmsg::c::generate_message(strings_view, options);
+  const auto msg = reinterpret_cast<const test_msgs__msg__Strings *>(strings.data());
+  EXPECT_EQ(100u, msg->string_value.size);
+  EXPECT_EQ(22u, msg->bounded_string_value.size);
+}
@@ -0,0 +1,133 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "dynmsg/message_hashing.hpp"
+#include "dynmsg/typesupport.hpp"
+
+#include "test_msgs/msg/basic_types.h"
+#include "test_msgs/msg/basic_types.hpp"
+#include "test_msgs/msg/nested.h"
+#include "test_msgs/msg/nested.hpp"
+#include "test_msgs/msg/unbounded_sequences.h"
+#include "test_msgs/msg/unbounded_sequences.hpp"
+
+#include "rosidl_runtime_c/primitives_sequence_functions.h"
+#include "rosidl_runtime_c/string_functions.h"
+
+// The hashes must not change across processes and versions, as they can be used as cache keys.
+// The expected values are the XXH64 of the fields of the message, in order and without padding:
+//   struct.pack('<?BBfdbBhHiIqQ', True, 0x12, 65, 1.5, -2.25, -3, 200, -300, 60000, -70000,
+//     3000000000, -5000000000000, 2**63 + 5)
+// computed with the reference implementation (Python xxhash), for little-endian machines.
+TEST(TestMessageHashing, known_answers)
+{
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "BasicTypes"});
+  const TypeInfo_Cpp * type_info_cpp = dynmsg::cpp::get_type_info({"test_msgs", "BasicTypes"});
+  ASSERT_NE(nullptr, type_info);
+  ASSERT_NE(nullptr, type_info_cpp);
+  test_msgs__msg__BasicTypes msg_c;
+  ASSERT_TRUE(test_msgs__msg__BasicTypes__init(&msg_c));
+  test_msgs::msg::BasicTypes msg_cpp;
+  msg_c.bool_value = msg_cpp.bool_value = true;
+  msg_c.byte_value = msg_cpp.byte_value = 0x12;
+  msg_c.char_value = msg_cpp.char_value = 65;
+  msg_c.float32_value = msg_cpp.float32_value = 1.5f;
+  msg_c.float64_value = msg_cpp.float64_value = -2.25;
+  msg_c.int8_value = msg_cpp.int8_value = -3;
+  msg_c.uint8_value = msg_cpp.uint8_value = 200u;
+  msg_c.int16_value = msg_cpp.int16_value = -300;
+  msg_c.uint16_value = msg_cpp.uint16_value = 60000u;
+  msg_c.int32_value = msg_cpp.int32_value = -70000;
+  msg_c.uint32_value = msg_cpp.uint32_value = 3000000000u;
+  msg_c.int64_value = msg_cpp.int64_value = -5000000000000ll;
+  msg_c.uint64_value = msg_cpp.uint64_value = 9223372036854775813ull;
+  RosMessage c{type_info, reinterpret_cast<uint8_t *>(&msg_c)};
+  RosMessage_Cpp cpp{type_info_cpp, reinterpret_cast<uint8_t *>(&msg_cpp)};
+
+  EXPECT_EQ(0x506a5d2fdb5eb963ull, dynmsg::c::hash_message(c));
+  EXPECT_EQ(0x506a5d2fdb5eb963ull, dynmsg::cpp::hash_message(cpp));
+  EXPECT_EQ(0x7244fea0f73e16f2ull, dynmsg::c::hash_message(c, 42u));
+  // The second half of 128-bit hashes uses the seed plus 0x9E3779B97F4A7C15
+  const dynmsg::Hash128 hash_128 = dynmsg::c::hash_message_128(c, 42u);
+  EXPECT_EQ(0x7244fea0f73e16f2ull, hash_128.low);
+  EXPECT_EQ(0x6ee7a2350a362b50ull, hash_128.high);
+  EXPECT_EQ(hash_128, dynmsg::cpp::hash_message_128(cpp, 42u));
+
+  test_msgs__msg__BasicTypes__fini(&msg_c);
+}
+
+TEST(TestMessageHashing, nested)
+{
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "Nested"});
+  const TypeInfo_Cpp * type_info_cpp = dynmsg::cpp::get_type_info({"test_msgs", "Nested"});
+  ASSERT_NE(nullptr, type_info);
+  ASSERT_NE(nullptr, type_info_cpp);
+  test_msgs__msg__Nested * msg_c = test_msgs__msg__Nested__create();
+  test_msgs::msg::Nested msg_cpp;
+  RosMessage c{type_info, reinterpret_cast<uint8_t *>(msg_c)};
+  RosMessage_Cpp cpp{type_info_cpp, reinterpret_cast<uint8_t *>(&msg_cpp)};
+
+  const uint64_t initial_hash = dynmsg::c::hash_message(c);
+  EXPECT_EQ(initial_hash, dynmsg::cpp::hash_message(cpp));
+  EXPECT_NE(initial_hash, dynmsg::c::hash_message(c, 42u));
+
+  msg_c->basic_types_value.int64_value = -7;
+  msg_c->basic_types_value.float64_value = 1.5;
+  msg_cpp.basic_types_value.int64_value = -7;
+  msg_cpp.basic_types_value.float64_value = 1.5;
+  const uint64_t hash = dynmsg::c::hash_message(c);
+  EXPECT_NE(initial_hash, hash);
+  EXPECT_EQ(hash, dynmsg::cpp::hash_message(cpp));
+
+  const dynmsg::Hash128 hash_128 = dynmsg::c::hash_message_128(c);
+  EXPECT_EQ(hash, hash_128.low);
+  EXPECT_NE(hash_128.low, hash_128.high);
+  EXPECT_EQ(hash_128, dynmsg::cpp::hash_message_128(cpp));
+
+  test_msgs__msg__Nested__destroy(msg_c);
+}
+
+TEST(TestMessageHashing, unbounded_sequences)
+{
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "UnboundedSequences"});
+  const TypeInfo_Cpp * type_info_cpp =
+    dynmsg::cpp::get_type_info({"test_msgs", "UnboundedSequences"});
+  ASSERT_NE(nullptr, type_info);
+  ASSERT_NE(nullptr, type_info_cpp);
+  test_msgs__msg__UnboundedSequences * msg_c = test_msgs__msg__UnboundedSequences__create();
+  test_msgs::msg::UnboundedSequences msg_cpp;
+  RosMessage c{type_info, reinterpret_cast<uint8_t *>(msg_c)};
+  RosMessage_Cpp cpp{type_info_cpp, reinterpret_cast<uint8_t *>(&msg_cpp)};
+
+  rosidl_runtime_c__boolean__Sequence__init(&msg_c->bool_values, 3);
+  msg_c->bool_values.data[1] = true;
+  msg_cpp.bool_values = {false, true, false};
+  rosidl_runtime_c__String__Sequence__init(&msg_c->string_values, 2);
+  rosidl_runtime_c__String__assign(&msg_c->string_values.data[0], "hello");
+  msg_cpp.string_values = {"hello", ""};
+  const uint64_t hash = dynmsg::c::hash_message(c);
+  EXPECT_EQ(hash, dynmsg::cpp::hash_message(cpp));
+
+  // Moving a string boundary changes the hash
+  rosidl_runtime_c__String__assign(&msg_c->string_values.data[0], "hell");
+  rosidl_runtime_c__String__assign(&msg_c->string_values.data[1], "o");
+  EXPECT_NE(hash, dynmsg::c::hash_message(c));
+
+  msg_cpp.bool_values.push_back(false);
+  EXPECT_NE(hash, dynmsg::cpp::hash_message(cpp));
+
+  test_msgs__msg__UnboundedSequences__destroy(msg_c);
+}
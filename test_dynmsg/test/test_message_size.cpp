@@ -0,0 +1,265 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/message_generation.hpp"
+#include "dynmsg/message_size.hpp"
+#include "dynmsg/typesupport.hpp"
+
+#include "test_msgs/msg/arrays.h"
+#include "test_msgs/msg/arrays.hpp"
+#include "test_msgs/msg/basic_types.h"
+#include "test_msgs/msg/basic_types.hpp"
+#include "test_msgs/msg/bounded_sequences.h"
+#include "test_msgs/msg/bounded_sequences.hpp"
+#include "test_msgs/msg/multi_nested.h"
+#include "test_msgs/msg/multi_nested.hpp"
+#include "test_msgs/msg/nested.h"
+#include "test_msgs/msg/nested.hpp"
+#include "test_msgs/msg/strings.h"
+#include "test_msgs/msg/strings.hpp"
+#include "test_msgs/msg/unbounded_sequences.h"
+#include "test_msgs/msg/unbounded_sequences.hpp"
+#include "test_msgs/msg/w_strings.h"
+#include "test_msgs/msg/w_strings.hpp"
+
+#include "rcutils/allocator.h"
+#include "rmw/rmw.h"
+#include "rmw/serialized_message.h"
+#include "rosidl_runtime_c/primitives_sequence_functions.h"
+#include "rosidl_typesupport_cpp/message_type_support.hpp"
+
+// Serialized size of test_msgs/msg/BasicTypes, with the alignment of each member
+constexpr size_t BASIC_TYPES_SERIALIZED_SIZE = dynmsg::CDR_ENCAPSULATION_SIZE + 48u;
+
+TEST(TestMessageSize, basic_types)
+{
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "BasicTypes"});
+  const TypeInfo_Cpp * type_info_cpp = dynmsg::cpp::get_type_info({"test_msgs", "BasicTypes"});
+  ASSERT_NE(nullptr, type_info);
+  ASSERT_NE(nullptr, type_info_cpp);
+
+  const dynmsg::SerializedSizeInfo info = dynmsg::c::get_serialized_size_info(type_info);
+  EXPECT_TRUE(info.is_fixed);
+  EXPECT_TRUE(info.is_bounded);
+  EXPECT_EQ(BASIC_TYPES_SERIALIZED_SIZE, info.max_size);
+  const dynmsg::SerializedSizeInfo info_cpp = dynmsg::cpp::get_serialized_size_info(type_info_cpp);
+  EXPECT_TRUE(info_cpp.is_fixed);
+  EXPECT_EQ(info.max_size, info_cpp.max_size);
+
+  test_msgs__msg__BasicTypes * msg_c = test_msgs__msg__BasicTypes__create();
+  test_msgs::msg::BasicTypes msg_cpp;
+  RosMessage c{type_info, reinterpret_cast<uint8_t *>(msg_c)};
+  RosMessage_Cpp cpp{type_info_cpp, reinterpret_cast<uint8_t *>(&msg_cpp)};
+  EXPECT_EQ(BASIC_TYPES_SERIALIZED_SIZE, dynmsg::c::serialized_size(c));
+  EXPECT_EQ(BASIC_TYPES_SERIALIZED_SIZE, dynmsg::cpp::serialized_size(cpp));
+  EXPECT_EQ(0u, dynmsg::c::heap_bytes(c));
+  EXPECT_EQ(0u, dynmsg::cpp::heap_bytes(cpp));
+  test_msgs__msg__BasicTypes__destroy(msg_c);
+}
+
+TEST(TestMessageSize, unbounded_sequences)
+{
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "UnboundedSequences"});
+  const TypeInfo_Cpp * type_info_cpp =
+    dynmsg::cpp::get_type_info({"test_msgs", "UnboundedSequences"});
+  ASSERT_NE(nullptr, type_info);
+  ASSERT_NE(nullptr, type_info_cpp);
+
+  const dynmsg::SerializedSizeInfo info = dynmsg::c::get_serialized_size_info(type_info);
+  EXPECT_FALSE(info.is_fixed);
+  EXPECT_FALSE(info.is_bounded);
+  EXPECT_FALSE(dynmsg::cpp::get_serialized_size_info(type_info_cpp).is_bounded);
+
+  test_msgs__msg__UnboundedSequences * msg_c = test_msgs__msg__UnboundedSequences__create();
+  test_msgs::msg::UnboundedSequences msg_cpp;
+  RosMessage c{type_info, reinterpret_cast<uint8_t *>(msg_c)};
+  RosMessage_Cpp cpp{type_info_cpp, reinterpret_cast<uint8_t *>(&msg_cpp)};
+
+  // Each empty sequence is only its length, and the last member is an int32
+  const size_t empty_size = dynmsg::CDR_ENCAPSULATION_SIZE + 4u * type_info->member_count_;
+  EXPECT_EQ(empty_size, dynmsg::c::serialized_size(c));
+  EXPECT_EQ(empty_size, dynmsg::cpp::serialized_size(cpp));
+  EXPECT_EQ(0u, dynmsg::c::heap_bytes(c));
+
+  // 3 bytes of booleans, followed by padding for the length of the next sequence
+  rosidl_runtime_c__boolean__Sequence__init(&msg_c->bool_values, 3);
+  msg_cpp.bool_values = {true, false, true};
+  EXPECT_EQ(empty_size + 4u, dynmsg::c::serialized_size(c));
+  EXPECT_EQ(empty_size + 4u, dynmsg::cpp::serialized_size(cpp));
+  EXPECT_EQ(3u, dynmsg::c::heap_bytes(c));
+
+  msg_cpp.string_values = {"a string that does not fit in the short string buffer"};
+  msg_cpp.basic_types_values.reserve(4);
+  EXPECT_LT(
+    4u * sizeof(test_msgs::msg::BasicTypes) + msg_cpp.string_values[0].size(),
+    dynmsg::cpp::heap_bytes(cpp));
+
+  test_msgs__msg__UnboundedSequences__destroy(msg_c);
+}
+
+// The sizes are the ones of Fast-CDR, e.g. 4 bytes per wchar, which other rmw implementations do
+// not necessarily use
+bool uses_fast_cdr()
+{
+  const std::string implementation = rmw_get_implementation_identifier();
+  return 0u == implementation.rfind("rmw_fastrtps", 0);
+}
+
+// Size of the buffer filled by rmw_serialize() for the given message
+size_t rmw_serialized_size(const void * message, const rosidl_message_type_support_t * type_support)
+{
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  rmw_serialized_message_t buffer = rmw_get_zero_initialized_serialized_message();
+  EXPECT_EQ(RMW_RET_OK, rmw_serialized_message_init(&buffer, 0u, &allocator));
+  EXPECT_EQ(RMW_RET_OK, rmw_serialize(message, type_support, &buffer));
+  const size_t size = buffer.buffer_length;
+  EXPECT_EQ(RMW_RET_OK, rmw_serialized_message_fini(&buffer));
+  return size;
+}
+
+// A test_msgs type, with the type supports used by rmw_serialize() for its C and C++ messages
+struct SerializableType
+{
+  std::string name;
+  const rosidl_message_type_support_t * type_support;
+  const rosidl_message_type_support_t * type_support_cpp;
+};
+
+class TestMessageSizeRmw : public ::testing::TestWithParam<SerializableType>
+{
+protected:
+  void SetUp() override
+  {
+    if (!uses_fast_cdr()) {
+      GTEST_SKIP() << "not a Fast-CDR rmw implementation: " << rmw_get_implementation_identifier();
+    }
+  }
+
+  void expect_rmw_sizes(const RosMessage & c, const RosMessage_Cpp & cpp)
+  {
+    EXPECT_EQ(rmw_serialized_size(c.data, GetParam().type_support), dynmsg::c::serialized_size(c));
+    EXPECT_EQ(
+      rmw_serialized_size(cpp.data, GetParam().type_support_cpp),
+      dynmsg::cpp::serialized_size(cpp));
+  }
+};
+
+// Generated messages with empty and non-empty sequences and strings, up to the bounds of the bounded
+// ones, and with nested messages in sequences and arrays
+TEST_P(TestMessageSizeRmw, generated_messages)
+{
+  const InterfaceTypeName interface_type{"test_msgs", GetParam().name};
+  dynmsg::c::DynamicMessage message_c(interface_type);
+  dynmsg::cpp::DynamicMessage message_cpp(interface_type);
+  const dynmsg::SerializedSizeInfo info =
+    dynmsg::c::get_serialized_size_info(message_c.type_info());
+  for (uint64_t seed = 0u; seed < 16u; ++seed) {
+    dynmsg::GenerationOptions options;
+    options.seed = seed;
+    RosMessage c = message_c.get();
+    RosMessage_Cpp cpp = message_cpp.get();
+    dynmsg::c::generate_message(c, options);
+    dynmsg::cpp::generate_message(cpp, options);
+    expect_rmw_sizes(c, cpp);
+    if (info.is_bounded) {
+      EXPECT_GE(info.max_size, dynmsg::c::serialized_size(c));
+    }
+    if (info.is_fixed) {
+      EXPECT_EQ(info.max_size, dynmsg::c::serialized_size(c));
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  TestMessageSize,
+  TestMessageSizeRmw,
+  ::testing::Values(
+    SerializableType{
+      "Arrays",
+      ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Arrays),
+      rosidl_typesupport_cpp::get_message_type_support_handle<test_msgs::msg::Arrays>()},
+    SerializableType{
+      "BasicTypes",
+      ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BasicTypes),
+      rosidl_typesupport_cpp::get_message_type_support_handle<test_msgs::msg::BasicTypes>()},
+    SerializableType{
+      "BoundedSequences",
+      ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, BoundedSequences),
+      rosidl_typesupport_cpp::get_message_type_support_handle<test_msgs::msg::BoundedSequences>()},
+    SerializableType{
+      "MultiNested",
+      ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, MultiNested),
+      rosidl_typesupport_cpp::get_message_type_support_handle<test_msgs::msg::MultiNested>()},
+    SerializableType{
+      "Nested",
+      ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Nested),
+      rosidl_typesupport_cpp::get_message_type_support_handle<test_msgs::msg::Nested>()},
+    SerializableType{
+      "Strings",
+      ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, Strings),
+      rosidl_typesupport_cpp::get_message_type_support_handle<test_msgs::msg::Strings>()},
+    SerializableType{
+      "UnboundedSequences",
+      ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, UnboundedSequences),
+      rosidl_typesupport_cpp::get_message_type_support_handle<
+        test_msgs::msg::UnboundedSequences>()},
+    SerializableType{
+      "WStrings",
+      ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, WStrings),
+      rosidl_typesupport_cpp::get_message_type_support_handle<test_msgs::msg::WStrings>()}),
+  [](const ::testing::TestParamInfo<SerializableType> & info) {return info.param.name;});
+
+// Empty sequences of 8-byte elements after a sequence of bytes, at offsets that are not multiples
+// of 8: Fast-CDR does not align the elements of empty sequences, and neither does serialized_size()
+TEST(TestMessageSize, empty_sequences_match_rmw)
+{
+  if (!uses_fast_cdr()) {
+    GTEST_SKIP() << "not a Fast-CDR rmw implementation: " << rmw_get_implementation_identifier();
+  }
+  const TypeInfo * type_info = dynmsg::c::get_type_info({"test_msgs", "UnboundedSequences"});
+  const TypeInfo_Cpp * type_info_cpp =
+    dynmsg::cpp::get_type_info({"test_msgs", "UnboundedSequences"});
+  ASSERT_NE(nullptr, type_info);
+  ASSERT_NE(nullptr, type_info_cpp);
+
+  test_msgs__msg__UnboundedSequences * msg_c = test_msgs__msg__UnboundedSequences__create();
+  test_msgs::msg::UnboundedSequences msg_cpp;
+  RosMessage c{type_info, reinterpret_cast<uint8_t *>(msg_c)};
+  RosMessage_Cpp cpp{type_info_cpp, reinterpret_cast<uint8_t *>(&msg_cpp)};
+  const auto * type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(test_msgs, msg, UnboundedSequences);
+  const auto * type_support_cpp =
+    rosidl_typesupport_cpp::get_message_type_support_handle<test_msgs::msg::UnboundedSequences>();
+
+  // With one byte and one char, the lengths of float64_values and uint64_values end 4 bytes past a
+  // multiple of 8
+  rosidl_runtime_c__octet__Sequence__init(&msg_c->byte_values, 1);
+  rosidl_runtime_c__uint8__Sequence__init(&msg_c->char_values, 1);
+  msg_cpp.byte_values = {0x12};
+  msg_cpp.char_values = {'a'};
+  EXPECT_EQ(rmw_serialized_size(msg_c, type_support), dynmsg::c::serialized_size(c));
+  EXPECT_EQ(rmw_serialized_size(&msg_cpp, type_support_cpp), dynmsg::cpp::serialized_size(cpp));
+
+  // And with one more byte, the length of int64_values does
+  rosidl_runtime_c__uint8__Sequence__init(&msg_c->uint8_values, 1);
+  msg_cpp.uint8_values = {200};
+  EXPECT_EQ(rmw_serialized_size(msg_c, type_support), dynmsg::c::serialized_size(c));
+  EXPECT_EQ(rmw_serialized_size(&msg_cpp, type_support_cpp), dynmsg::cpp::serialized_size(cpp));
+
+  test_msgs__msg__UnboundedSequences__destroy(msg_c);
+}
@@ -0,0 +1,192 @@
+// Copyright 2021 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Round trips of generated messages of every message type of the installed packages, found through
+// the ament index: each message is read from the C layout to YAML, parsed to the C++ layout, and
+// read again, and both the parsed message and its YAML must match the original. The throughput of
+// the round trips of each type is recorded as a property of its test, and summarized at the end.
+//
+// The number of timed round trips of each type can be set with the
+// DYNMSG_ROUND_TRIP_ITERATIONS environment variable.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ament_index_cpp/get_resource.hpp"
+#include "ament_index_cpp/get_resources.hpp"
+
+#include "dynmsg/config.hpp"
+#include "dynmsg/dynamic_message.hpp"
+#include "dynmsg/message_comparison.hpp"
+#include "dynmsg/message_generation.hpp"
+#include "dynmsg/message_reading.hpp"
+#include "dynmsg/msg_parser.hpp"
+#include "dynmsg/typesupport.hpp"
+#include "dynmsg/yaml_utils.hpp"
+
+namespace
+{
+
+// Get the message types of all the packages of the ament index
+std::vector<InterfaceTypeName> get_message_types()
+{
+  std::vector<InterfaceTypeName> types;
+  for (const auto & package : ament_index_cpp::get_resources("rosidl_interfaces")) {
+    std::string content;
+    if (!ament_index_cpp::get_resource("rosidl_interfaces", package.first, content)) {
+      continue;
+    }
+    // One interface file per line, e.g. "msg/Header.idl" and "msg/Header.msg"
+    std::istringstream lines(content);
+    std::string line;
+    const std::string prefix = "msg/";
+    const std::string suffix = ".idl";
+    while (std::getline(lines, line)) {
+      if (line.size() > prefix.size() + suffix.size() &&
+        0 == line.compare(0, prefix.size(), prefix) &&
+        0 == line.compare(line.size() - suffix.size(), suffix.size(), suffix))
+      {
+        types.emplace_back(
+          package.first,
+          line.substr(prefix.size(), line.size() - prefix.size() - suffix.size()));
+      }
+    }
+  }
+  std::sort(types.begin(), types.end());
+  return types;
+}
+
+size_t get_iterations()
+{
+  const char * iterations = std::getenv("DYNMSG_ROUND_TRIP_ITERATIONS");
+  return nullptr == iterations ? 20u : std::strtoul(iterations, nullptr, 10);
+}
+
+// Throughput of the round trips of a type
+struct Throughput
+{
+  double messages_per_second;
+  double yaml_bytes_per_second;
+};
+
+// A round trip from the C layout to the C++ layout, through YAML
+struct RoundTrip
+{
+  std::string yaml;
+  dynmsg::cpp::DynamicMessage parsed;
+  std::string parsed_yaml;
+};
+
+RoundTrip round_trip(const RosMessage & message, const TypeInfo_Cpp * type_info_cpp)
+{
+  RoundTrip result;
+  result.yaml = dynmsg::yaml_to_string(dynmsg::c::message_to_yaml(message));
+  result.parsed = dynmsg::cpp::DynamicMessage(type_info_cpp);
+  dynmsg::cpp::yaml_and_typeinfo_to_rosmsg(type_info_cpp, result.yaml, result.parsed.data());
+  result.parsed_yaml = dynmsg::yaml_to_string(dynmsg::cpp::message_to_yaml(result.parsed.get()));
+  return result;
+}
+
+}  // namespace
+
+class TestRoundTripMatrix : public ::testing::TestWithParam<InterfaceTypeName>
+{
+protected:
+  static void TearDownTestSuite()
+  {
+    if (throughputs.empty()) {
+      return;
+    }
+    std::cout << std::left << std::setw(56) << "type" << std::right << std::setw(14) <<
+      "messages/s" << std::setw(14) << "YAML MB/s" << '\n' << std::fixed << std::setprecision(1);
+    for (const auto & throughput : throughputs) {
+      std::cout << std::left << std::setw(56) << throughput.first << std::right <<
+        std::setw(14) << throughput.second.messages_per_second << std::setw(14) <<
+        throughput.second.yaml_bytes_per_second / 1e6 << '\n';
+    }
+  }
+
+  // Throughput of each type, by "package/Type"
+  static std::map<std::string, Throughput> throughputs;
+};
+
+std::map<std::string, Throughput> TestRoundTripMatrix::throughputs;
+
+TEST_P(TestRoundTripMatrix, c_to_yaml_to_cpp)
+{
+#ifndef DYNMSG_VALUE_ONLY
+  GTEST_SKIP() << "the YAML of messages can only be parsed back with DYNMSG_VALUE_ONLY";
+#endif
+  const InterfaceTypeName & interface_type = GetParam();
+  const std::string name = interface_type.first + "/" + interface_type.second;
+  const TypeInfo * type_info = dynmsg::c::get_type_info(interface_type);
+  const TypeInfo_Cpp * type_info_cpp = dynmsg::cpp::get_type_info(interface_type);
+  if (nullptr == type_info || nullptr == type_info_cpp) {
+    GTEST_SKIP() << "no introspection type support for " << name;
+  }
+
+  dynmsg::c::DynamicMessage message(type_info);
+  dynmsg::cpp::DynamicMessage expected(type_info_cpp);
+  RosMessage message_view = message.get();
+  RosMessage_Cpp expected_view = expected.get();
+  dynmsg::GenerationOptions options;
+  for (options.seed = 0; options.seed < 3; ++options.seed) {
+    // The C and C++ messages generated with the same options have the same content
+    dynmsg::c::generate_message(message_view, options);
+    dynmsg::cpp::generate_message(expected_view, options);
+    const RoundTrip result = round_trip(message.get(), type_info_cpp);
+    EXPECT_TRUE(dynmsg::cpp::equals(result.parsed.get(), expected.get())) <<
+      "seed " << options.seed << ", YAML:\n" << result.yaml;
+    EXPECT_EQ(result.yaml, result.parsed_yaml) << "seed " << options.seed;
+  }
+
+  const size_t iterations = get_iterations();
+  if (0u == iterations) {
+    return;
+  }
+  size_t yaml_bytes = 0u;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t ii = 0; ii < iterations; ++ii) {
+    yaml_bytes += round_trip(message.get(), type_info_cpp).yaml.size();
+  }
+  const double seconds =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const Throughput throughput{
+    static_cast<double>(iterations) / seconds, static_cast<double>(yaml_bytes) / seconds};
+  throughputs[name] = throughput;
+  RecordProperty(
+    "messages_per_second",
+    std::to_string(static_cast<uint64_t>(throughput.messages_per_second)));
+  RecordProperty(
+    "yaml_bytes_per_second",
+    std::to_string(static_cast<uint64_t>(throughput.yaml_bytes_per_second)));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+  InstalledTypes,
+  TestRoundTripMatrix,
+  ::testing::ValuesIn(get_message_types()),
+  [](const ::testing::TestParamInfo<InterfaceTypeName> & info) {
+    return info.param.first + "__" + info.param.second;
+  });